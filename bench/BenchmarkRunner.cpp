@@ -0,0 +1,133 @@
+#include "BenchmarkRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+
+namespace {
+    // Discards everything written to it
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+    };
+
+    std::string escapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+BenchmarkRunner::BenchmarkRunner(const Settings& settings)
+    : M_Settings(settings)
+{
+    M_Settings.repetitions = std::max(1, M_Settings.repetitions);
+}
+
+double BenchmarkRunner::timeBatch(const Body& body, uint64_t iterations) const
+{
+    static NullBuffer nullBuffer;
+    std::streambuf* previous = std::cout.rdbuf(&nullBuffer);
+    auto start = std::chrono::high_resolution_clock::now();
+    body(iterations);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout.rdbuf(previous);
+    return elapsedMs;
+}
+
+void BenchmarkRunner::Run(const std::string& name, const Body& body, double itemsPerIteration)
+{
+    if (!M_Settings.filter.empty() && name.find(M_Settings.filter) == std::string::npos)
+        return;
+
+    // Grow the batch until it is long enough to time reliably (the first batches also warm up)
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        double elapsedMs = timeBatch(body, iterations);
+        if (elapsedMs >= M_Settings.minBatchMs || iterations >= (1ull << 40))
+            break;
+        // Aim a little past the target, at most 10x per step
+        double scale = elapsedMs > 0.0 ? M_Settings.minBatchMs * 1.2 / elapsedMs : 10.0;
+        iterations = std::max(iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 10.0)));
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < M_Settings.repetitions; ++i)
+        samples.push_back(timeBatch(body, iterations) * 1.0e6 / iterations);
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+    result.meanNs = sum / samples.size();
+    result.medianNs = samples.size() % 2 ? samples[samples.size() / 2]
+                                         : 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+    result.minNs = samples.front();
+    double variance = 0.0;
+    for (double sample : samples)
+        variance += (sample - result.meanNs) * (sample - result.meanNs);
+    result.stddevNs = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+    if (itemsPerIteration > 0.0 && result.medianNs > 0.0)
+        result.itemsPerSecond = itemsPerIteration * 1.0e9 / result.medianNs;
+
+    std::cerr << "  " << name << ": " << result.medianNs << " ns" << std::endl; // Progress
+    M_Results.push_back(result);
+}
+
+void BenchmarkRunner::PrintTable(std::ostream& out) const
+{
+    out << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(14) << "Median ns" << std::setw(14)
+        << "Min ns" << std::setw(12) << "Stddev %" << std::setw(14) << "Iterations" << std::setw(16) << "Items/s" << "\n";
+    for (const Result& result : M_Results)
+    {
+        out << std::left << std::setw(44) << result.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(14) << result.medianNs << std::setw(14) << result.minNs << std::setw(12)
+            << (result.meanNs > 0.0 ? 100.0 * result.stddevNs / result.meanNs : 0.0) << std::setw(14) << result.iterations;
+        if (result.itemsPerSecond > 0.0)
+            out << std::setw(16) << std::scientific << std::setprecision(3) << result.itemsPerSecond;
+        out << std::defaultfloat << "\n";
+    }
+}
+
+void BenchmarkRunner::WriteJson(std::ostream& out) const
+{
+    char date[32] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << std::setprecision(6) << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"build\": \"release\",\n"
+#else
+        << "    \"build\": \"debug\",\n"
+#endif
+        << "    \"repetitions\": " << M_Settings.repetitions << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < M_Results.size(); ++i)
+    {
+        const Result& result = M_Results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escapeJson(result.name) << "\", \"iterations\": " << result.iterations
+            << ", \"mean_ns\": " << result.meanNs << ", \"median_ns\": " << result.medianNs << ", \"min_ns\": " << result.minNs
+            << ", \"stddev_ns\": " << result.stddevNs;
+        if (result.itemsPerSecond > 0.0)
+            out << ", \"items_per_second\": " << result.itemsPerSecond;
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Minimal microbenchmark harness (no external dependency).
+// A benchmark body runs its work `iterations` times. The runner grows the iteration count
+// until one batch takes a measurable time, then times several batches and reports per
+// iteration statistics over them. std::cout is silenced while bodies run, so code that
+// logs (maze generation, PrintToConsole) can be measured without flooding the output.
+class BenchmarkRunner {
+public:
+    using Body = std::function<void(uint64_t iterations)>;
+
+    struct Settings {
+        double minBatchMs = 20.0;  // Calibrate iterations until a batch takes this long
+        int repetitions = 10;      // Timed batches per benchmark
+        std::string filter;        // Only run benchmarks whose name contains this
+    };
+
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0;   // Per batch
+        double meanNs = 0.0;       // Per iteration, over the batches
+        double medianNs = 0.0;
+        double minNs = 0.0;
+        double stddevNs = 0.0;
+        double itemsPerSecond = 0.0; // Only if the benchmark declared items per iteration
+    };
+
+    explicit BenchmarkRunner(const Settings& settings);
+
+    // itemsPerIteration > 0 also reports a throughput (e.g. cells per second)
+    void Run(const std::string& name, const Body& body, double itemsPerIteration = 0.0);
+
+    const std::vector<Result>& GetResults() const { return M_Results; }
+
+    void PrintTable(std::ostream& out) const;
+    // {"context": {...}, "benchmarks": [{"name": ..., "iterations": ..., "mean_ns": ...}, ...]}
+    void WriteJson(std::ostream& out) const;
+
+private:
+    Settings M_Settings;
+    std::vector<Result> M_Results;
+
+    double timeBatch(const Body& body, uint64_t iterations) const;
+};
+
+// Keeps the compiler from discarding a computed value
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    // Publishing the address makes the value observable
+    static volatile const void* sink;
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
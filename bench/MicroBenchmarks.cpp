@@ -0,0 +1,253 @@
+// Microbenchmarks for the CPU hot paths of the game (no window or GL context needed).
+// Options:
+//   --json FILE          also write the results as JSON ("-" for stdout, replacing the table)
+//   --filter TEXT        only run benchmarks whose name contains TEXT
+//   --repetitions N      timed batches per benchmark (default 10)
+//   --min-batch-ms X     minimum duration of one batch (default 20)
+#include "BenchmarkRunner.h"
+#include "../src/Game/Maze.h"
+#include "../src/Game/MazeText.h"
+#include "../src/Game/MazeImage.h"
+#include "../src/Game/Player.h"
+#include "../src/Graphics/camera.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    const unsigned int SEED = 1;
+    const float WALL_HEIGHT = 2.0f;
+    const float WALL_THICKNESS = 0.1f;
+
+    void addMazeBenchmarks(BenchmarkRunner& runner) {
+        for (int size : { 8, 32, 128, 512 })
+        {
+            runner.Run("Maze/GenerateMaze/" + std::to_string(size), [size](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    Maze maze(size, size, SEED + static_cast<unsigned int>(i));
+                    maze.GenerateMaze(0, 0);
+                    DoNotOptimize(maze.GetCell(size - 1, size - 1));
+                }
+            }, static_cast<double>(size) * size);
+        }
+
+        // Random lookups over a large maze, so the row vectors don't all stay in L1
+        const int size = 256;
+        Maze maze(size, size, SEED);
+        maze.GenerateMaze(0, 0);
+        std::vector<glm::ivec2> cells(4096);
+        std::mt19937 rng(SEED);
+        std::uniform_int_distribution<int> coordinate(0, size - 1);
+        for (glm::ivec2& cell : cells)
+            cell = glm::ivec2(coordinate(rng), coordinate(rng));
+
+        runner.Run("Maze/GetCell/256", [&](uint64_t iterations) {
+            int walls = 0;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                const glm::ivec2& cell = cells[i & (cells.size() - 1)];
+                walls += maze.GetCell(cell.x, cell.y).wallTop ? 1 : 0;
+            }
+            DoNotOptimize(walls);
+        }, 1.0);
+
+        runner.Run("Maze/GetEndCellCoords/256", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                glm::ivec2 end = maze.GetEndCellCoords();
+                DoNotOptimize(end);
+            }
+        });
+
+        runner.Run("Maze/BuildWallMask/256", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                std::vector<unsigned char> mask = maze.BuildWallMask();
+                DoNotOptimize(mask.data());
+            }
+        }, static_cast<double>(size) * size);
+
+        // Output goes to a discarding stream, so this is the formatting cost
+        Maze printed(32, 32, SEED);
+        printed.GenerateMaze(0, 0);
+        runner.Run("Maze/PrintToConsole/32", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+                printed.PrintToConsole(glm::ivec2(16, 16));
+        }, 32.0 * 32.0);
+
+        // Text export and import of a large maze, as bytes per second
+        Maze large(1024, 1024, SEED);
+        large.GenerateMaze(0, 0);
+        std::ostringstream exported;
+        WriteMazeText(large, exported);
+        const std::string text = exported.str();
+        runner.Run("Maze/WriteMazeText/1024", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                std::ostringstream out;
+                WriteMazeText(large, out);
+                DoNotOptimize(out.tellp());
+            }
+        }, static_cast<double>(text.size()));
+        runner.Run("Maze/ReadMazeText/1024", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                std::istringstream in(text);
+                std::unique_ptr<Maze> loaded = ReadMazeText(in);
+                DoNotOptimize(loaded.get());
+            }
+        }, static_cast<double>(text.size()));
+
+        // PNG export with the solution, as pixels per second; one untimed export gives the image size
+        MazeImageSettings imageSettings;
+        MazeImageStats imageStats;
+        std::ostringstream image;
+        WriteMazeImage(large, image, MazeImageFormat::PNG, imageSettings, &imageStats);
+        runner.Run("Maze/WriteMazeImage/1024", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                std::ostringstream out;
+                WriteMazeImage(large, out, MazeImageFormat::PNG, imageSettings);
+                DoNotOptimize(out.tellp());
+            }
+        }, static_cast<double>(imageStats.width) * imageStats.height);
+    }
+
+    void addPlayerBenchmarks(BenchmarkRunner& runner) {
+        const int size = 32;
+        Maze maze(size, size, SEED);
+        maze.GenerateMaze(0, 0);
+
+        // Positions anywhere in the maze: a mix of free space and wall contacts
+        std::vector<glm::vec3> positions(1024);
+        std::mt19937 rng(SEED);
+        std::uniform_real_distribution<float> coordinate(0.0f, static_cast<float>(size));
+        for (glm::vec3& position : positions)
+            position = glm::vec3(coordinate(rng), 1.0f, coordinate(rng));
+
+        Camera camera(glm::vec3(0.5f, 1.0f, 0.5f));
+        Player player(camera);
+        runner.Run("Player/CheckCollision", [&](uint64_t iterations) {
+            int collisions = 0;
+            for (uint64_t i = 0; i < iterations; ++i)
+                collisions += player.CheckCollision(positions[i & (positions.size() - 1)], maze) ? 1 : 0;
+            DoNotOptimize(collisions);
+        }, 1.0);
+
+        // Walking at 60 fps while turning, so moves alternate between free steps and wall slides
+        runner.Run("Player/ProcessKeyboard", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                if ((i & 63) == 0)
+                {
+                    camera.Yaw += 37.0f;
+                    camera.UpdateCameraVectors();
+                }
+                player.ProcessKeyboard(FORWARD, 1.0f / 60.0f, maze);
+            }
+            DoNotOptimize(camera.Position);
+        }, 1.0);
+    }
+
+    // The CPU work of the original per-wall draw loop: one translate/scale model matrix per wall
+    // (cells own their top and left walls, the last row/column also their bottom/right walls)
+    void addRenderBenchmarks(BenchmarkRunner& runner) {
+        for (int size : { 8, 64 })
+        {
+            auto maze = std::make_shared<Maze>(size, size, SEED);
+            maze->GenerateMaze(0, 0);
+            size_t wallCount = 0;
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    const Cell& cell = maze->GetCell(x, y);
+                    wallCount += (cell.wallTop ? 1 : 0) + (cell.wallLeft ? 1 : 0) + (cell.wallBottom && y == size - 1 ? 1 : 0) +
+                                 (cell.wallRight && x == size - 1 ? 1 : 0);
+                }
+            }
+
+            auto models = std::make_shared<std::vector<glm::mat4>>();
+            models->reserve(wallCount);
+            runner.Run("Render/WallModelMatrices/" + std::to_string(size), [maze, models, size](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    models->clear();
+                    for (int y = 0; y < size; ++y)
+                    {
+                        for (int x = 0; x < size; ++x)
+                        {
+                            const Cell& cell = maze->GetCell(x, y);
+                            glm::vec3 cellOrigin((float)x, 0.0f, (float)y);
+                            if (cell.wallTop)
+                                models->push_back(glm::scale(glm::translate(glm::mat4(1.0f), cellOrigin + glm::vec3(0.5f, WALL_HEIGHT / 2.0f, 0.0f)),
+                                                             glm::vec3(1.0f, WALL_HEIGHT, WALL_THICKNESS)));
+                            if (cell.wallBottom && y == size - 1)
+                                models->push_back(glm::scale(glm::translate(glm::mat4(1.0f), cellOrigin + glm::vec3(0.5f, WALL_HEIGHT / 2.0f, 1.0f)),
+                                                             glm::vec3(1.0f, WALL_HEIGHT, WALL_THICKNESS)));
+                            if (cell.wallLeft)
+                                models->push_back(glm::scale(glm::translate(glm::mat4(1.0f), cellOrigin + glm::vec3(0.0f, WALL_HEIGHT / 2.0f, 0.5f)),
+                                                             glm::vec3(WALL_THICKNESS, WALL_HEIGHT, 1.0f)));
+                            if (cell.wallRight && x == size - 1)
+                                models->push_back(glm::scale(glm::translate(glm::mat4(1.0f), cellOrigin + glm::vec3(1.0f, WALL_HEIGHT / 2.0f, 0.5f)),
+                                                             glm::vec3(WALL_THICKNESS, WALL_HEIGHT, 1.0f)));
+                        }
+                    }
+                    DoNotOptimize(models->data());
+                }
+            }, static_cast<double>(wallCount));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner::Settings settings;
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc) settings.filter = argv[++i];
+        else if (arg == "--repetitions" && i + 1 < argc) settings.repetitions = std::atoi(argv[++i]);
+        else if (arg == "--min-batch-ms" && i + 1 < argc) settings.minBatchMs = std::atof(argv[++i]);
+        else std::cerr << "Unknown option: " << arg << std::endl;
+    }
+
+    BenchmarkRunner runner(settings);
+    std::cerr << "Running benchmarks..." << std::endl;
+    // Setup logging (maze generation) goes to stderr, so stdout only carries the results
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+    addMazeBenchmarks(runner);
+    addPlayerBenchmarks(runner);
+    addRenderBenchmarks(runner);
+    std::cout.rdbuf(stdoutBuffer);
+
+    if (jsonPath == "-")
+    {
+        runner.WriteJson(std::cout);
+        return 0;
+    }
+    runner.PrintTable(std::cout);
+    if (!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath);
+        if (!file)
+        {
+            std::cerr << "Failed to write " << jsonPath << std::endl;
+            return 1;
+        }
+        runner.WriteJson(file);
+        std::cout << "Wrote " << jsonPath << std::endl;
+    }
+    return 0;
+}
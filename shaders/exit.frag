@@ -1,12 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-
-in vec2 TexCoord;
-
-uniform sampler2D exitTexture;
-uniform vec3 color;
-
-void main()
-{
-    FragColor = texture(exitTexture, TexCoord) * vec4(color, 1.0);
-}
\ No newline at end of file
@@ -0,0 +1,267 @@
+#version 330 core
+// Feature switches (SPECULAR, CEILING, INSTANCED, UNLIT, POINT_LIGHTS, BAKED_LIGHTING, SHADOWS,
+// IMPOSTOR) are #defined by ShaderVariants
+out vec4 FragColor;
+
+#ifdef IMPOSTOR
+// Far LOD (see MazeMesh): the chunk is drawn as its bounding box, and the walls inside it are
+// found by marching the view ray through the wall mask cell by cell. The hit takes the place
+// of the interpolated inputs below, and sets the fragment depth.
+in vec3 BoxPos;
+flat in vec2 ImpostorChunk;
+uniform usampler2D wallMask; // WallBits per cell (Maze::BuildWallMask)
+uniform vec4 impostorGrid;   // xy: maze size in cells, z: chunk size in cells, w: wall height
+vec3 FragPos;
+vec3 Normal;
+vec2 TexCoords;
+#else
+#ifndef UNLIT
+in vec3 FragPos;   // Interpolated fragment position in world space
+#ifndef CEILING
+in vec3 Normal;    // Interpolated normal in world space
+#endif
+#endif
+in vec2 TexCoords;
+#endif
+flat in int Layer; // Material, also the layer in materialTextures
+
+// All maze surface textures, one layer per material (see MaterialLibrary)
+uniform sampler2DArray materialTextures;
+
+#ifndef UNLIT
+// Light and camera properties, shared by all programs (updated once per frame)
+layout (std140) uniform Lighting {
+    vec4 light_direction; // xyz: direction the light travels (directional light)
+    vec4 light_color;     // rgb: light color, a: ambient intensity
+    vec4 light_time;      // x: seconds, drives the point light flicker
+    mat4 shadow_space;    // World to shadow map coordinates and depth, all in [0, 1] (see ShadowMap)
+};
+#endif
+
+#if defined(POINT_LIGHTS) && !defined(UNLIT)
+// Clustered point lights (see LightSystem): the fragment's world-space cluster lists the
+// lights that reach it
+uniform samplerBuffer lightData;      // Two texels per light: position, radius; color * intensity, flicker
+uniform usamplerBuffer lightClusters; // Per cluster: offset into lightIndices, light count
+uniform usamplerBuffer lightIndices;
+uniform vec3 clusterCounts;           // Clusters along x, y (slices) and z
+uniform vec3 clusterSize;             // World size of one cluster
+#endif
+
+#if defined(BAKED_LIGHTING) && !defined(UNLIT)
+// Static lighting baked per maze (see LightBaker), sampled by world position
+uniform sampler3D bakedLight;     // rgb: static point light irradiance
+uniform sampler3D bakedOcclusion; // Ambient occlusion for faces along x, y, z
+uniform vec3 bakedLightScale;     // World position to volume coordinates
+uniform float bakedLightOffset;   // Distance off the surface to sample at
+#endif
+
+#if defined(SHADOWS) && !defined(UNLIT)
+// Directional light shadows (see ShadowMap)
+uniform sampler2DShadow shadowMap;
+#endif
+
+#if !defined(UNLIT) || defined(IMPOSTOR)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // Camera position in world space (xyz)
+};
+#endif
+
+#ifdef SPECULAR
+// Per-material constants: x = shininess, y = specular strength
+uniform vec4 materials[16];
+#endif
+
+#ifdef IMPOSTOR
+const uint WALL_TOP = 1u, WALL_RIGHT = 2u, WALL_BOTTOM = 4u, WALL_LEFT = 8u; // WallBits
+
+// Walls by grid line, as Maze::HasVerticalWall/HasHorizontalWall: a line's wall is stored in the
+// cell after it, the bottom and right borders in the last row and column
+bool verticalWall(int lineX, int y) {
+    int width = int(impostorGrid.x);
+    if (lineX < width)
+        return (texelFetch(wallMask, ivec2(lineX, y), 0).r & WALL_LEFT) != 0u;
+    return (texelFetch(wallMask, ivec2(width - 1, y), 0).r & WALL_RIGHT) != 0u;
+}
+
+bool horizontalWall(int x, int lineY) {
+    int height = int(impostorGrid.y);
+    if (lineY < height)
+        return (texelFetch(wallMask, ivec2(x, lineY), 0).r & WALL_TOP) != 0u;
+    return (texelFetch(wallMask, ivec2(x, height - 1), 0).r & WALL_BOTTOM) != 0u;
+}
+
+// A wall at the given position, facing along normal; texture coordinates as on the wall planes
+void impostorHit(vec3 position, vec3 normal) {
+    FragPos = position;
+    Normal = normal;
+    TexCoords = vec2(normal.x != 0.0 ? position.z : position.x, position.y / impostorGrid.w);
+    vec4 clip = projection * view * vec4(position, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
+
+// Steps the view ray through the chunk's cells (a 2D DDA over the grid lines) and records the
+// first wall it meets; false if it leaves the chunk without one
+bool marchImpostor() {
+    vec3 origin = viewPos.xyz;
+    vec3 dir = normalize(BoxPos - origin);
+    dir = mix(dir, vec3(1e-6), equal(dir, vec3(0.0))); // Axis-aligned rays: no division by zero
+    vec3 invDir = 1.0 / dir;
+
+    vec2 chunkMin = ImpostorChunk * impostorGrid.z;
+    vec2 chunkMax = min(chunkMin + impostorGrid.z, impostorGrid.xy);
+    vec3 t0 = (vec3(chunkMin.x, 0.0, chunkMin.y) - origin) * invDir;
+    vec3 t1 = (vec3(chunkMax.x, impostorGrid.w, chunkMax.y) - origin) * invDir;
+    vec3 tNear = min(t0, t1);
+    vec3 tFar = max(t0, t1);
+    float tEnter = max(max(tNear.x, tNear.y), max(tNear.z, 0.0));
+    float tExit = min(min(tFar.x, tFar.y), tFar.z);
+    // From outside only the faces towards the camera march; the back faces would find the same hit
+    if (tEnter > 0.0 && dot(BoxPos - origin, dir) > tEnter + 0.01)
+        return false;
+
+    ivec2 cellMin = ivec2(chunkMin);
+    ivec2 cellMax = ivec2(chunkMax) - 1;
+    vec3 start = origin + dir * tEnter;
+    ivec2 cell = clamp(ivec2(floor(start.xz)), cellMin, cellMax);
+    ivec2 stepDir = ivec2(sign(dir.xz));
+
+    // Entering through a side of the box: the chunk's border line there may hold a wall
+    if (tEnter > 0.0 && tEnter == tNear.x && verticalWall(stepDir.x > 0 ? cellMin.x : cellMax.x + 1, cell.y))
+    {
+        impostorHit(start, vec3(-float(stepDir.x), 0.0, 0.0));
+        return true;
+    }
+    if (tEnter > 0.0 && tEnter == tNear.z && horizontalWall(cell.x, stepDir.y > 0 ? cellMin.y : cellMax.y + 1))
+    {
+        impostorHit(start, vec3(0.0, 0.0, -float(stepDir.y)));
+        return true;
+    }
+
+    // Ray distance to the next vertical (x) and horizontal (z) grid line, and between lines
+    vec2 lineT = (vec2(cell + max(stepDir, ivec2(0))) - origin.xz) * invDir.xz;
+    vec2 lineStep = abs(invDir.xz);
+    for (int i = 2 * int(impostorGrid.z) + 2; i > 0; --i)
+    {
+        if (min(lineT.x, lineT.y) > tExit + 1e-4)
+            break; // Left through the top or bottom, or past the far side
+        if (lineT.x < lineT.y)
+        {
+            if (verticalWall(cell.x + max(stepDir.x, 0), cell.y))
+            {
+                impostorHit(origin + dir * lineT.x, vec3(-float(stepDir.x), 0.0, 0.0));
+                return true;
+            }
+            cell.x += stepDir.x;
+            lineT.x += lineStep.x;
+            if (cell.x < cellMin.x || cell.x > cellMax.x)
+                break;
+        }
+        else
+        {
+            if (horizontalWall(cell.x, cell.y + max(stepDir.y, 0)))
+            {
+                impostorHit(origin + dir * lineT.y, vec3(0.0, 0.0, -float(stepDir.y)));
+                return true;
+            }
+            cell.y += stepDir.y;
+            lineT.y += lineStep.y;
+            if (cell.y < cellMin.y || cell.y > cellMax.y)
+                break;
+        }
+    }
+    return false;
+}
+#endif
+
+void main() {
+#ifdef IMPOSTOR
+    if (!marchImpostor())
+        discard;
+#endif
+    vec3 textureColor = texture(materialTextures, vec3(TexCoords, float(Layer))).rgb;
+#ifdef UNLIT
+    FragColor = vec4(textureColor, 1.0); // e.g. the exit marker
+#else
+
+#ifdef CEILING
+    // Horizontal plane, lit with the same +Y normal the ceiling always used. Seen from below a
+    // +Y normal never reflects the light towards the camera, so there is no specular term.
+    const vec3 norm = vec3(0.0, 1.0, 0.0);
+#else
+    vec3 norm = normalize(Normal);
+    // Mid LOD wall planes are single quads seen from both sides: light the side in view
+    if (dot(norm, viewPos.xyz - FragPos) < 0.0)
+        norm = -norm;
+#endif
+    vec3 lightDir = normalize(-light_direction.xyz); // Directional light
+
+    // Ambient
+    vec3 ambient = light_color.a * light_color.rgb;
+#ifdef BAKED_LIGHTING
+    vec3 bakedCoords = (FragPos + norm * bakedLightOffset) * bakedLightScale;
+    vec3 occlusion = texture(bakedOcclusion, bakedCoords).rgb;
+    ambient *= dot(abs(norm), occlusion); // Faces are axis aligned: pick the occlusion of their axis
+#endif
+
+    // Shadowing of the directional light
+    float shadow = 1.0;
+#ifdef SHADOWS
+    // Pushed off the surface a little against acne; four hardware-filtered taps (4x4 PCF)
+    vec4 shadowCoord = shadow_space * vec4(FragPos + norm * 0.02, 1.0);
+    shadow = 0.25 * (textureOffset(shadowMap, shadowCoord.xyz, ivec2(-1, -1)) +
+                     textureOffset(shadowMap, shadowCoord.xyz, ivec2(1, -1)) +
+                     textureOffset(shadowMap, shadowCoord.xyz, ivec2(-1, 1)) +
+                     textureOffset(shadowMap, shadowCoord.xyz, ivec2(1, 1)));
+#endif
+
+    // Diffuse
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = shadow * diff * light_color.rgb;
+
+    vec3 result = (ambient + diffuse) * textureColor;
+#ifdef BAKED_LIGHTING
+    result += texture(bakedLight, bakedCoords).rgb * textureColor;
+#endif
+
+#ifdef SPECULAR
+    // Specular (Phong)
+    vec4 material = materials[Layer];
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.x);
+    result += shadow * material.y * spec * light_color.rgb;
+#endif
+
+#ifdef POINT_LIGHTS
+    ivec3 cluster = ivec3(clamp(floor(FragPos / clusterSize), vec3(0.0), clusterCounts - 1.0));
+    int clusterIndex = (cluster.y * int(clusterCounts.z) + cluster.z) * int(clusterCounts.x) + cluster.x;
+    uvec2 range = texelFetch(lightClusters, clusterIndex).rg;
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec4 colorFlicker = texelFetch(lightData, light * 2 + 1);
+        // Flicker seeded by the light's index, so every torch has its own phase
+        float flicker = sin(light_time.x * 7.0 + float(light) * 1.7) * sin(light_time.x * 3.1 + float(light));
+        vec3 lightColor = colorFlicker.rgb * (1.0 + colorFlicker.a * flicker);
+
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float lightDistance = length(toLight);
+        // Smooth falloff reaching zero at the radius
+        float falloff = clamp(1.0 - (lightDistance * lightDistance) / (positionRadius.w * positionRadius.w), 0.0, 1.0);
+        falloff *= falloff;
+        vec3 pointDir = toLight / max(lightDistance, 0.0001);
+        vec3 pointLight = falloff * max(dot(norm, pointDir), 0.0) * lightColor * textureColor;
+#ifdef SPECULAR
+        pointLight += falloff * material.y * pow(max(dot(viewDir, reflect(-pointDir, norm)), 0.0), material.x) * lightColor;
+#endif
+        result += pointLight;
+    }
+#endif
+
+    FragColor = vec4(result, 1.0);
+#endif
+}
@@ -0,0 +1,57 @@
+#version 330 core
+// Feature switches (SPECULAR, CEILING, INSTANCED, UNLIT, POINT_LIGHTS, BAKED_LIGHTING, SHADOWS,
+// IMPOSTOR) are #defined by ShaderVariants in both stages; this one only uses INSTANCED, UNLIT,
+// CEILING and IMPOSTOR
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in float aLayer;    // Material layer in the texture array
+
+#ifdef INSTANCED
+layout (location = 4) in mat4 aInstanceModel; // One matrix per instance (locations 4-7)
+#define MODEL aInstanceModel
+#else
+uniform mat4 model;
+#define MODEL model
+#endif
+
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // Camera position in world space (xyz)
+};
+
+#ifdef IMPOSTOR
+// Far LOD chunk box (see MazeMesh); maze.frag finds the walls inside it
+out vec3 BoxPos;             // Position on the box in world space
+flat out vec2 ImpostorChunk; // Chunk coordinates, carried in the texture coordinates
+#else
+#ifndef UNLIT
+out vec3 FragPos;       // Fragment position in world space
+#ifndef CEILING
+out vec3 Normal;        // Normal in world space
+#endif
+#endif
+out vec2 TexCoords;
+#endif
+flat out int Layer;
+
+void main() {
+    vec4 worldPos = MODEL * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+#ifdef IMPOSTOR
+    BoxPos = worldPos.xyz;
+    ImpostorChunk = aTexCoords;
+#else
+#ifndef UNLIT
+    FragPos = worldPos.xyz;
+#ifndef CEILING
+    // Model matrices are rigid or uniformly scaled, so the upper 3x3 works as the normal
+    // matrix (the fragment shader renormalizes); no inverse-transpose per vertex
+    Normal = mat3(MODEL) * aNormal;
+#endif
+#endif
+    TexCoords = aTexCoords;
+#endif
+    Layer = int(aLayer + 0.5);
+}
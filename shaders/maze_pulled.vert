@@ -0,0 +1,115 @@
+#version 330 core
+// Maze geometry generated from a wall bitmask, with no vertex buffers (see PulledMaze).
+// One instance per cell of a (width + 1) x (height + 1) grid; the extra row and column only
+// emit the outer bottom/right walls. Each instance has VERTICES_PER_CELL vertices:
+//   0-35   wall along the cell's top edge (box, 6 faces x 2 triangles)
+//   36-71  wall along the cell's left edge
+//   72-77  floor quad
+//   78-83  ceiling quad
+// Vertices of surfaces a cell doesn't have collapse to one point, so their triangles are
+// degenerate and never rasterized. Outputs match maze.vert, so maze.frag shades the result.
+
+uniform usampler2D wallBits; // One texel per cell: WallBits flags (see Maze.h)
+uniform int mazeWidth;
+uniform int mazeHeight;
+uniform float wallHeight;
+uniform float wallThickness;
+uniform int wallLayer;       // Texture array layers (see MaterialLibrary)
+uniform int floorLayer;
+uniform int ceilingLayer;
+
+uniform mat4 model;
+
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // Camera position in world space (xyz)
+};
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out int Layer;
+
+const uint WALL_TOP = 1u;
+const uint WALL_RIGHT = 2u;
+const uint WALL_BOTTOM = 4u;
+const uint WALL_LEFT = 8u;
+
+// Box faces: normal, then two edge directions with cross(u, v) = normal
+const vec3 FACE_NORMAL[6] = vec3[6](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 FACE_U[6] = vec3[6](vec3(0, 0, -1), vec3(0, 0, 1), vec3(1, 0, 0), vec3(1, 0, 0), vec3(1, 0, 0), vec3(-1, 0, 0));
+const vec3 FACE_V[6] = vec3[6](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 0, -1), vec3(0, 0, 1), vec3(0, 1, 0), vec3(0, 1, 0));
+
+// Two triangles per quad, as corners of the unit square
+const vec2 QUAD_CORNER[6] = vec2[6](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+uint cellBits(int x, int y) {
+    return texelFetch(wallBits, ivec2(x, y), 0).r;
+}
+
+void main() {
+    int cellX = gl_InstanceID % (mazeWidth + 1);
+    int cellY = gl_InstanceID / (mazeWidth + 1);
+    int vertex = gl_VertexID;
+    bool inside = cellX < mazeWidth && cellY < mazeHeight;
+
+    // Which walls this instance draws. Like MazeMesh, cells own their top and left walls; the
+    // extra row/column take the bottom/right walls of the last row/column.
+    bool topWall = false;
+    bool leftWall = false;
+    if (inside) {
+        uint bits = cellBits(cellX, cellY);
+        topWall = (bits & WALL_TOP) != 0u;
+        leftWall = (bits & WALL_LEFT) != 0u;
+    } else if (cellY == mazeHeight && cellX < mazeWidth) {
+        topWall = (cellBits(cellX, mazeHeight - 1) & WALL_BOTTOM) != 0u;
+    } else if (cellX == mazeWidth && cellY < mazeHeight) {
+        leftWall = (cellBits(mazeWidth - 1, cellY) & WALL_RIGHT) != 0u;
+    }
+
+    vec2 corner = QUAD_CORNER[vertex % 6];
+    vec3 position;
+    vec3 normal;
+    vec2 uv = corner;
+    int layer = wallLayer;
+    bool present;
+
+    if (vertex < 72) {
+        // Wall box
+        bool isTop = vertex < 36;
+        present = isTop ? topWall : leftWall;
+        int face = (vertex % 36) / 6;
+        vec3 center = isTop ? vec3(cellX + 0.5, wallHeight * 0.5, cellY)
+                            : vec3(cellX, wallHeight * 0.5, cellY + 0.5);
+        vec3 size = isTop ? vec3(1.0, wallHeight, wallThickness)
+                          : vec3(wallThickness, wallHeight, 1.0);
+        normal = FACE_NORMAL[face];
+        vec3 local = 0.5 * normal + (corner.x - 0.5) * FACE_U[face] + (corner.y - 0.5) * FACE_V[face];
+        position = center + local * size;
+    } else {
+        // Floor or ceiling: one texture repeat per cell, same as MazeMesh (UV = world xz)
+        bool isFloor = vertex < 78;
+        present = inside;
+        layer = isFloor ? floorLayer : ceilingLayer;
+        normal = vec3(0.0, 1.0, 0.0); // The ceiling keeps +Y as well, see maze.frag
+        position = vec3(cellX + corner.x, isFloor ? 0.0 : wallHeight, cellY + corner.y);
+        uv = position.xz;
+    }
+
+    if (!present) {
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0); // Degenerate
+        FragPos = vec3(0.0);
+        Normal = normal;
+        TexCoords = vec2(0.0);
+        Layer = layer;
+        return;
+    }
+
+    vec4 worldPos = model * vec4(position, 1.0);
+    gl_Position = projection * view * worldPos;
+    FragPos = worldPos.xyz;
+    Normal = mat3(model) * normal;
+    TexCoords = uv;
+    Layer = layer;
+}
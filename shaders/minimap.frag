@@ -0,0 +1,84 @@
+#version 330 core
+// Top-down map of the maze, one texelFetch per pixel (see Minimap).
+// Row 0 of the maze is at the top, so +z in the world points down on the map.
+
+in vec2 TexCoord;
+
+out vec4 FragColor;
+
+uniform usampler2D cells;   // One texel per cell: WallBits flags (see Maze.h) | EXPLORED
+uniform int mazeWidth;
+uniform int mazeHeight;
+uniform vec4 viewRect;      // Cells covered by the quad: x, y of its top-left corner, width, height
+uniform vec2 playerPosition; // World x/z, in cells
+uniform vec2 playerFront;
+uniform vec2 exitCell;
+uniform float pixelsPerCell;
+uniform int revealAll;
+
+const uint WALL_TOP = 1u;
+const uint WALL_RIGHT = 2u;
+const uint WALL_BOTTOM = 4u;
+const uint WALL_LEFT = 8u;
+const uint EXPLORED = 16u;
+
+const vec4 BACKGROUND_COLOR = vec4(0.0, 0.0, 0.0, 0.6);
+const vec4 UNEXPLORED_COLOR = vec4(0.05, 0.05, 0.08, 0.75);
+const vec4 FLOOR_COLOR = vec4(0.25, 0.25, 0.3, 0.85);
+const vec4 WALL_COLOR = vec4(0.9, 0.9, 0.85, 1.0);
+const vec4 EXIT_COLOR = vec4(0.2, 0.9, 0.3, 1.0);
+const vec4 PLAYER_COLOR = vec4(1.0, 0.3, 0.2, 1.0);
+const vec4 BORDER_COLOR = vec4(0.6, 0.6, 0.6, 1.0);
+
+// Distance from p to the segment a-b
+float segmentDistance(vec2 p, vec2 a, vec2 b)
+{
+    vec2 ab = b - a;
+    float t = clamp(dot(p - a, ab) / dot(ab, ab), 0.0, 1.0);
+    return length(p - (a + t * ab));
+}
+
+void main()
+{
+    vec2 cellPos = viewRect.xy + vec2(TexCoord.x, 1.0 - TexCoord.y) * viewRect.zw;
+    float pixel = 1.0 / pixelsPerCell; // One screen pixel, in cells
+
+    // Frame around the map
+    vec2 edge = min(TexCoord, 1.0 - TexCoord) * viewRect.zw;
+    if (min(edge.x, edge.y) < 1.5 * pixel)
+    {
+        FragColor = BORDER_COLOR;
+        return;
+    }
+
+    vec4 color = BACKGROUND_COLOR;
+    ivec2 cell = ivec2(floor(cellPos));
+    if (cell.x >= 0 && cell.y >= 0 && cell.x < mazeWidth && cell.y < mazeHeight)
+    {
+        uint bits = texelFetch(cells, cell, 0).r;
+        bool visible = revealAll != 0 || (bits & EXPLORED) != 0u;
+        color = visible ? FLOOR_COLOR : UNEXPLORED_COLOR;
+        if (visible)
+        {
+            // Walls at least a pixel wide, whatever the zoom
+            vec2 f = cellPos - vec2(cell);
+            float width = max(0.08, pixel);
+            bool wall = ((bits & WALL_TOP) != 0u && f.y < width) ||
+                        ((bits & WALL_BOTTOM) != 0u && f.y > 1.0 - width) ||
+                        ((bits & WALL_LEFT) != 0u && f.x < width) ||
+                        ((bits & WALL_RIGHT) != 0u && f.x > 1.0 - width);
+            if (vec2(cell) == exitCell)
+                color = EXIT_COLOR;
+            if (wall)
+                color = WALL_COLOR;
+        }
+    }
+
+    // Player: a dot with a line pointing where they look, kept visible when zoomed out
+    float radius = max(0.25, 3.0 * pixel);
+    if (length(cellPos - playerPosition) < radius ||
+        segmentDistance(cellPos, playerPosition, playerPosition + playerFront * 2.5 * radius) < 0.4 * radius)
+        color = PLAYER_COLOR;
+
+    FragColor = color;
+}
@@ -0,0 +1,16 @@
+#version 330 core
+// Screen-space quad for the minimap (see Minimap), generated from gl_VertexID.
+// model maps the unit square to the map's rectangle in normalized device coordinates.
+
+uniform mat4 model;
+
+out vec2 TexCoord;
+
+void main()
+{
+    // Two triangles: (0,0) (1,0) (1,1) and (1,1) (0,1) (0,0)
+    const vec2 corners[6] = vec2[6](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+                                    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0));
+    TexCoord = corners[gl_VertexID];
+    gl_Position = model * vec4(TexCoord, 0.0, 1.0);
+}
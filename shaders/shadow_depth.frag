@@ -0,0 +1,6 @@
+#version 330 core
+// Depth only: nothing to write, the depth buffer is filled by rasterization
+
+void main()
+{
+}
@@ -0,0 +1,18 @@
+#version 330 core
+// Depth-only pass for ShadowMap. INSTANCED is #defined by ShaderVariants for instanced casters.
+layout (location = 0) in vec3 aPos;
+
+#ifdef INSTANCED
+layout (location = 4) in mat4 aInstanceModel; // One matrix per instance (locations 4-7)
+#define MODEL aInstanceModel
+#else
+uniform mat4 model;
+#define MODEL model
+#endif
+
+uniform mat4 lightSpace; // World to the light's clip space
+
+void main()
+{
+    gl_Position = lightSpace * MODEL * vec4(aPos, 1.0);
+}
@@ -3,8 +3,11 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords; // Will be the vertex position, used as direction vector
 
-uniform mat4 projection;
-uniform mat4 view; // View matrix without translation
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos; // Camera position in world space (xyz)
+};
 
 void main() {
     TexCoords = aPos; // Pass vertex position directly as texture coordinate for cubemap
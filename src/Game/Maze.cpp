@@ -1,7 +1,9 @@
 #include "Maze.h"
+#include "../Utils/Utils.h"
 #include <chrono> // For seeding the random number generator
+#include <string>
 
-Maze::Maze(int width, int height) : M_Width(width), M_Height(height) {
+Maze::Maze(int width, int height, unsigned int seed) : M_Width(width), M_Height(height) {
     if (M_Width <= 2 || M_Height <= 2) {
         // Handle invalid dimensions, e.g., throw an error or default to a minimum size
         M_Width = 2;
@@ -13,7 +15,8 @@ Maze::Maze(int width, int height) : M_Width(width), M_Height(height) {
     M_Grid.resize(M_Height, std::vector<Cell>(M_Width));
 
     // Seed the random number generator
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    if (seed == 0)
+        seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
     M_Rng.seed(seed);
 }
 
@@ -179,17 +182,21 @@ void Maze::PrintToConsole() const {
 }
 
 void Maze::PrintToConsole(const glm::ivec2& playerPos) const {
+    // Built in one buffer and written at once: a stream call per character and a flush per
+    // row made large mazes very slow to print (see MazeText.h for exporting them)
+    std::string text;
+    text.reserve((static_cast<size_t>(M_Width) * 4 + 2) * (static_cast<size_t>(M_Height) * 2 + 1) + 64);
     for (int y = 0; y < M_Height; ++y) {
         // Print top walls of cells in this row
         for (int x = 0; x < M_Width; ++x) {
-            std::cout << "+";
-            std::cout << (M_Grid[y][x].wallTop ? "---" : "   ");
+            text += '+';
+            text += M_Grid[y][x].wallTop ? "---" : "   ";
         }
-        std::cout << "+" << std::endl;
+        text += "+\n";
 
         // Print left walls and cell contents
         for (int x = 0; x < M_Width; ++x) {
-            std::cout << (M_Grid[y][x].wallLeft ? "|" : " ");
+            text += M_Grid[y][x].wallLeft ? '|' : ' ';
             char content = ' ';
 
             // Check if this is the player's position
@@ -204,19 +211,23 @@ void Maze::PrintToConsole(const glm::ivec2& playerPos) const {
                 content = 'E';
             }
 
-            std::cout << " " << content << " ";
+            text += ' ';
+            text += content;
+            text += ' ';
         }
-        std::cout << (M_Grid[y][M_Width-1].wallRight ? "|" : " ") << std::endl; // Right wall of last cell in row
+        text += M_Grid[y][M_Width-1].wallRight ? "|\n" : " \n"; // Right wall of last cell in row
     }
     // Print bottom walls of the last row
     for (int x = 0; x < M_Width; ++x) {
-        std::cout << "+";
-        std::cout << (M_Grid[M_Height-1][x].wallBottom ? "---" : "   ");
+        text += '+';
+        text += M_Grid[M_Height-1][x].wallBottom ? "---" : "   ";
     }
-    std::cout << "+" << std::endl;
+    text += "+\n";
 
     // Print legend
-    std::cout << "Legend: P = Player, S = Start, E = End" << std::endl;
+    text += "Legend: P = Player, S = Start, E = End\n";
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
 }
 
 int Maze::GetWidth() const {
@@ -227,6 +238,61 @@ int Maze::GetHeight() const {
     return M_Height;
 }
 
+std::vector<unsigned char> Maze::BuildWallMask() const {
+    std::vector<unsigned char> mask(static_cast<size_t>(M_Width) * M_Height, 0);
+    for (int y = 0; y < M_Height; ++y) {
+        BuildWallRow(y, &mask[static_cast<size_t>(y) * M_Width]);
+    }
+    return mask;
+}
+
+void Maze::BuildWallRow(int y, unsigned char* bits) const {
+    for (int x = 0; x < M_Width; ++x) {
+        const Cell& cell = M_Grid[y][x];
+        unsigned char b = 0;
+        if (cell.wallTop || (y > 0 && M_Grid[y - 1][x].wallBottom)) b |= WALL_TOP;
+        if (cell.wallRight || (x < M_Width - 1 && M_Grid[y][x + 1].wallLeft)) b |= WALL_RIGHT;
+        if (cell.wallBottom || (y < M_Height - 1 && M_Grid[y + 1][x].wallTop)) b |= WALL_BOTTOM;
+        if (cell.wallLeft || (x > 0 && M_Grid[y][x - 1].wallRight)) b |= WALL_LEFT;
+        bits[x] = b;
+    }
+}
+
+bool Maze::HasHorizontalWall(const std::vector<unsigned char>& wallMask, int width, int height, int x, int lineY) {
+    if (x < 0 || x >= width || lineY < 0 || lineY > height)
+        return false;
+    if (lineY < height)
+        return (wallMask[static_cast<size_t>(lineY) * width + x] & WALL_TOP) != 0;
+    return (wallMask[static_cast<size_t>(height - 1) * width + x] & WALL_BOTTOM) != 0;
+}
+
+bool Maze::HasVerticalWall(const std::vector<unsigned char>& wallMask, int width, int height, int lineX, int y) {
+    if (y < 0 || y >= height || lineX < 0 || lineX > width)
+        return false;
+    if (lineX < width)
+        return (wallMask[static_cast<size_t>(y) * width + lineX] & WALL_LEFT) != 0;
+    return (wallMask[static_cast<size_t>(y) * width + width - 1] & WALL_RIGHT) != 0;
+}
+
+uint64_t Maze::ComputeLayoutHash() const {
+    std::vector<unsigned char> mask = BuildWallMask();
+    int dims[2] = { M_Width, M_Height };
+    uint64_t hash = HashBytes(dims, sizeof(dims));
+    return HashBytes(mask.data(), mask.size(), hash);
+}
+
+void Maze::SetCellWalls(int x, int y, unsigned char wallBits) {
+    if (x < 0 || x >= M_Width || y < 0 || y >= M_Height) {
+        std::cerr << "Error: SetCellWalls coordinates (" << x << "," << y << ") out of bounds." << std::endl;
+        return;
+    }
+    Cell& cell = M_Grid[y][x];
+    cell.wallTop = (wallBits & WALL_TOP) != 0;
+    cell.wallRight = (wallBits & WALL_RIGHT) != 0;
+    cell.wallBottom = (wallBits & WALL_BOTTOM) != 0;
+    cell.wallLeft = (wallBits & WALL_LEFT) != 0;
+}
+
 void Maze::SetStartCell(int x, int y) {
     if (x < 0 || x >= M_Width || y < 0 || y >= M_Height) {
         std::cerr << "Error: SetStartCell coordinates (" << x << "," << y << ") out of bounds." << std::endl;
@@ -283,16 +349,57 @@ glm::ivec2 Maze::GetEndCellCoords() const {
     return glm::ivec2(-1, -1); // Invalid coordinates
 }
 
+std::vector<glm::ivec2> Maze::FindPath(const glm::ivec2& from, const glm::ivec2& to) const {
+    auto inside = [this](const glm::ivec2& c) { return c.x >= 0 && c.x < M_Width && c.y >= 0 && c.y < M_Height; };
+    if (!inside(from) || !inside(to)) {
+        std::cerr << "Error: FindPath coordinates out of bounds." << std::endl;
+        return {};
+    }
 
+    // The wall mask's high bits record how each cell was reached (1 + the direction back to
+    // its parent, START at the start), so huge mazes need one byte per cell plus the frontier
+    const unsigned char UNREACHED = 0, START = 5;
+    std::vector<unsigned char> cells = BuildWallMask();
+    auto parentOf = [&cells](size_t cell) { return static_cast<unsigned char>(cells[cell] >> 4); };
+    const size_t start = static_cast<size_t>(from.y) * M_Width + from.x;
+    const size_t goal = static_cast<size_t>(to.y) * M_Width + to.x;
+    cells[start] |= START << 4;
+    std::queue<size_t> frontier;
+    frontier.push(start);
+
+    // Up, Right, Down, Left as in WallBits; (d + 2) % 4 is the way back
+    const int dx[4] = { 0, 1, 0, -1 };
+    const int dy[4] = { -1, 0, 1, 0 };
+    const unsigned char bits[4] = { WALL_TOP, WALL_RIGHT, WALL_BOTTOM, WALL_LEFT };
+    while (!frontier.empty() && parentOf(goal) == UNREACHED) {
+        const size_t cell = frontier.front();
+        frontier.pop();
+        const int x = static_cast<int>(cell % M_Width);
+        const int y = static_cast<int>(cell / M_Width);
+        for (int d = 0; d < 4; ++d) {
+            const glm::ivec2 next(x + dx[d], y + dy[d]);
+            if ((cells[cell] & bits[d]) || !inside(next))
+                continue;
+            const size_t index = static_cast<size_t>(next.y) * M_Width + next.x;
+            if (parentOf(index) == UNREACHED) {
+                cells[index] |= static_cast<unsigned char>((1 + (d + 2) % 4) << 4);
+                frontier.push(index);
+            }
+        }
+    }
 
-
-
-
-
-
-
-
-
-
-
-
+    std::vector<glm::ivec2> path;
+    if (parentOf(goal) == UNREACHED)
+        return path;
+    glm::ivec2 cell = to;
+    for (;;) {
+        path.push_back(cell);
+        const unsigned char parent = parentOf(static_cast<size_t>(cell.y) * M_Width + cell.x);
+        if (parent == START)
+            break;
+        cell.x += dx[parent - 1];
+        cell.y += dy[parent - 1];
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
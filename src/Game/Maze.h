@@ -3,8 +3,10 @@
 #include <vector>
 #include <random>    // For maze generation
 #include <stack>     // For Recursive Backtracker
+#include <queue>     // For FindPath
 #include <algorithm> // For std::shuffle
 #include <iostream>  // For debugging
+#include <cstdint>
 #include <glm/glm.hpp>
 
 // Represents a single cell in the maze
@@ -23,10 +25,21 @@ struct Cell
     // int floorType = 0;
 };
 
+// Bit flags for a compact per-cell wall layout (see Maze::BuildWallMask)
+enum WallBits : unsigned char
+{
+    WALL_TOP = 1 << 0,    // -y neighbour
+    WALL_RIGHT = 1 << 1,  // +x neighbour
+    WALL_BOTTOM = 1 << 2, // +y neighbour
+    WALL_LEFT = 1 << 3    // -x neighbour
+};
+
 class Maze
 {
 public:
-    Maze(int width, int height);
+    // Seed 0 seeds generation from the clock; any other value reproduces the same maze
+    // (with the same standard library, whose shuffle and distributions may differ)
+    Maze(int width, int height, unsigned int seed = 0);
     ~Maze();
 
     void GenerateMaze(int startX, int startY); // Start cell for generation
@@ -45,12 +58,36 @@ public:
     int GetWidth() const ;
     int GetHeight() const ;
 
+    // Returns one WallBits byte per cell (row-major, width * height). An edge counts as a wall
+    // if either of the two cells sharing it has its wall flag set.
+    std::vector<unsigned char> BuildWallMask() const;
+    // The same for one row: fills width bytes (for exporters that stream the maze row by row)
+    void BuildWallRow(int y, unsigned char* bits) const;
+
+    // Walls by grid line, looked up in a BuildWallMask result (for code that walks edges rather
+    // than cells). Horizontal edge (x, lineY) lies on y = lineY between x and x + 1, lineY ==
+    // height being the bottom border; vertical edge (lineX, y) lies on x = lineX. Edges outside
+    // the maze are not walls.
+    static bool HasHorizontalWall(const std::vector<unsigned char>& wallMask, int width, int height, int x, int lineY);
+    static bool HasVerticalWall(const std::vector<unsigned char>& wallMask, int width, int height, int lineX, int y);
+
+    // Hash of the wall layout and dimensions, used to validate caches baked from this maze
+    uint64_t ComputeLayoutHash() const;
+
+    // Sets a cell's four wall flags from WallBits; the neighbours' flags are left alone
+    // (used when loading a maze rather than generating it)
+    void SetCellWalls(int x, int y, unsigned char wallBits);
+
     // TODO: Add methods to find a valid start and end point after generation.
     void SetStartCell(int x, int y);
     void SetEndCell(int x, int y);
     glm::ivec2 GetStartCellCoords() const;
     glm::ivec2 GetEndCellCoords() const;
 
+    // Shortest path between two cells (breadth-first), both ends included; empty if there is
+    // none. Walls are tested as in BuildWallMask.
+    std::vector<glm::ivec2> FindPath(const glm::ivec2& from, const glm::ivec2& to) const;
+
 private:
     int M_Width;
     int M_Height;
@@ -0,0 +1,536 @@
+#include "MazeImage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+    const size_t BAND_BYTES = 8 << 20; // Target raw pixel data of one band
+
+    // Per-cell solution flags
+    const unsigned char ON_PATH = 1 << 0;
+    const unsigned char PATH_RIGHT = 1 << 1; // The path continues to the +x neighbour
+    const unsigned char PATH_DOWN = 1 << 2;  // ... to the +y neighbour
+
+    struct Rgb {
+        unsigned char c[3];
+        explicit Rgb(uint32_t color = 0) : c{ (unsigned char)(color >> 16), (unsigned char)(color >> 8), (unsigned char)color } {}
+    };
+
+    inline unsigned char* fill(unsigned char* p, int pixels, const Rgb& color) {
+        for (int i = 0; i < pixels; ++i, p += 3) {
+            p[0] = color.c[0];
+            p[1] = color.c[1];
+            p[2] = color.c[2];
+        }
+        return p;
+    }
+
+    // Draws single pixel rows; every other row of a span is a copy of its first one
+    struct Raster {
+        const Maze* maze;
+        int cellPixels;
+        int wallPixels;
+        const unsigned char* path; // Solution flags per cell, or nullptr
+        glm::ivec2 start;
+        glm::ivec2 exit;
+        Rgb wall, floor, pathColor, startColor, exitColor;
+
+        // The wall row above cell row y (y == height: the bottom one). above/below are the
+        // wall bits of rows y - 1 and y, each only read if that row exists.
+        void borderRow(unsigned char* p, const unsigned char* above, const unsigned char* below, int y) const {
+            const int width = maze->GetWidth();
+            const int height = maze->GetHeight();
+            auto horizontal = [&](int x) { return y < height ? (below[x] & WALL_TOP) != 0 : (above[x] & WALL_BOTTOM) != 0; };
+            for (int x = 0; x <= width; ++x) {
+                // Junctions are wall where any wall meets them
+                const bool junction = (x < width && horizontal(x)) || (x > 0 && horizontal(x - 1)) ||
+                                      (y > 0 && (x < width ? above[x] & WALL_LEFT : above[width - 1] & WALL_RIGHT)) ||
+                                      (y < height && (x < width ? below[x] & WALL_LEFT : below[width - 1] & WALL_RIGHT));
+                p = fill(p, wallPixels, junction ? wall : floor);
+                if (x == width)
+                    break;
+                if (horizontal(x))
+                    p = fill(p, cellPixels, wall);
+                else if (path && y > 0 && y < height && (path[static_cast<size_t>(y - 1) * width + x] & PATH_DOWN))
+                    p = fill(p, cellPixels, pathColor);
+                else
+                    p = fill(p, cellPixels, floor);
+            }
+        }
+
+        void cellRow(unsigned char* p, const unsigned char* bits, int y) const {
+            const int width = maze->GetWidth();
+            const unsigned char* rowPath = path ? path + static_cast<size_t>(y) * width : nullptr;
+            for (int x = 0; x <= width; ++x) {
+                if (x < width ? bits[x] & WALL_LEFT : bits[width - 1] & WALL_RIGHT)
+                    p = fill(p, wallPixels, wall);
+                else if (rowPath && x > 0 && x < width && (rowPath[x - 1] & PATH_RIGHT))
+                    p = fill(p, wallPixels, pathColor);
+                else
+                    p = fill(p, wallPixels, floor);
+                if (x == width)
+                    break;
+                if (x == start.x && y == start.y)
+                    p = fill(p, cellPixels, startColor);
+                else if (x == exit.x && y == exit.y)
+                    p = fill(p, cellPixels, exitColor);
+                else
+                    p = fill(p, cellPixels, rowPath && (rowPath[x] & ON_PATH) ? pathColor : floor);
+            }
+        }
+
+        // Rows [y0, y1) with the wall row above each, plus the bottom wall row if y1 is the
+        // last row. emit(row, count) receives each distinct pixel row and how often it repeats.
+        template <typename Emit>
+        void band(int y0, int y1, unsigned char* scratch, Emit&& emit) const {
+            const int width = maze->GetWidth();
+            const int height = maze->GetHeight();
+            std::vector<unsigned char> above(width), below(width);
+            if (y0 > 0)
+                maze->BuildWallRow(y0 - 1, above.data());
+            const int lastBorder = y1 == height ? height : y1 - 1;
+            for (int y = y0; y <= lastBorder; ++y) {
+                if (y < height)
+                    maze->BuildWallRow(y, below.data());
+                borderRow(scratch, above.data(), below.data(), y);
+                emit(scratch, wallPixels);
+                if (y == height)
+                    break;
+                cellRow(scratch, below.data(), y);
+                emit(scratch, cellPixels);
+                std::swap(above, below);
+            }
+        }
+    };
+
+    // --- PNG ---
+
+    uint32_t reverseBits(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i)
+            reversed |= ((code >> i) & 1u) << (length - 1 - i);
+        return reversed;
+    }
+
+    const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+    // The fixed Huffman code of RFC 1951 (3.2.6), bit-reversed for LSB-first output
+    struct FixedCodes {
+        uint16_t bits[288];
+        uint8_t lengths[288];
+        uint8_t lengthIndex[259]; // Match length -> index into LENGTH_BASE (symbol 257 + index)
+
+        FixedCodes() {
+            for (int symbol = 0; symbol < 288; ++symbol) {
+                uint32_t code;
+                int length;
+                if (symbol < 144) { code = 0x30 + symbol; length = 8; }
+                else if (symbol < 256) { code = 0x190 + symbol - 144; length = 9; }
+                else if (symbol < 280) { code = symbol - 256; length = 7; }
+                else { code = 0xC0 + symbol - 280; length = 8; }
+                bits[symbol] = static_cast<uint16_t>(reverseBits(code, length));
+                lengths[symbol] = static_cast<uint8_t>(length);
+            }
+            for (int length = 3, index = 0; length <= 258; ++length) {
+                while (index < 28 && LENGTH_BASE[index + 1] <= length)
+                    ++index;
+                lengthIndex[length] = static_cast<uint8_t>(index);
+            }
+        }
+    };
+
+    const FixedCodes& fixedCodes() {
+        static const FixedCodes codes;
+        return codes;
+    }
+
+    const uint32_t ADLER_BASE = 65521;
+
+    // Adler-32 of a + b, given both checksums and the length of b (as zlib's adler32_combine)
+    uint32_t combineAdler(uint32_t a, uint32_t b, uint64_t lengthB) {
+        const uint32_t remainder = static_cast<uint32_t>(lengthB % ADLER_BASE);
+        uint32_t sum1 = a & 0xFFFF;
+        uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum1) % ADLER_BASE);
+        sum1 += (b & 0xFFFF) + ADLER_BASE - 1;
+        sum2 += (a >> 16) + (b >> 16) + ADLER_BASE - remainder;
+        if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+        if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+        if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+        if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+        return sum1 | (sum2 << 16);
+    }
+
+    uint32_t crc32(uint32_t crc, const unsigned char* data, size_t length) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < length; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // Compresses one band as a fixed-Huffman deflate block closed by a sync flush (an empty
+    // stored block), which leaves the output byte-aligned: bands compressed independently
+    // concatenate into one valid stream. Matches only repeat the previous byte (distance 1),
+    // i.e. run-length coding, which with PNG's row filters covers a maze's flat areas.
+    class BandDeflater {
+    public:
+        explicit BandDeflater(std::vector<unsigned char>& out)
+            : M_Out(out), M_BitBuffer(0), M_BitCount(0), M_Last(-1), M_Run(0), M_Sum1(1), M_Sum2(0), M_Unreduced(0), M_Length(0) {
+            writeBits(0, 1); // Not the final block
+            writeBits(1, 2); // Fixed Huffman codes
+        }
+
+        void Byte(unsigned char value) {
+            M_Sum1 += value;
+            M_Sum2 += M_Sum1;
+            if (++M_Unreduced == 5552) // Largest count that can't overflow (zlib's NMAX)
+                reduce();
+            ++M_Length;
+
+            if (value == M_Last) {
+                if (++M_Run == 258) {
+                    match(258);
+                    M_Run = 0;
+                }
+                return;
+            }
+            flushRun();
+            literal(value);
+            M_Last = value;
+        }
+
+        void Run(unsigned char value, uint64_t count) {
+            if (count == 0)
+                return;
+            reduce();
+            M_Sum2 = static_cast<uint32_t>((M_Sum2 + static_cast<uint64_t>(M_Sum1) * (count % ADLER_BASE) +
+                                            value * ((count * (count + 1) / 2) % ADLER_BASE)) % ADLER_BASE);
+            M_Sum1 = static_cast<uint32_t>((M_Sum1 + value * (count % ADLER_BASE)) % ADLER_BASE);
+            M_Length += count;
+
+            if (value != M_Last) {
+                flushRun();
+                literal(value);
+                M_Last = value;
+                --count;
+            }
+            M_Run += count;
+            while (M_Run >= 258) {
+                match(258);
+                M_Run -= 258;
+            }
+        }
+
+        // Ends the block and sync-flushes; returns the Adler-32 of the uncompressed bytes
+        uint32_t Finish() {
+            flushRun();
+            literal(256); // End of block
+            writeBits(0, 3); // Empty stored block...
+            if (M_BitCount > 0)
+                writeBits(0, 8 - M_BitCount); // ...starting on a byte boundary
+            const unsigned char empty[4] = { 0x00, 0x00, 0xFF, 0xFF };
+            M_Out.insert(M_Out.end(), empty, empty + 4);
+            reduce();
+            return M_Sum1 | (M_Sum2 << 16);
+        }
+
+        uint64_t GetLength() const { return M_Length; }
+
+    private:
+        std::vector<unsigned char>& M_Out;
+        uint64_t M_BitBuffer;
+        int M_BitCount;
+        int M_Last;      // Previous byte, -1 at the start
+        uint64_t M_Run;  // Repeats of M_Last not yet emitted
+        uint32_t M_Sum1; // Adler-32 halves
+        uint32_t M_Sum2;
+        int M_Unreduced;
+        uint64_t M_Length;
+
+        void reduce() {
+            M_Sum1 %= ADLER_BASE;
+            M_Sum2 %= ADLER_BASE;
+            M_Unreduced = 0;
+        }
+
+        void writeBits(uint32_t value, int count) {
+            M_BitBuffer |= static_cast<uint64_t>(value) << M_BitCount;
+            M_BitCount += count;
+            while (M_BitCount >= 8) {
+                M_Out.push_back(static_cast<unsigned char>(M_BitBuffer));
+                M_BitBuffer >>= 8;
+                M_BitCount -= 8;
+            }
+        }
+
+        void literal(int symbol) {
+            const FixedCodes& codes = fixedCodes();
+            writeBits(codes.bits[symbol], codes.lengths[symbol]);
+        }
+
+        void match(int length) {
+            const FixedCodes& codes = fixedCodes();
+            const int index = codes.lengthIndex[length];
+            literal(257 + index);
+            if (LENGTH_EXTRA[index] > 0)
+                writeBits(static_cast<uint32_t>(length - LENGTH_BASE[index]), LENGTH_EXTRA[index]);
+            writeBits(0, 5); // Distance code 0: distance 1
+        }
+
+        void flushRun() {
+            if (M_Run >= 3) {
+                match(static_cast<int>(M_Run));
+            }
+            else {
+                for (uint64_t i = 0; i < M_Run; ++i)
+                    literal(M_Last);
+            }
+            M_Run = 0;
+        }
+    };
+
+    void putBigEndian(unsigned char* p, uint32_t value) {
+        p[0] = static_cast<unsigned char>(value >> 24);
+        p[1] = static_cast<unsigned char>(value >> 16);
+        p[2] = static_cast<unsigned char>(value >> 8);
+        p[3] = static_cast<unsigned char>(value);
+    }
+
+    // Rows filtered with Sub (first row of a span) or Up (its copies, which become all zero)
+    void deflateRows(BandDeflater& deflater, const unsigned char* row, size_t rowBytes, int count,
+                     std::vector<unsigned char>& filtered) {
+        if (count <= 0)
+            return;
+        filtered.resize(rowBytes);
+        for (size_t i = 0; i < rowBytes; ++i)
+            filtered[i] = static_cast<unsigned char>(row[i] - (i >= 3 ? row[i - 3] : 0));
+        deflater.Byte(1); // Sub
+        for (size_t i = 0; i < rowBytes;) {
+            size_t end = i + 1;
+            while (end < rowBytes && filtered[end] == filtered[i])
+                ++end;
+            if (end - i >= 4)
+                deflater.Run(filtered[i], end - i);
+            else
+                for (size_t j = i; j < end; ++j)
+                    deflater.Byte(filtered[j]);
+            i = end;
+        }
+        for (int copy = 1; copy < count; ++copy) {
+            deflater.Byte(2); // Up
+            deflater.Run(0, rowBytes);
+        }
+    }
+}
+
+bool WriteMazeImage(const Maze& maze, std::ostream& out, MazeImageFormat format, const MazeImageSettings& settings,
+                    MazeImageStats* stats)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const int width = maze.GetWidth();
+    const int height = maze.GetHeight();
+
+    Raster raster;
+    raster.maze = &maze;
+    raster.cellPixels = std::max(1, settings.cellPixels);
+    raster.wallPixels = std::max(1, settings.wallPixels);
+    raster.start = maze.GetStartCellCoords();
+    raster.exit = maze.GetEndCellCoords();
+    raster.wall = Rgb(settings.wallColor);
+    raster.floor = Rgb(settings.floorColor);
+    raster.pathColor = Rgb(settings.pathColor);
+    raster.startColor = Rgb(settings.startColor);
+    raster.exitColor = Rgb(settings.exitColor);
+
+    const int span = raster.cellPixels + raster.wallPixels;
+    const uint64_t imageWidth = static_cast<uint64_t>(width) * span + raster.wallPixels;
+    const uint64_t imageHeight = static_cast<uint64_t>(height) * span + raster.wallPixels;
+    if (format == MazeImageFormat::PNG && (imageWidth > 0x7FFFFFFF || imageHeight > 0x7FFFFFFF)) {
+        std::cerr << "Maze image: " << imageWidth << "x" << imageHeight << " exceeds the PNG size limit" << std::endl;
+        return false;
+    }
+
+    // The solution as per-cell flags
+    std::vector<unsigned char> path;
+    raster.path = nullptr;
+    if (settings.solution) {
+        std::vector<glm::ivec2> cells = maze.FindPath(raster.start, raster.exit);
+        if (cells.empty()) {
+            std::cerr << "Maze image: no path from the start to the exit, drawing none" << std::endl;
+        }
+        else {
+            path.assign(static_cast<size_t>(width) * height, 0);
+            auto index = [width](const glm::ivec2& c) { return static_cast<size_t>(c.y) * width + c.x; };
+            for (size_t i = 0; i < cells.size(); ++i) {
+                path[index(cells[i])] |= ON_PATH;
+                if (i + 1 == cells.size())
+                    break;
+                // Link the two cells through the edge between them, stored on the upper/left one
+                const glm::ivec2& a = cells[i];
+                const glm::ivec2& b = cells[i + 1];
+                if (a.y == b.y)
+                    path[index(a.x < b.x ? a : b)] |= PATH_RIGHT;
+                else
+                    path[index(a.y < b.y ? a : b)] |= PATH_DOWN;
+            }
+            raster.path = path.data();
+        }
+    }
+
+    uint64_t bytesWritten = 0;
+    auto write = [&out, &bytesWritten](const void* data, size_t length) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+        bytesWritten += length;
+    };
+    auto writeChunk = [&write](const char* type, const unsigned char* data, size_t length, uint32_t crc) {
+        unsigned char header[8];
+        putBigEndian(header, static_cast<uint32_t>(length));
+        std::memcpy(header + 4, type, 4);
+        write(header, 8);
+        if (length > 0)
+            write(data, length);
+        unsigned char trailer[4];
+        putBigEndian(trailer, crc);
+        write(trailer, 4);
+    };
+    auto chunkCrc = [](const char* type, const unsigned char* data, size_t length) {
+        return crc32(crc32(0, reinterpret_cast<const unsigned char*>(type), 4), data, length);
+    };
+
+    // --- Header ---
+    const size_t rowBytes = static_cast<size_t>(imageWidth) * 3;
+    if (format == MazeImageFormat::PPM) {
+        const std::string header = "P6\n" + std::to_string(imageWidth) + " " + std::to_string(imageHeight) + "\n255\n";
+        write(header.data(), header.size());
+    }
+    else {
+        const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        write(signature, 8);
+        unsigned char ihdr[13] = { 0 };
+        putBigEndian(ihdr, static_cast<uint32_t>(imageWidth));
+        putBigEndian(ihdr + 4, static_cast<uint32_t>(imageHeight));
+        ihdr[8] = 8; // Bits per channel
+        ihdr[9] = 2; // RGB
+        writeChunk("IHDR", ihdr, sizeof(ihdr), chunkCrc("IHDR", ihdr, sizeof(ihdr)));
+        const unsigned char zlibHeader[2] = { 0x78, 0x01 }; // Deflate, 32 KB window, no dictionary
+        writeChunk("IDAT", zlibHeader, 2, chunkCrc("IDAT", zlibHeader, 2));
+    }
+
+    // --- Bands of cell rows, rasterised and (for PNG) compressed on all cores ---
+    const int rowsPerBand = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(height, BAND_BYTES / (span * (rowBytes + 1)))));
+    const int bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+    const int threadCount = std::min(bandCount, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+
+    struct Band {
+        std::vector<unsigned char> data; // Raw pixels (PPM) or compressed (PNG)
+        std::vector<unsigned char> scratch, filtered;
+        uint32_t adler = 1;
+        uint64_t rawLength = 0;
+    };
+    // Two sets: one wave of bands is written out while the next one renders
+    std::vector<Band> waves[2];
+    for (std::vector<Band>& wave : waves) {
+        wave.resize(threadCount);
+        for (Band& band : wave)
+            band.scratch.resize(rowBytes);
+    }
+
+    uint32_t adler = 1; // Of everything compressed so far
+    auto writeWave = [&](std::vector<Band>& wave, int count) {
+        for (int i = 0; i < count; ++i) {
+            Band& band = wave[i];
+            if (format == MazeImageFormat::PPM) {
+                write(band.data.data(), band.data.size());
+                continue;
+            }
+            writeChunk("IDAT", band.data.data(), band.data.size(), chunkCrc("IDAT", band.data.data(), band.data.size()));
+            adler = combineAdler(adler, band.adler, band.rawLength);
+        }
+    };
+
+    int pending = 0;
+    int wave = 0;
+    for (int firstBand = 0; firstBand < bandCount; firstBand += threadCount, ++wave) {
+        std::vector<Band>& bands = waves[wave % 2];
+        const int count = std::min(threadCount, bandCount - firstBand);
+        std::atomic<int> nextBand(0);
+        auto worker = [&]() {
+            for (int i = nextBand++; i < count; i = nextBand++) {
+                Band& band = bands[i];
+                const int y0 = (firstBand + i) * rowsPerBand;
+                const int y1 = std::min(height, y0 + rowsPerBand);
+                band.data.clear();
+                if (format == MazeImageFormat::PPM) {
+                    raster.band(y0, y1, band.scratch.data(), [&band, rowBytes](const unsigned char* row, int repeat) {
+                        for (int r = 0; r < repeat; ++r)
+                            band.data.insert(band.data.end(), row, row + rowBytes);
+                    });
+                }
+                else {
+                    BandDeflater deflater(band.data);
+                    raster.band(y0, y1, band.scratch.data(), [&](const unsigned char* row, int repeat) {
+                        deflateRows(deflater, row, rowBytes, repeat, band.filtered);
+                    });
+                    band.adler = deflater.Finish();
+                    band.rawLength = deflater.GetLength();
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < count; ++i)
+            threads.emplace_back(worker);
+        writeWave(waves[(wave + 1) % 2], pending); // Main thread writes meanwhile
+        for (auto& t : threads)
+            t.join();
+        pending = count;
+    }
+    writeWave(waves[(wave + 1) % 2], pending);
+
+    // --- Trailer: final (empty) block, checksum, end ---
+    if (format == MazeImageFormat::PNG) {
+        unsigned char end[9] = { 0x01, 0x00, 0x00, 0xFF, 0xFF };
+        putBigEndian(end + 5, adler);
+        writeChunk("IDAT", end, sizeof(end), chunkCrc("IDAT", end, sizeof(end)));
+        writeChunk("IEND", nullptr, 0, chunkCrc("IEND", nullptr, 0));
+    }
+    out.flush();
+
+    if (stats) {
+        stats->width = imageWidth;
+        stats->height = imageHeight;
+        stats->bytes = bytesWritten;
+        stats->ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+    return static_cast<bool>(out);
+}
+
+bool SaveMazeImage(const Maze& maze, const std::string& path, const MazeImageSettings& settings, MazeImageStats* stats)
+{
+    const bool ppm = path.size() >= 4 && (path.compare(path.size() - 4, 4, ".ppm") == 0 || path.compare(path.size() - 4, 4, ".PPM") == 0);
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    if (!WriteMazeImage(maze, file, ppm ? MazeImageFormat::PPM : MazeImageFormat::PNG, settings, stats)) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Maze.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Raster image of a maze, optionally with the solution from start to exit drawn in.
+// Every cell is cellPixels square and every wall wallPixels thick, so the image is
+// width * (cellPixels + wallPixels) + wallPixels pixels wide (1 and 1 give the classic
+// 2 * width + 1). Row bands are rasterised (and, for PNG, compressed) on all cores and
+// streamed out in order, so memory stays bounded however large the image gets; only the
+// maze itself and one byte per cell for the solution are held.
+enum class MazeImageFormat { PNG, PPM };
+
+struct MazeImageSettings {
+    int cellPixels = 4;
+    int wallPixels = 1;
+    bool solution = true;        // Overlay the shortest path from start to exit
+    uint32_t wallColor = 0x202020; // 0xRRGGBB
+    uint32_t floorColor = 0xF0F0F0;
+    uint32_t pathColor = 0xE04040;
+    uint32_t startColor = 0x40B040;
+    uint32_t exitColor = 0x4060E0;
+};
+
+struct MazeImageStats {
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t bytes = 0; // Size of the written file
+    double ms = 0.0;    // Including the solve
+    double MegapixelsPerSecond() const { return ms > 0.0 ? width * height / (ms * 1000.0) : 0.0; }
+};
+
+// PNG is RGB8, deflate-compressed (fixed Huffman codes and run-length matches, which suit
+// the large flat areas of a maze); PPM is binary P6. Returns false if the stream failed or
+// the image would exceed the format's size limit.
+bool WriteMazeImage(const Maze& maze, std::ostream& out, MazeImageFormat format, const MazeImageSettings& settings,
+                    MazeImageStats* stats = nullptr);
+// The format follows the extension: .ppm, anything else is PNG
+bool SaveMazeImage(const Maze& maze, const std::string& path, const MazeImageSettings& settings,
+                   MazeImageStats* stats = nullptr);
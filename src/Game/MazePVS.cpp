@@ -0,0 +1,483 @@
+#include "MazePVS.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+namespace {
+    const char PVS_MAGIC[4] = { 'M', 'P', 'V', 'S' };
+    const uint32_t PVS_VERSION = 2;
+
+    // Per-row output of a bake worker, merged into the final tables afterwards
+    struct RowResult
+    {
+        std::vector<uint16_t> rects; // 4 per cell
+        std::vector<unsigned char> bits;
+    };
+
+    size_t rectBytes(uint16_t minX, uint16_t minY, uint16_t maxX, uint16_t maxY)
+    {
+        size_t w = static_cast<size_t>(maxX - minX + 1);
+        size_t h = static_cast<size_t>(maxY - minY + 1);
+        return (w * h + 7) / 8;
+    }
+
+    // A sight line v = m * u + c in the frame of one octant: the source cell is [0,1]^2 and
+    // the line heads towards +u with 0 <= m <= 1, so it leaves each cell through its +u or
+    // +v edge. The lines that can pass through a sequence of open edges form a convex
+    // polygon in (m, c), clipped by two half-planes per edge.
+    struct LineParams
+    {
+        double m, c;
+    };
+
+    // Slack on every edge constraint, so lines grazing a wall corner count as passing
+    const double EDGE_SLACK = 1e-6;
+
+    // Keeps the part of a convex polygon where a * m + b * c <= d
+    void clipLines(const std::vector<LineParams>& in, double a, double b, double d, std::vector<LineParams>& out)
+    {
+        out.clear();
+        d += EDGE_SLACK;
+        for (size_t i = 0; i < in.size(); ++i)
+        {
+            const LineParams& p = in[i];
+            const LineParams& q = in[(i + 1) % in.size()];
+            double fp = a * p.m + b * p.c - d;
+            double fq = a * q.m + b * q.c - d;
+            if (fp <= 0.0)
+                out.push_back(p);
+            if ((fp <= 0.0) != (fq <= 0.0))
+            {
+                double t = fp / (fp - fq);
+                out.push_back({ p.m + (q.m - p.m) * t, p.c + (q.c - p.c) * t });
+            }
+        }
+    }
+
+    // Convex hull of the union of two line polygons (monotone chain), into out
+    void mergeLines(const std::vector<LineParams>& a, const std::vector<LineParams>& b, std::vector<LineParams>& points,
+                    std::vector<LineParams>& out)
+    {
+        points.assign(a.begin(), a.end());
+        points.insert(points.end(), b.begin(), b.end());
+        std::sort(points.begin(), points.end(), [](const LineParams& p, const LineParams& q) {
+            return p.m < q.m || (p.m == q.m && p.c < q.c);
+        });
+        auto cross = [](const LineParams& o, const LineParams& p, const LineParams& q) {
+            return (p.m - o.m) * (q.c - o.c) - (p.c - o.c) * (q.m - o.m);
+        };
+        out.assign(points.size() * 2, LineParams());
+        size_t k = 0;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            while (k >= 2 && cross(out[k - 2], out[k - 1], points[i]) <= 0.0) --k;
+            out[k++] = points[i];
+        }
+        for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;)
+        {
+            while (k >= lower && cross(out[k - 2], out[k - 1], points[i]) <= 0.0) --k;
+            out[k++] = points[i];
+        }
+        out.resize(k > 1 ? k - 1 : k);
+    }
+
+    // Conservative cell-to-cell visibility: a cell is visible from a source cell if some line
+    // through the source cell reaches it through open edges only. Each of the eight octants
+    // (mirror x, mirror y, swap axes) is swept from the source cell one diagonal (u + v) at a
+    // time, carrying per cell the set of lines that can reach it. Where two paths meet (only
+    // possible in mazes with loops) the sets are merged into their convex hull, which can
+    // only add lines, so the sweep stays linear in the cells in range.
+    class PortalWalker
+    {
+    public:
+        PortalWalker(const std::vector<unsigned char>& walls, int width, int height, double maxDistance, int radius)
+            : M_Walls(walls), M_Width(width), M_Height(height), M_MaxDistanceSq(maxDistance * maxDistance),
+              M_Radius(radius), M_WindowSize(2 * radius + 1),
+              M_Stamps(static_cast<size_t>(M_WindowSize) * M_WindowSize, 0), M_Stamp(0),
+              M_Lines(static_cast<size_t>(radius + 2) * (radius + 2)),
+              M_LineStamps(M_Lines.size(), 0), M_LineStamp(0),
+              M_OriginX(0), M_OriginY(0), M_Octant(0)
+        {
+        }
+
+        // Cells visible from (x, y) after the last Run, each listed once
+        const std::vector<std::pair<int, int>>& Visible() const { return M_Visible; }
+
+        void Run(int x, int y)
+        {
+            ++M_Stamp;
+            M_Visible.clear();
+            M_OriginX = x;
+            M_OriginY = y;
+            mark(x, y);
+            for (M_Octant = 0; M_Octant < 8; ++M_Octant)
+                sweep();
+        }
+
+    private:
+        const std::vector<unsigned char>& M_Walls;
+        int M_Width;
+        int M_Height;
+        double M_MaxDistanceSq;
+        int M_Radius;
+        int M_WindowSize;
+        std::vector<uint32_t> M_Stamps; // Window-local "already visible" marks
+        uint32_t M_Stamp;
+        std::vector<std::pair<int, int>> M_Visible;
+        std::vector<std::vector<LineParams>> M_Lines; // Lines reaching each octant-local cell
+        std::vector<uint32_t> M_LineStamps;           // Which M_Lines entries belong to this sweep
+        uint32_t M_LineStamp;
+        std::vector<std::pair<int, int>> M_Front, M_NextFront;
+        std::vector<LineParams> M_Clipped, M_Scratch, M_Merged;
+        int M_OriginX, M_OriginY;
+        int M_Octant;
+
+        void mark(int x, int y)
+        {
+            uint32_t& s = M_Stamps[static_cast<size_t>(y - M_OriginY + M_Radius) * M_WindowSize + (x - M_OriginX + M_Radius)];
+            if (s != M_Stamp)
+            {
+                s = M_Stamp;
+                M_Visible.push_back({ x, y });
+            }
+        }
+
+        // Octant-local cell offset to maze cell
+        void toMaze(int u, int v, int& x, int& y) const
+        {
+            int p = (M_Octant & 4) ? v : u;
+            int q = (M_Octant & 4) ? u : v;
+            x = M_OriginX + ((M_Octant & 1) ? -p : p);
+            y = M_OriginY + ((M_Octant & 2) ? -q : q);
+        }
+
+        bool isOpen(int x, int y, int toX, int toY) const
+        {
+            if (toX < 0 || toX >= M_Width || toY < 0 || toY >= M_Height)
+                return false;
+            unsigned char cellWalls = M_Walls[static_cast<size_t>(y) * M_Width + x];
+            if (toX != x)
+                return !(cellWalls & (toX > x ? WALL_RIGHT : WALL_LEFT));
+            return !(cellWalls & (toY > y ? WALL_BOTTOM : WALL_TOP));
+        }
+
+        bool inRange(int u, int v) const
+        {
+            double du = std::max(u - 1, 0);
+            double dv = std::max(v - 1, 0);
+            return du * du + dv * dv <= M_MaxDistanceSq;
+        }
+
+        size_t lineIndex(int u, int v) const { return static_cast<size_t>(v) * (M_Radius + 2) + u; }
+
+        // Passes the lines of (u, v) through its edge into (toU, toV), given as the two
+        // half-planes a * m + b * c <= d, and adds what is left to the lines of (toU, toV)
+        void cross(int u, int v, int toU, int toV, double a0, double b0, double d0, double a1, double b1, double d1)
+        {
+            if (toU > M_Radius || toV > M_Radius || !inRange(toU, toV))
+                return;
+            int x, y, toX, toY;
+            toMaze(u, v, x, y);
+            toMaze(toU, toV, toX, toY);
+            if (!isOpen(x, y, toX, toY))
+                return;
+
+            clipLines(M_Lines[lineIndex(u, v)], a0, b0, d0, M_Scratch);
+            if (M_Scratch.empty())
+                return;
+            clipLines(M_Scratch, a1, b1, d1, M_Clipped);
+            if (M_Clipped.empty())
+                return;
+
+            size_t index = lineIndex(toU, toV);
+            if (M_LineStamps[index] != M_LineStamp)
+            {
+                M_LineStamps[index] = M_LineStamp;
+                M_Lines[index] = M_Clipped;
+                M_NextFront.push_back({ toU, toV });
+                mark(toX, toY);
+            }
+            else
+            {
+                mergeLines(M_Lines[index], M_Clipped, M_Scratch, M_Merged);
+                M_Lines[index].swap(M_Merged);
+            }
+        }
+
+        void sweep()
+        {
+            ++M_LineStamp;
+            size_t origin = lineIndex(0, 0);
+            M_LineStamps[origin] = M_LineStamp;
+            M_Lines[origin] = { { 0.0, -1.0 }, { 1.0, -1.0 }, { 1.0, 1.0 }, { 0.0, 1.0 } };
+            M_Front.assign(1, { 0, 0 });
+            while (!M_Front.empty())
+            {
+                M_NextFront.clear();
+                for (const auto& cell : M_Front)
+                {
+                    int u = cell.first, v = cell.second;
+                    // Through the +u edge (u + 1, v..v+1): v <= m(u+1) + c <= v + 1
+                    cross(u, v, u + 1, v, -(u + 1.0), -1.0, -static_cast<double>(v), u + 1.0, 1.0, v + 1.0);
+                    // Through the +v edge (u..u+1, v + 1): u <= (v + 1 - c) / m <= u + 1, scaled by m >= 0
+                    cross(u, v, u, v + 1, static_cast<double>(u), 1.0, v + 1.0, -(u + 1.0), -1.0, -(v + 1.0));
+                }
+                M_Front.swap(M_NextFront);
+            }
+        }
+    };
+}
+
+MazePVS::MazePVS()
+    : M_Width(0), M_Height(0), M_LayoutHash(0), M_BakeTimeMs(0.0)
+{
+}
+
+void MazePVS::Bake(const Maze& maze, const BakeSettings& settings)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    if (maze.GetWidth() > 65535 || maze.GetHeight() > 65535)
+    {
+        std::cerr << "Error: PVS baking supports mazes up to 65535x65535 cells." << std::endl;
+        return;
+    }
+
+    M_Width = maze.GetWidth();
+    M_Height = maze.GetHeight();
+    M_LayoutHash = maze.ComputeLayoutHash();
+
+    const std::vector<unsigned char> walls = maze.BuildWallMask();
+    const int width = M_Width;
+    const int height = M_Height;
+    const double maxDistance = settings.maxDistance;
+    // Sight lines never travel further than maxDistance, so each source cell only touches a
+    // (2R+1)^2 window around itself
+    const int radius = static_cast<int>(std::ceil(maxDistance)) + 1;
+
+    std::vector<RowResult> rows(height);
+    std::atomic<int> nextRow(0);
+
+    auto worker = [&]()
+    {
+        PortalWalker walker(walls, width, height, maxDistance, radius);
+        const std::vector<std::pair<int, int>>& visible = walker.Visible();
+
+        for (int y = nextRow.fetch_add(1); y < height; y = nextRow.fetch_add(1))
+        {
+            RowResult& row = rows[y];
+            row.rects.reserve(static_cast<size_t>(width) * 4);
+
+            for (int x = 0; x < width; ++x)
+            {
+                walker.Run(x, y);
+
+                // Bounding rectangle of the visible cells
+                int minX = x, minY = y, maxX = x, maxY = y;
+                for (const auto& c : visible)
+                {
+                    minX = std::min(minX, c.first);
+                    maxX = std::max(maxX, c.first);
+                    minY = std::min(minY, c.second);
+                    maxY = std::max(maxY, c.second);
+                }
+                row.rects.push_back(static_cast<uint16_t>(minX));
+                row.rects.push_back(static_cast<uint16_t>(minY));
+                row.rects.push_back(static_cast<uint16_t>(maxX));
+                row.rects.push_back(static_cast<uint16_t>(maxY));
+
+                // Pack one bit per cell of the rectangle
+                size_t base = row.bits.size();
+                int rectW = maxX - minX + 1;
+                row.bits.resize(base + rectBytes(minX, minY, maxX, maxY), 0);
+                for (const auto& c : visible)
+                {
+                    size_t bit = static_cast<size_t>(c.second - minY) * rectW + (c.first - minX);
+                    row.bits[base + bit / 8] |= static_cast<unsigned char>(1u << (bit % 8));
+                }
+            }
+        }
+    };
+
+    unsigned int threadCount = settings.threadCount;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(height));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker(); // Main thread takes a share too
+    for (auto& t : threads)
+        t.join();
+
+    // Merge rows into the final tables
+    size_t totalBits = 0;
+    for (const RowResult& row : rows)
+        totalBits += row.bits.size();
+
+    M_Rects.resize(static_cast<size_t>(width) * height);
+    M_Bits.clear();
+    M_Bits.reserve(totalBits);
+    for (int y = 0; y < height; ++y)
+    {
+        const RowResult& row = rows[y];
+        for (int x = 0; x < width; ++x)
+        {
+            CellRect& rect = M_Rects[static_cast<size_t>(y) * width + x];
+            rect.minX = row.rects[x * 4 + 0];
+            rect.minY = row.rects[x * 4 + 1];
+            rect.maxX = row.rects[x * 4 + 2];
+            rect.maxY = row.rects[x * 4 + 3];
+        }
+        M_Bits.insert(M_Bits.end(), row.bits.begin(), row.bits.end());
+    }
+    rebuildOffsets();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    M_BakeTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    std::cout << "PVS baked for " << width << "x" << height << " maze in " << M_BakeTimeMs << " ms using "
+              << threadCount << " threads (" << GetMemoryUsage() / 1024 << " KB, "
+              << GetAverageVisibleCells() << " visible cells on average)" << std::endl;
+}
+
+void MazePVS::rebuildOffsets()
+{
+    M_Offsets.resize(M_Rects.size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < M_Rects.size(); ++i)
+    {
+        M_Offsets[i] = offset;
+        const CellRect& r = M_Rects[i];
+        offset += rectBytes(r.minX, r.minY, r.maxX, r.maxY);
+    }
+}
+
+bool MazePVS::SaveToFile(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open PVS file for writing: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t dims[2] = { static_cast<uint32_t>(M_Width), static_cast<uint32_t>(M_Height) };
+    uint64_t bitBytes = M_Bits.size();
+    file.write(PVS_MAGIC, sizeof(PVS_MAGIC));
+    file.write(reinterpret_cast<const char*>(&PVS_VERSION), sizeof(PVS_VERSION));
+    file.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    file.write(reinterpret_cast<const char*>(&M_LayoutHash), sizeof(M_LayoutHash));
+    file.write(reinterpret_cast<const char*>(&bitBytes), sizeof(bitBytes));
+    file.write(reinterpret_cast<const char*>(M_Rects.data()), M_Rects.size() * sizeof(CellRect));
+    file.write(reinterpret_cast<const char*>(M_Bits.data()), M_Bits.size());
+    return static_cast<bool>(file);
+}
+
+bool MazePVS::LoadFromFile(const std::string& path, const Maze& maze)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false; // No cache yet, not an error
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t dims[2] = { 0, 0 };
+    uint64_t layoutHash = 0;
+    uint64_t bitBytes = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(dims), sizeof(dims));
+    file.read(reinterpret_cast<char*>(&layoutHash), sizeof(layoutHash));
+    file.read(reinterpret_cast<char*>(&bitBytes), sizeof(bitBytes));
+
+    if (!file || !std::equal(magic, magic + 4, PVS_MAGIC) || version != PVS_VERSION)
+    {
+        std::cerr << "Ignoring invalid PVS file: " << path << std::endl;
+        return false;
+    }
+    if (static_cast<int>(dims[0]) != maze.GetWidth() || static_cast<int>(dims[1]) != maze.GetHeight() ||
+        layoutHash != maze.ComputeLayoutHash())
+    {
+        std::cout << "PVS file " << path << " is stale (maze layout changed)" << std::endl;
+        return false;
+    }
+
+    M_Width = static_cast<int>(dims[0]);
+    M_Height = static_cast<int>(dims[1]);
+    M_LayoutHash = layoutHash;
+    M_Rects.resize(static_cast<size_t>(M_Width) * M_Height);
+    M_Bits.resize(static_cast<size_t>(bitBytes));
+    file.read(reinterpret_cast<char*>(M_Rects.data()), M_Rects.size() * sizeof(CellRect));
+    file.read(reinterpret_cast<char*>(M_Bits.data()), M_Bits.size());
+    if (!file)
+    {
+        std::cerr << "Truncated PVS file: " << path << std::endl;
+        M_Rects.clear();
+        M_Bits.clear();
+        return false;
+    }
+    rebuildOffsets();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::cout << "PVS loaded from " << path << " in "
+              << std::chrono::duration<double, std::milli>(endTime - startTime).count() << " ms ("
+              << GetMemoryUsage() / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+bool MazePVS::IsVisible(int fromX, int fromY, int toX, int toY) const
+{
+    if (fromX < 0 || fromX >= M_Width || fromY < 0 || fromY >= M_Height)
+    {
+        return true; // Outside the maze: no information, be conservative
+    }
+    size_t index = static_cast<size_t>(fromY) * M_Width + fromX;
+    const CellRect& r = M_Rects[index];
+    if (toX < r.minX || toX > r.maxX || toY < r.minY || toY > r.maxY)
+    {
+        return false;
+    }
+    size_t bit = static_cast<size_t>(toY - r.minY) * (r.maxX - r.minX + 1) + (toX - r.minX);
+    return (M_Bits[M_Offsets[index] + bit / 8] >> (bit % 8)) & 1u;
+}
+
+void MazePVS::GetVisibleBounds(int x, int y, int& minX, int& minY, int& maxX, int& maxY) const
+{
+    if (x < 0 || x >= M_Width || y < 0 || y >= M_Height)
+    {
+        minX = 0;
+        minY = 0;
+        maxX = M_Width - 1;
+        maxY = M_Height - 1;
+        return;
+    }
+    const CellRect& r = M_Rects[static_cast<size_t>(y) * M_Width + x];
+    minX = r.minX;
+    minY = r.minY;
+    maxX = r.maxX;
+    maxY = r.maxY;
+}
+
+size_t MazePVS::GetMemoryUsage() const
+{
+    return M_Rects.size() * sizeof(CellRect) + M_Offsets.size() * sizeof(uint64_t) + M_Bits.size();
+}
+
+double MazePVS::GetAverageVisibleCells() const
+{
+    if (M_Rects.empty()) return 0.0;
+    uint64_t count = 0;
+    for (unsigned char byte : M_Bits)
+    {
+        for (; byte; byte &= byte - 1) ++count; // Popcount
+    }
+    return static_cast<double>(count) / M_Rects.size();
+}
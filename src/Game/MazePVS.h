@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Maze.h"
+
+// Potentially visible set for a fixed maze.
+// For every cell we store which cells can be seen from anywhere inside it, so wall culling
+// at runtime is a table lookup instead of a visibility query.
+//
+// Storage is bit-packed: each cell keeps the bounding rectangle of its visible cells and one
+// bit per cell inside that rectangle. Line of sight in a maze rarely spans more than a few
+// corridors, so the rectangles stay small even for very large mazes.
+class MazePVS
+{
+public:
+    // Bake settings. Visibility is not sampled: a cell is in the set if any straight line from
+    // inside the source cell reaches it through open cell edges, so no visible cell is ever
+    // missed. Walls count as infinitely thin, which can only add cells.
+    struct BakeSettings
+    {
+        float maxDistance = 100.0f; // Matches the camera far plane
+        unsigned int threadCount = 0; // 0 = use all hardware threads
+    };
+
+    MazePVS();
+
+    // Compute the PVS for the maze. Runs in parallel across worker threads.
+    void Bake(const Maze& maze, const BakeSettings& settings);
+    void Bake(const Maze& maze) { Bake(maze, BakeSettings()); }
+
+    // Save/load the compressed PVS. Loading fails if the file was baked from a different layout.
+    bool SaveToFile(const std::string& path) const;
+    bool LoadFromFile(const std::string& path, const Maze& maze);
+
+    // Conventional cache location next to a maze file
+    static std::string CachePathFor(const std::string& mazePath) { return mazePath + ".pvs"; }
+
+    bool IsReady() const { return !M_Rects.empty(); }
+
+    // Is cell (toX, toY) potentially visible from anywhere inside cell (fromX, fromY)?
+    bool IsVisible(int fromX, int fromY, int toX, int toY) const;
+
+    // Bounding rectangle (inclusive) of the cells visible from (x, y). Callers iterate this
+    // rectangle and test IsVisible to walk the set.
+    void GetVisibleBounds(int x, int y, int& minX, int& minY, int& maxX, int& maxY) const;
+
+    // Stats for reporting
+    double GetBakeTimeMs() const { return M_BakeTimeMs; }
+    size_t GetMemoryUsage() const;
+    double GetAverageVisibleCells() const;
+
+private:
+    struct CellRect
+    {
+        uint16_t minX, minY, maxX, maxY;
+    };
+
+    int M_Width;
+    int M_Height;
+    uint64_t M_LayoutHash;
+    double M_BakeTimeMs;
+
+    std::vector<CellRect> M_Rects;     // One per cell, row-major
+    std::vector<uint64_t> M_Offsets;   // Byte offset of each cell's bits in M_Bits
+    std::vector<unsigned char> M_Bits; // Packed visibility bits
+
+    void rebuildOffsets();
+};
@@ -0,0 +1,384 @@
+#include "MazeText.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+    const size_t BAND_BYTES = 4 << 20;  // Target text size of one band
+    const size_t CHUNK_BYTES = 1 << 20; // Read size of the parser
+
+    struct Glyph {
+        const char* bytes;
+        size_t length;
+    };
+
+    // Box-drawing junctions (UTF-8) by the walls meeting there: up 1, right 2, down 4, left 8
+    const Glyph JUNCTIONS[16] = {
+        { " ", 1 },            { "\xE2\x95\xB5", 3 }, { "\xE2\x95\xB6", 3 }, { "\xE2\x94\x94", 3 },
+        { "\xE2\x95\xB7", 3 }, { "\xE2\x94\x82", 3 }, { "\xE2\x94\x8C", 3 }, { "\xE2\x94\x9C", 3 },
+        { "\xE2\x95\xB4", 3 }, { "\xE2\x94\x98", 3 }, { "\xE2\x94\x80", 3 }, { "\xE2\x94\xB4", 3 },
+        { "\xE2\x94\x90", 3 }, { "\xE2\x94\xA4", 3 }, { "\xE2\x94\xAC", 3 }, { "\xE2\x94\xBC", 3 },
+    };
+    const Glyph HORIZONTAL_WALL = { "\xE2\x94\x80\xE2\x94\x80\xE2\x94\x80", 9 };
+    const Glyph VERTICAL_WALL = { "\xE2\x94\x82", 3 };
+
+    inline char* put(char* p, const Glyph& glyph) {
+        std::memcpy(p, glyph.bytes, glyph.length);
+        return p + glyph.length;
+    }
+
+    // Upper bound of one line's size, newline included
+    size_t lineBytes(int width, MazeTextStyle style) {
+        const size_t glyphs = static_cast<size_t>(width) * 4 + 1;
+        return (style == MazeTextStyle::Ascii ? glyphs : glyphs * 3) + 1;
+    }
+
+    // The border line above row y (y == height: the bottom border). above/below are the wall
+    // bits of rows y - 1 and y, each only read if that row exists.
+    char* borderLine(char* p, const unsigned char* above, const unsigned char* below, int y, int width, int height,
+                     MazeTextStyle style) {
+        auto horizontal = [&](int x) { return y < height ? (below[x] & WALL_TOP) != 0 : (above[x] & WALL_BOTTOM) != 0; };
+        if (style == MazeTextStyle::Ascii) {
+            for (int x = 0; x < width; ++x) {
+                *p++ = '+';
+                std::memcpy(p, horizontal(x) ? "---" : "   ", 3);
+                p += 3;
+            }
+            *p++ = '+';
+        }
+        else {
+            for (int x = 0; x <= width; ++x) {
+                int arms = 0;
+                if (y > 0 && (x < width ? above[x] & WALL_LEFT : above[width - 1] & WALL_RIGHT)) arms |= 1;
+                if (x < width && horizontal(x)) arms |= 2;
+                if (y < height && (x < width ? below[x] & WALL_LEFT : below[width - 1] & WALL_RIGHT)) arms |= 4;
+                if (x > 0 && horizontal(x - 1)) arms |= 8;
+                p = put(p, JUNCTIONS[arms]);
+                if (x < width) {
+                    if (horizontal(x)) {
+                        p = put(p, HORIZONTAL_WALL);
+                    }
+                    else {
+                        std::memcpy(p, "   ", 3);
+                        p += 3;
+                    }
+                }
+            }
+        }
+        *p++ = '\n';
+        return p;
+    }
+
+    char* cellLine(char* p, const Cell* row, const unsigned char* bits, int width, MazeTextStyle style) {
+        for (int x = 0; x < width; ++x) {
+            if (!(bits[x] & WALL_LEFT))
+                *p++ = ' ';
+            else if (style == MazeTextStyle::Ascii)
+                *p++ = '|';
+            else
+                p = put(p, VERTICAL_WALL);
+            p[0] = ' ';
+            p[1] = row[x].isStart ? 'S' : row[x].isEnd ? 'E' : ' ';
+            p[2] = ' ';
+            p += 3;
+        }
+        if (!(bits[width - 1] & WALL_RIGHT))
+            *p++ = ' ';
+        else if (style == MazeTextStyle::Ascii)
+            *p++ = '|';
+        else
+            p = put(p, VERTICAL_WALL);
+        *p++ = '\n';
+        return p;
+    }
+
+    // Renders rows [y0, y1), each with the border above it, plus the bottom border if the
+    // band is the last one. Returns the number of bytes written.
+    size_t renderBand(const Maze& maze, int y0, int y1, MazeTextStyle style, char* out) {
+        const int width = maze.GetWidth();
+        const int height = maze.GetHeight();
+        std::vector<unsigned char> above(width), below(width);
+        if (y0 > 0)
+            maze.BuildWallRow(y0 - 1, above.data());
+
+        char* p = out;
+        const int lastBorder = y1 == height ? height : y1 - 1;
+        for (int y = y0; y <= lastBorder; ++y) {
+            if (y < height)
+                maze.BuildWallRow(y, below.data());
+            p = borderLine(p, above.data(), below.data(), y, width, height, style);
+            if (y == height)
+                break;
+            p = cellLine(p, &maze.GetCell(0, y), below.data(), width, style);
+            std::swap(above, below);
+        }
+        return static_cast<size_t>(p - out);
+    }
+
+    // Consumes the text line by line. Glyphs are compared as ASCII; a line that isn't plain
+    // ASCII (box drawing) is first reduced to one character per glyph, '#' for non-ASCII ones.
+    class TextParser {
+    public:
+        // False if the line is malformed (and reported)
+        bool Line(const char* begin, const char* end);
+        // A complete grid has been followed by a line that isn't part of it
+        bool IsDone() const { return M_Done; }
+        std::unique_ptr<Maze> Finish();
+
+    private:
+        int M_Width = 0;
+        size_t M_Glyphs = 0; // Per line: 4 * width + 1
+        int M_LineNumber = 0;
+        int M_Rows = 0;
+        bool M_Done = false;
+        std::vector<unsigned char> M_Walls;  // WallBits per parsed cell, row-major
+        std::vector<unsigned char> M_Border; // Walls of the last border line, per column
+        std::string M_Normalized;
+        glm::ivec2 M_Start = glm::ivec2(-1, -1);
+        glm::ivec2 M_End = glm::ivec2(-1, -1);
+
+        bool fail(const std::string& message) const {
+            std::cerr << "Maze text, line " << M_LineNumber << ": " << message << std::endl;
+            return false;
+        }
+    };
+
+    bool TextParser::Line(const char* begin, const char* end) {
+        ++M_LineNumber;
+        if (end > begin && end[-1] == '\r')
+            --end;
+        const char* glyphs = begin;
+        size_t count = static_cast<size_t>(end - begin);
+        if (count != M_Glyphs) {
+            // Maybe UTF-8: reduce to one byte per glyph
+            M_Normalized.clear();
+            for (const char* p = begin; p < end;) {
+                const unsigned char lead = static_cast<unsigned char>(*p);
+                const int length = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : 1;
+                M_Normalized += lead < 0x80 ? *p : '#';
+                p += std::min<ptrdiff_t>(length, end - p);
+            }
+            glyphs = M_Normalized.data();
+            count = M_Normalized.size();
+        }
+
+        if (M_Glyphs == 0) {
+            if (count < 5 || (count - 1) % 4 != 0 || (glyphs[0] != '+' && glyphs[0] != '#' && glyphs[0] != ' '))
+                return fail("not a maze border line");
+            M_Glyphs = count;
+            M_Width = static_cast<int>((count - 1) / 4);
+            M_Border.assign(M_Width, 0);
+        }
+
+        // Odd lines are borders, even lines cell rows
+        const bool border = M_LineNumber % 2 == 1;
+        const char first = count > 0 ? glyphs[0] : '\0';
+        const bool gridLine = count == M_Glyphs && (first == ' ' || first == '#' || first == (border ? '+' : '|'));
+        if (!gridLine) {
+            // Where a cell line would follow, a line that can't be one (e.g. the legend) means the
+            // last border was the bottom one. Anything that looks like a cell line (full length,
+            // or a wall or space first) is a damaged row, not the end of the maze.
+            const bool cellLike = count == M_Glyphs || first == '|' || first == '#' || first == ' ';
+            if (!border && M_Rows > 0 && !cellLike) {
+                M_Done = true;
+                return true;
+            }
+            return fail("expected a " + std::string(border ? "border" : "cell") + " line of " + std::to_string(M_Glyphs) + " characters");
+        }
+
+        if (border) {
+            for (int x = 0; x <= M_Width; ++x) {
+                const char corner = glyphs[4 * x];
+                if (corner != '+' && corner != '#' && corner != ' ')
+                    return fail("unexpected '" + std::string(1, corner) + "' at column " + std::to_string(4 * x + 1));
+                if (x == M_Width)
+                    break;
+                const char edge = glyphs[4 * x + 1];
+                if ((edge != ' ' && edge != '-' && edge != '#') || glyphs[4 * x + 2] != edge || glyphs[4 * x + 3] != edge)
+                    return fail("malformed wall at column " + std::to_string(4 * x + 2));
+            }
+            unsigned char* previous = M_Rows > 0 ? &M_Walls[static_cast<size_t>(M_Rows - 1) * M_Width] : nullptr;
+            for (int x = 0; x < M_Width; ++x) {
+                const bool wall = glyphs[4 * x + 2] != ' ';
+                M_Border[x] = wall;
+                if (previous && wall)
+                    previous[x] |= WALL_BOTTOM;
+            }
+            return true;
+        }
+
+        for (int x = 0; x <= M_Width; ++x) {
+            const char wall = glyphs[4 * x];
+            if (wall != ' ' && wall != '|' && wall != '#')
+                return fail("unexpected '" + std::string(1, wall) + "' at column " + std::to_string(4 * x + 1));
+        }
+        M_Walls.resize(M_Walls.size() + M_Width);
+        unsigned char* row = &M_Walls[static_cast<size_t>(M_Rows) * M_Width];
+        for (int x = 0; x < M_Width; ++x) {
+            // Cell contents: S, E, P (PrintToConsole's player) or nothing, padded with spaces
+            const char content = glyphs[4 * x + 2];
+            if (glyphs[4 * x + 1] != ' ' || glyphs[4 * x + 3] != ' ' ||
+                (content != ' ' && content != 'S' && content != 'E' && content != 'P'))
+                return fail("unexpected cell contents at column " + std::to_string(4 * x + 3));
+            if (content == 'S') {
+                if (M_Start.x >= 0)
+                    return fail("second start marker S at column " + std::to_string(4 * x + 3));
+                M_Start = glm::ivec2(x, M_Rows);
+            }
+            else if (content == 'E') {
+                if (M_End.x >= 0)
+                    return fail("second exit marker E at column " + std::to_string(4 * x + 3));
+                M_End = glm::ivec2(x, M_Rows);
+            }
+
+            unsigned char bits = M_Border[x] ? WALL_TOP : 0;
+            if (glyphs[4 * x] != ' ') bits |= WALL_LEFT;
+            if (glyphs[4 * x + 4] != ' ') bits |= WALL_RIGHT;
+            row[x] = bits;
+        }
+        ++M_Rows;
+        return true;
+    }
+
+    std::unique_ptr<Maze> TextParser::Finish() {
+        // The grid must end on a border line
+        if (M_Rows == 0 || (!M_Done && M_LineNumber % 2 == 0)) {
+            fail("the maze ends without a bottom border");
+            return nullptr;
+        }
+        // Written mazes carry both markers; one alone usually means the rows with the other were cut off
+        if ((M_Start.x >= 0) != (M_End.x >= 0)) {
+            fail(std::string("the maze has a ") + (M_Start.x >= 0 ? "start marker S but no exit marker E" : "exit marker E but no start marker S"));
+            return nullptr;
+        }
+        if (M_Width < 3 || M_Rows < 3) {
+            fail("mazes must be at least 3x3 cells, this one is " + std::to_string(M_Width) + "x" + std::to_string(M_Rows));
+            return nullptr;
+        }
+
+        auto maze = std::make_unique<Maze>(M_Width, M_Rows, 1); // The seed is unused
+        for (int y = 0; y < M_Rows; ++y) {
+            for (int x = 0; x < M_Width; ++x)
+                maze->SetCellWalls(x, y, M_Walls[static_cast<size_t>(y) * M_Width + x]);
+        }
+        maze->SetStartCell(M_Start.x >= 0 ? M_Start.x : 0, M_Start.x >= 0 ? M_Start.y : 0);
+        maze->SetEndCell(M_End.x >= 0 ? M_End.x : M_Width - 1, M_End.x >= 0 ? M_End.y : M_Rows - 1);
+        return maze;
+    }
+}
+
+bool WriteMazeText(const Maze& maze, std::ostream& out, MazeTextStyle style)
+{
+    const int width = maze.GetWidth();
+    const int height = maze.GetHeight();
+    const size_t line = lineBytes(width, style);
+    const int rowsPerBand = static_cast<int>(std::max<size_t>(1, std::min<size_t>(height, BAND_BYTES / (2 * line))));
+    const int bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+    const int threadCount = std::min(bandCount, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+
+    // Two sets of band buffers: one wave of bands is written out while the next one renders
+    struct Band {
+        std::vector<char> text;
+        size_t length = 0;
+    };
+    std::vector<Band> waves[2];
+    for (std::vector<Band>& wave : waves) {
+        wave.resize(threadCount);
+        for (Band& band : wave)
+            band.text.resize((static_cast<size_t>(rowsPerBand) * 2 + 1) * line);
+    }
+
+    auto writeWave = [&out](const std::vector<Band>& wave, int count) {
+        for (int i = 0; i < count; ++i)
+            out.write(wave[i].text.data(), static_cast<std::streamsize>(wave[i].length));
+    };
+
+    int pending = 0; // Bands of the previous wave not yet written
+    int wave = 0;
+    for (int firstBand = 0; firstBand < bandCount; firstBand += threadCount, ++wave) {
+        std::vector<Band>& bands = waves[wave % 2];
+        const int count = std::min(threadCount, bandCount - firstBand);
+        std::atomic<int> nextBand(0);
+        auto worker = [&]() {
+            for (int i = nextBand++; i < count; i = nextBand++) {
+                const int y0 = (firstBand + i) * rowsPerBand;
+                bands[i].length = renderBand(maze, y0, std::min(height, y0 + rowsPerBand), style, bands[i].text.data());
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < count; ++i)
+            threads.emplace_back(worker);
+        writeWave(waves[(wave + 1) % 2], pending); // Main thread writes meanwhile
+        for (auto& t : threads)
+            t.join();
+        pending = count;
+    }
+    writeWave(waves[(wave + 1) % 2], pending);
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+bool SaveMazeText(const Maze& maze, const std::string& path, MazeTextStyle style)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    if (!WriteMazeText(maze, file, style)) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Maze> ReadMazeText(std::istream& in)
+{
+    TextParser parser;
+    std::vector<char> chunk(CHUNK_BYTES);
+    std::string carry; // Start of a line that continues in the next chunk
+    while (!parser.IsDone() && in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const size_t count = static_cast<size_t>(in.gcount());
+        const char* p = chunk.data();
+        const char* end = p + count;
+        while (!parser.IsDone()) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!newline) {
+                carry.append(p, end);
+                break;
+            }
+            bool parsed;
+            if (carry.empty()) {
+                parsed = parser.Line(p, newline);
+            }
+            else {
+                carry.append(p, newline);
+                parsed = parser.Line(carry.data(), carry.data() + carry.size());
+                carry.clear();
+            }
+            if (!parsed)
+                return nullptr;
+            p = newline + 1;
+        }
+    }
+    // The last line may lack its newline
+    if (!parser.IsDone() && !carry.empty() && !parser.Line(carry.data(), carry.data() + carry.size()))
+        return nullptr;
+    return parser.Finish();
+}
+
+std::unique_ptr<Maze> LoadMazeText(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open maze file " << path << std::endl;
+        return nullptr;
+    }
+    return ReadMazeText(file);
+}
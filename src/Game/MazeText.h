@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Maze.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Text form of a maze, for diffing, hand editing and exchanging very large mazes.
+// Ascii is Maze::PrintToConsole's layout without the legend: per cell row a border line
+// ("+---+   +") and a cell line ("| S |   |"), then the bottom border, with S and E marking
+// the start and exit. Unicode draws the same grid with box-drawing characters (UTF-8).
+// Walls are written as Maze::BuildWallMask sees them, shared by the two cells on either side.
+enum class MazeTextStyle { Ascii, Unicode };
+
+// Rows are rendered in bands on all cores into preallocated buffers, each written with a
+// single write while the next bands render; memory stays bounded for any maze size.
+// Returns false if the stream failed.
+bool WriteMazeText(const Maze& maze, std::ostream& out, MazeTextStyle style = MazeTextStyle::Ascii);
+bool SaveMazeText(const Maze& maze, const std::string& path, MazeTextStyle style = MazeTextStyle::Ascii);
+
+// Streaming parser for either style (also accepts PrintToConsole output, and CRLF line ends).
+// The text is read in large chunks and never held whole. The grid ends after a border line
+// at the first line that can't be a cell line (e.g. the legend); a truncated or malformed
+// line within the grid, unknown cell contents, a second S or E marker, or only one of the two
+// is an error. Without S and E markers the start is the top-left cell and the exit the
+// bottom-right one. Returns nullptr (after reporting the offending line) if the text isn't a
+// maze of at least 3x3 cells.
+std::unique_ptr<Maze> ReadMazeText(std::istream& in);
+std::unique_ptr<Maze> LoadMazeText(const std::string& path);
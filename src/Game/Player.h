@@ -1,7 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include "../Graphics/Camera.h"
+#include "../Graphics/camera.h"
 #include "Maze.h"
 
 // Represents the player in the game
@@ -26,6 +26,9 @@ public:
     // Check if player is at the exit
     bool IsAtExit(const Maze& maze) const;
 
+    // Check if a position would collide with maze walls
+    bool CheckCollision(const glm::vec3& position, const Maze& maze) const;
+
 private:
     // Reference to the camera (player's view)
     Camera& m_Camera;
@@ -38,9 +41,6 @@ private:
     int m_CellX;
     int m_CellY;
 
-    // Check if a position would collide with maze walls
-    bool CheckCollision(const glm::vec3& position, const Maze& maze) const;
-
     // Update current cell coordinates based on position
     void UpdateCurrentCell();
 };
\ No newline at end of file
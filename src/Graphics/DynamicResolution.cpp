@@ -0,0 +1,146 @@
+#include "DynamicResolution.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+DynamicResolution::DynamicResolution(const Settings& settings)
+    : M_Settings(settings), M_Framebuffer(0), M_ColorTexture(0), M_DepthBuffer(0), M_TargetWidth(0), M_TargetHeight(0),
+      M_WindowWidth(0), M_WindowHeight(0), M_ViewportWidth(0), M_ViewportHeight(0), M_OutputFramebuffer(0), M_CurrentFrame(0), M_Active(false)
+{
+    M_Settings.minScale = std::max(M_Settings.minScale, 0.1f);
+    M_Settings.maxScale = std::max(M_Settings.maxScale, M_Settings.minScale);
+    M_Settings.step = std::max(M_Settings.step, 0.001f);
+    M_Scale = M_Settings.maxScale;
+
+    for (Frame& frame : M_Frames)
+    {
+        glGenQueries(2, frame.queries);
+        frame.scale = M_Scale;
+        frame.pending = false;
+    }
+    glGenFramebuffers(1, &M_Framebuffer);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    for (Frame& frame : M_Frames)
+        glDeleteQueries(2, frame.queries);
+    glDeleteFramebuffers(1, &M_Framebuffer);
+    if (M_ColorTexture != 0)
+    {
+        GLStateCache::OnTextureDeleted(M_ColorTexture);
+        glDeleteTextures(1, &M_ColorTexture);
+    }
+    if (M_DepthBuffer != 0)
+        glDeleteRenderbuffers(1, &M_DepthBuffer);
+}
+
+void DynamicResolution::Begin(int windowWidth, int windowHeight)
+{
+    if (windowWidth != M_WindowWidth || windowHeight != M_WindowHeight)
+        allocate(windowWidth, windowHeight);
+
+    // The measurement issued FRAME_LATENCY frames ago drives this frame's scale
+    M_CurrentFrame = (M_CurrentFrame + 1) % FRAME_LATENCY;
+    Frame& frame = M_Frames[M_CurrentFrame];
+    if (frame.pending)
+        collect(frame);
+
+    M_ViewportWidth = std::max(1, static_cast<int>(std::lround(M_WindowWidth * M_Scale)));
+    M_ViewportHeight = std::max(1, static_cast<int>(std::lround(M_WindowHeight * M_Scale)));
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &M_OutputFramebuffer); // Usually the window, or a headless target
+    glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffer);
+    glViewport(0, 0, M_ViewportWidth, M_ViewportHeight);
+
+    glQueryCounter(frame.queries[0], GL_TIMESTAMP);
+    frame.scale = M_Scale;
+    M_Active = true;
+
+    ++M_Stats.frames;
+    M_Stats.scaleTotal += M_Scale;
+    if (M_Scale <= M_Settings.minScale)
+        ++M_Stats.framesAtMinimum;
+}
+
+void DynamicResolution::Resolve()
+{
+    if (!M_Active)
+        return;
+    Frame& frame = M_Frames[M_CurrentFrame];
+    glQueryCounter(frame.queries[1], GL_TIMESTAMP);
+    frame.pending = true;
+    M_Active = false;
+
+    // Bilinear upscale of the rendered part into the window
+    const GLuint output = static_cast<GLuint>(M_OutputFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, M_Framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+    glBlitFramebuffer(0, 0, M_ViewportWidth, M_ViewportHeight, 0, 0, M_WindowWidth, M_WindowHeight,
+                      GL_COLOR_BUFFER_BIT, M_ViewportWidth == M_WindowWidth ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, M_WindowWidth, M_WindowHeight);
+}
+
+void DynamicResolution::allocate(int width, int height)
+{
+    M_WindowWidth = std::max(1, width);
+    M_WindowHeight = std::max(1, height);
+    M_TargetWidth = std::max(1, static_cast<int>(std::ceil(M_WindowWidth * M_Settings.maxScale)));
+    M_TargetHeight = std::max(1, static_cast<int>(std::ceil(M_WindowHeight * M_Settings.maxScale)));
+
+    if (M_ColorTexture == 0)
+        glGenTextures(1, &M_ColorTexture);
+    // Called from EndScene, so the active unit may still hold one of the pass's textures
+    GLStateCache::BindTextureForUpload(GL_TEXTURE_2D, M_ColorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, M_TargetWidth, M_TargetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    if (M_DepthBuffer == 0)
+        glGenRenderbuffers(1, &M_DepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, M_DepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, M_TargetWidth, M_TargetHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, M_ColorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, M_DepthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "DynamicResolution: offscreen framebuffer is incomplete" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    std::cout << "Dynamic resolution: " << M_TargetWidth << "x" << M_TargetHeight << " target, scale "
+              << M_Settings.minScale << "-" << M_Settings.maxScale << " for " << M_Settings.targetMs << " ms" << std::endl;
+}
+
+void DynamicResolution::collect(Frame& frame)
+{
+    frame.pending = false;
+    // Never stall: a result that isn't ready yet is just skipped
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+    float gpuMs = static_cast<float>((end - start) / 1.0e6);
+    M_Stats.lastGpuMs = gpuMs;
+    M_Stats.gpuMsTotal += gpuMs;
+    ++M_Stats.samples;
+    if (gpuMs <= 0.0f)
+        return;
+
+    // Pixel cost goes with scale^2: this is the scale that would have hit the target
+    float ideal = frame.scale * std::sqrt(M_Settings.targetMs / gpuMs);
+    ideal = std::min(std::max(ideal, M_Settings.minScale), M_Settings.maxScale);
+    float next = M_Scale + (ideal - M_Scale) * M_Settings.smoothing;
+    next = std::round(next / M_Settings.step) * M_Settings.step;
+    // Smoothing alone would stall within a step of the ideal; close that gap one step at a time
+    if (next == M_Scale && std::fabs(ideal - M_Scale) >= M_Settings.step)
+        next = M_Scale + (ideal > M_Scale ? M_Settings.step : -M_Settings.step);
+    M_Scale = std::min(std::max(next, M_Settings.minScale), M_Settings.maxScale);
+}
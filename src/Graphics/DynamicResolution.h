@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+// Renders the scene into an offscreen target at a fraction of the window resolution and
+// upscales it, picking the fraction every frame to hold a GPU time budget.
+// The scene's GPU time is measured with a pair of GL_TIMESTAMP queries (these don't conflict
+// with GpuTimer's GL_TIME_ELAPSED ones) and read FRAME_LATENCY frames later, so the CPU
+// never waits. Fragment cost scales with the pixel count, i.e. with scale squared, so the
+// controller moves the scale towards measured scale * sqrt(target / measured), smoothed and
+// in fixed steps so it doesn't hunt.
+// The target is allocated once at maxScale; lower scales just use a smaller viewport of it.
+//
+// Used by Renderer::EndScene: Begin before the scene passes, Resolve before the overlays.
+class DynamicResolution {
+public:
+    static const int FRAME_LATENCY = 4;
+
+    struct Settings {
+        float targetMs = 12.0f;  // GPU budget for the scene passes (leaves room for the rest of a 60 Hz frame)
+        float minScale = 0.5f;   // Per axis
+        float maxScale = 1.0f;
+        float step = 1.0f / 32.0f; // Scale changes are multiples of this
+        float smoothing = 0.25f;   // Fraction of the way to the ideal scale per update
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t samples = 0;       // Frames whose GPU time was read back
+        double gpuMsTotal = 0.0;
+        double scaleTotal = 0.0;    // Sum over frames, for the average
+        uint64_t framesAtMinimum = 0;
+        float lastGpuMs = 0.0f;
+    };
+
+    explicit DynamicResolution(const Settings& settings);
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // Updates the scale from finished measurements, binds the offscreen target with a viewport
+    // of the scaled size and starts timing. The caller clears it.
+    void Begin(int windowWidth, int windowHeight);
+
+    // Stops timing and upscales into the framebuffer that was bound at Begin, restoring the
+    // full viewport
+    void Resolve();
+
+    float GetScale() const { return M_Scale; }
+    const Settings& GetSettings() const { return M_Settings; }
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    struct Frame {
+        GLuint queries[2]; // Start, end timestamps
+        float scale;       // Scale the frame was rendered at
+        bool pending;
+    };
+
+    Settings M_Settings;
+    float M_Scale;
+    GLuint M_Framebuffer;
+    GLuint M_ColorTexture;
+    GLuint M_DepthBuffer;
+    int M_TargetWidth;     // Allocated size (window size at maxScale)
+    int M_TargetHeight;
+    int M_WindowWidth;
+    int M_WindowHeight;
+    int M_ViewportWidth;   // Scaled size rendered this frame
+    int M_ViewportHeight;
+    GLint M_OutputFramebuffer; // Bound when Begin was called; Resolve draws into it
+    Frame M_Frames[FRAME_LATENCY];
+    int M_CurrentFrame;
+    bool M_Active;         // Between Begin and Resolve
+    Stats M_Stats;
+
+    void allocate(int width, int height);
+    void collect(Frame& frame);
+};
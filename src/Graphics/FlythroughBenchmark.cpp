@@ -0,0 +1,238 @@
+#include "FlythroughBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void writeSummary(std::ostream& out, const char* key, const FlythroughBenchmark::Summary& summary, bool last = false) {
+        out << "  \"" << key << "\": {\"avg\": " << summary.average << ", \"p50\": " << summary.p50 << ", \"p95\": "
+            << summary.p95 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}" << (last ? "\n" : ",\n");
+    }
+
+    std::string escapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    void printSummary(const char* label, const FlythroughBenchmark::Summary& summary) {
+        std::cout << "  " << label << ": avg " << summary.average << ", p50 " << summary.p50 << ", p95 " << summary.p95
+                  << ", p99 " << summary.p99 << ", max " << summary.max << std::endl;
+    }
+}
+
+FlythroughBenchmark::FlythroughBenchmark(const Maze& maze, const Settings& settings)
+    : M_Settings(settings), M_MazeWidth(maze.GetWidth()), M_MazeHeight(maze.GetHeight()),
+      M_LayoutHash(maze.ComputeLayoutHash()), M_FrameIndex(0),
+      M_RecordedFrames(0), M_Yaw(0.0f), M_GpuWaits(0), M_HasPreviousFrame(false), M_Recording(false)
+{
+    M_Settings.cellsPerFrame = std::max(M_Settings.cellsPerFrame, 0.001f);
+    M_Settings.warmupFrames = std::max(M_Settings.warmupFrames, 0);
+
+    for (const glm::ivec2& cell : maze.FindPath(maze.GetStartCellCoords(), maze.GetEndCellCoords()))
+        M_Path.push_back(glm::vec3(cell.x + 0.5f, M_Settings.eyeHeight, cell.y + 0.5f));
+    if (!IsValid())
+    {
+        std::cerr << "Flythrough: no path from the start to the exit" << std::endl;
+        return;
+    }
+
+    // Cells are one unit apart, so the path is (cells - 1) long
+    M_RecordedFrames = static_cast<int>((M_Path.size() - 1) / M_Settings.cellsPerFrame) + 1;
+    M_Samples.reserve(M_RecordedFrames);
+    for (QueryFrame& frame : M_QueryFrames)
+        glGenQueries(2, frame.queries);
+    std::cout << "Flythrough: " << M_Path.size() << " cells, " << M_RecordedFrames << " frames after "
+              << M_Settings.warmupFrames << " warm-up frames" << std::endl;
+}
+
+FlythroughBenchmark::~FlythroughBenchmark()
+{
+    if (!IsValid())
+        return;
+    for (QueryFrame& frame : M_QueryFrames)
+        glDeleteQueries(2, frame.queries);
+}
+
+glm::vec3 FlythroughBenchmark::pointAt(float distance) const
+{
+    const float length = static_cast<float>(M_Path.size() - 1);
+    distance = std::min(std::max(distance, 0.0f), length);
+    const size_t segment = std::min(static_cast<size_t>(distance), M_Path.size() - 2);
+    return glm::mix(M_Path[segment], M_Path[segment + 1], distance - segment);
+}
+
+bool FlythroughBenchmark::BeginFrame(Camera& camera)
+{
+    if (!IsValid())
+        return false;
+
+    // The previous frame's interval ends here, after its buffer swap
+    if (M_HasPreviousFrame)
+        M_Samples.back().frameMs = elapsedMs(M_FrameStart);
+    M_HasPreviousFrame = false;
+
+    const int pathFrame = M_FrameIndex - M_Settings.warmupFrames;
+    if (pathFrame >= M_RecordedFrames)
+        return false;
+    M_Recording = pathFrame >= 0;
+
+    // Look towards a point further along the path; at the end, keep the last heading
+    const float distance = std::max(pathFrame, 0) * M_Settings.cellsPerFrame;
+    const glm::vec3 position = pointAt(distance);
+    const glm::vec3 ahead = pointAt(distance + M_Settings.lookAhead) - position;
+    if (ahead.x * ahead.x + ahead.z * ahead.z > 1.0e-6f)
+        M_Yaw = glm::degrees(std::atan2(ahead.z, ahead.x));
+    camera.Position = position;
+    camera.Yaw = M_Yaw;
+    camera.Pitch = 0.0f;
+    camera.UpdateCameraVectors();
+
+    if (M_Recording)
+    {
+        QueryFrame& frame = M_QueryFrames[M_Samples.size() % QUERY_FRAMES];
+        if (frame.sample >= 0)
+            collect(frame);
+        M_Samples.push_back(Sample());
+        glQueryCounter(frame.queries[0], GL_TIMESTAMP);
+    }
+    M_FrameStart = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void FlythroughBenchmark::EndFrame(const Renderer::Stats& stats)
+{
+    if (M_Recording)
+    {
+        Sample& sample = M_Samples.back();
+        sample.cpuMs = elapsedMs(M_FrameStart);
+        sample.stats = stats;
+        QueryFrame& frame = M_QueryFrames[(M_Samples.size() - 1) % QUERY_FRAMES];
+        glQueryCounter(frame.queries[1], GL_TIMESTAMP);
+        frame.sample = static_cast<int>(M_Samples.size() - 1);
+        M_HasPreviousFrame = true;
+    }
+    ++M_FrameIndex;
+}
+
+void FlythroughBenchmark::collect(QueryFrame& frame)
+{
+    // Every frame needs its time, so a result that isn't ready is waited for (and counted:
+    // frequent waits mean the CPU runs more than QUERY_FRAMES frames ahead of the GPU)
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        ++M_GpuWaits;
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+    M_Samples[frame.sample].gpuMs = end > start ? (end - start) / 1.0e6 : 0.0;
+    frame.sample = -1;
+}
+
+FlythroughBenchmark::Summary FlythroughBenchmark::summarize(std::vector<double> values)
+{
+    Summary summary;
+    if (values.empty())
+        return summary;
+    std::sort(values.begin(), values.end());
+    // Nearest rank
+    auto percentile = [&values](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+        return values[std::min(std::max<size_t>(rank, 1), values.size()) - 1];
+    };
+    double sum = 0.0;
+    for (double value : values)
+        sum += value;
+    summary.average = sum / values.size();
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = values.back();
+    return summary;
+}
+
+bool FlythroughBenchmark::Finish(int screenWidth, int screenHeight)
+{
+    if (!IsValid())
+        return false;
+    if (M_HasPreviousFrame)
+    {
+        M_Samples.back().frameMs = elapsedMs(M_FrameStart);
+        M_HasPreviousFrame = false;
+    }
+    for (QueryFrame& frame : M_QueryFrames)
+    {
+        if (frame.sample >= 0)
+            collect(frame);
+    }
+    if (M_Samples.empty())
+    {
+        std::cerr << "Flythrough: no frames were recorded" << std::endl;
+        return false;
+    }
+
+    std::vector<double> cpuMs, frameMs, gpuMs, drawCalls, shaderChanges, textureChanges;
+    for (const Sample& sample : M_Samples)
+    {
+        cpuMs.push_back(sample.cpuMs);
+        frameMs.push_back(sample.frameMs);
+        gpuMs.push_back(sample.gpuMs);
+        drawCalls.push_back(sample.stats.drawCalls);
+        shaderChanges.push_back(sample.stats.shaderChanges);
+        textureChanges.push_back(sample.stats.textureChanges);
+    }
+    const Summary cpu = summarize(cpuMs), frame = summarize(frameMs), gpu = summarize(gpuMs);
+    const Summary draws = summarize(drawCalls), shaders = summarize(shaderChanges), textures = summarize(textureChanges);
+    const bool complete = static_cast<int>(M_Samples.size()) == M_RecordedFrames;
+
+    std::cout << "Flythrough: " << M_Samples.size() << " frames" << (complete ? "" : " (interrupted)") << ", "
+              << (frame.average > 0.0 ? 1000.0 / frame.average : 0.0) << " fps average, " << M_GpuWaits
+              << " waits for GPU times" << std::endl;
+    printSummary("Frame ms", frame);
+    printSummary("CPU ms", cpu);
+    printSummary("GPU ms", gpu);
+    printSummary("Draw calls", draws);
+
+    std::ofstream file(M_Settings.outputPath);
+    if (!file)
+    {
+        std::cerr << "Flythrough: failed to write " << M_Settings.outputPath << std::endl;
+        return false;
+    }
+    file << "{\n";
+    if (M_Settings.mazeFile.empty())
+        file << "  \"seed\": " << M_Settings.seed << ",\n";
+    else
+        file << "  \"maze_file\": \"" << escapeJson(M_Settings.mazeFile) << "\",\n";
+    // A string: JSON numbers can't hold 64 bits exactly
+    file << "  \"layout_hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << M_LayoutHash << std::dec << std::setfill(' ') << "\",\n"
+         << "  \"maze\": [" << M_MazeWidth << ", " << M_MazeHeight << "],\n"
+         << "  \"path_cells\": " << M_Path.size() << ",\n"
+         << "  \"resolution\": [" << screenWidth << ", " << screenHeight << "],\n"
+         << "  \"cells_per_frame\": " << M_Settings.cellsPerFrame << ",\n"
+         << "  \"frames\": " << M_Samples.size() << ",\n"
+         << "  \"complete\": " << (complete ? "true" : "false") << ",\n"
+         << "  \"gpu_waits\": " << M_GpuWaits << ",\n";
+    writeSummary(file, "frame_ms", frame);
+    writeSummary(file, "cpu_ms", cpu);
+    writeSummary(file, "gpu_ms", gpu);
+    writeSummary(file, "draw_calls", draws);
+    writeSummary(file, "shader_changes", shaders);
+    writeSummary(file, "texture_changes", textures, true);
+    file << "}\n";
+    std::cout << "Wrote " << M_Settings.outputPath << std::endl;
+    return true;
+}
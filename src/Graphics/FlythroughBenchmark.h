@@ -0,0 +1,96 @@
+#pragma once
+
+#include "camera.h"
+#include "Renderer.h"
+#include "../Game/Maze.h"
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scripted camera flight along the maze's solution (start to exit), for frame-time numbers
+// that can be compared between builds. The camera advances a fixed distance per frame rather
+// than per second, so every run renders the same sequence of views at any frame rate; it looks
+// a little ahead along the path, which rounds off the corners.
+// Each recorded frame yields its CPU time (BeginFrame to EndFrame: simulation and submission),
+// the interval to the next frame (including the buffer swap), its GPU time (timestamp queries
+// around the same span) and the renderer's counters. Finish reports the average, p50, p95,
+// p99 and maximum of each, on stdout and as JSON.
+class FlythroughBenchmark {
+public:
+    struct Settings {
+        float cellsPerFrame = 0.05f; // 3 cells per second at 60 fps
+        float lookAhead = 0.75f;     // Cells along the path the camera looks towards
+        float eyeHeight = 1.0f;
+        int warmupFrames = 60;       // Rendered at the start, not recorded
+        unsigned int seed = 0;       // Only recorded in the report, for a generated maze
+        std::string mazeFile;        // Recorded instead of the seed when the maze was loaded from text
+        std::string outputPath = "flythrough.json";
+    };
+
+    struct Summary {
+        double average = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    FlythroughBenchmark(const Maze& maze, const Settings& settings);
+    ~FlythroughBenchmark();
+
+    FlythroughBenchmark(const FlythroughBenchmark&) = delete;
+    FlythroughBenchmark& operator=(const FlythroughBenchmark&) = delete;
+
+    // False if the maze has no path from start to exit
+    bool IsValid() const { return M_Path.size() > 1; }
+
+    // Places the camera for the next frame and starts timing it. Returns false once the end
+    // of the path has been rendered.
+    bool BeginFrame(Camera& camera);
+    // After the frame's EndScene, before swapping buffers
+    void EndFrame(const Renderer::Stats& stats);
+    // Deterministic animation time of the current frame (60 fps), e.g. for torch flicker
+    float GetFrameTime() const { return M_FrameIndex / 60.0f; }
+
+    // Waits for the outstanding GPU times, prints the summary and writes the JSON report
+    // (screen size is recorded in it). Returns false if the report could not be written.
+    bool Finish(int screenWidth, int screenHeight);
+
+private:
+    static const int QUERY_FRAMES = 8; // Frames in flight before a GPU time is read back
+
+    struct Sample {
+        double cpuMs = 0.0;
+        double frameMs = 0.0;
+        double gpuMs = 0.0;
+        Renderer::Stats stats;
+    };
+
+    struct QueryFrame {
+        GLuint queries[2]; // Timestamps at BeginFrame and EndFrame
+        int sample = -1;   // Sample the result belongs to; -1 when nothing is pending
+    };
+
+    Settings M_Settings;
+    int M_MazeWidth;
+    int M_MazeHeight;
+    uint64_t M_LayoutHash; // Maze::ComputeLayoutHash, identifies the maze however it was made
+    std::vector<glm::vec3> M_Path; // Cell centres at eye height
+    int M_FrameIndex;              // Including warm-up frames
+    int M_RecordedFrames;          // Path frames: path length / cellsPerFrame, plus the last
+    float M_Yaw;
+
+    std::vector<Sample> M_Samples;
+    QueryFrame M_QueryFrames[QUERY_FRAMES];
+    int M_GpuWaits; // Results that were not ready after QUERY_FRAMES frames
+    std::chrono::high_resolution_clock::time_point M_FrameStart;
+    bool M_HasPreviousFrame;
+    bool M_Recording;
+
+    glm::vec3 pointAt(float distance) const;
+    void collect(QueryFrame& frame);
+    static Summary summarize(std::vector<double> values);
+};
@@ -0,0 +1,154 @@
+#include "GLStateCache.h"
+
+namespace {
+    const GLuint UNKNOWN = 0xFFFFFFFFu; // Forces the next call through
+    const unsigned int TARGET_COUNT = 5;
+
+    // Index into the per-unit binding table, or -1 for targets we don't track
+    int targetIndex(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_2D_ARRAY: return 2;
+            case GL_TEXTURE_BUFFER: return 3;
+            case GL_TEXTURE_3D: return 4;
+            default: return -1;
+        }
+    }
+
+    struct State {
+        GLuint program = UNKNOWN;
+        GLuint vao = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        GLuint textures[GLStateCache::MAX_TEXTURE_UNITS][TARGET_COUNT];
+        GLuint depthMask = UNKNOWN;
+        GLuint depthFunc = UNKNOWN;
+        GLuint blend = UNKNOWN;
+        GLuint blendSrc = UNKNOWN;
+        GLuint blendDst = UNKNOWN;
+
+        State() { resetTextures(); }
+
+        void resetTextures() {
+            for (auto& unit : textures)
+                for (GLuint& t : unit)
+                    t = UNKNOWN;
+        }
+    };
+
+    State g_State;
+    GLStateCache::Stats g_Stats;
+
+    // Returns true if the cached value already matches; otherwise records the new value
+    bool isRedundant(GLuint& cached, GLuint value) {
+        if (cached == value) {
+            ++g_Stats.skipped;
+            return true;
+        }
+        cached = value;
+        ++g_Stats.issued;
+        return false;
+    }
+
+    void activeTexture(unsigned int unit) {
+        if (!isRedundant(g_State.activeUnit, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void GLStateCache::UseProgram(GLuint program) {
+    if (!isRedundant(g_State.program, program))
+        glUseProgram(program);
+}
+
+void GLStateCache::BindVertexArray(GLuint vao) {
+    if (!isRedundant(g_State.vao, vao))
+        glBindVertexArray(vao);
+}
+
+void GLStateCache::BindTexture(unsigned int unit, GLenum target, GLuint texture) {
+    int index = targetIndex(target);
+    if (index < 0 || unit >= MAX_TEXTURE_UNITS) {
+        // Untracked: issue unconditionally, keeping the active unit in sync
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        ++g_Stats.issued;
+        return;
+    }
+    GLuint& cached = g_State.textures[unit][index];
+    if (cached == texture) {
+        ++g_Stats.skipped;
+        return;
+    }
+    activeTexture(unit);
+    cached = texture;
+    glBindTexture(target, texture);
+    ++g_Stats.issued;
+}
+
+void GLStateCache::DepthMask(bool enabled) {
+    if (!isRedundant(g_State.depthMask, enabled ? 1u : 0u))
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::DepthFunc(GLenum func) {
+    if (!isRedundant(g_State.depthFunc, func))
+        glDepthFunc(func);
+}
+
+void GLStateCache::SetBlend(bool enabled) {
+    if (!isRedundant(g_State.blend, enabled ? 1u : 0u)) {
+        if (enabled) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+    }
+}
+
+void GLStateCache::BlendFunc(GLenum srcFactor, GLenum dstFactor) {
+    if (g_State.blendSrc == srcFactor && g_State.blendDst == dstFactor) {
+        ++g_Stats.skipped;
+        return;
+    }
+    g_State.blendSrc = srcFactor;
+    g_State.blendDst = dstFactor;
+    glBlendFunc(srcFactor, dstFactor);
+    ++g_Stats.issued;
+}
+
+void GLStateCache::BindTextureForUpload(GLenum target, GLuint texture) {
+    // Active first: BindTexture skips a redundant bind without switching units
+    activeTexture(UPLOAD_TEXTURE_UNIT);
+    BindTexture(UPLOAD_TEXTURE_UNIT, target, texture);
+}
+
+unsigned int GLStateCache::GetActiveTextureUnit() {
+    if (g_State.activeUnit == UNKNOWN) {
+        activeTexture(0); // Establish a known unit
+    }
+    return g_State.activeUnit;
+}
+
+void GLStateCache::OnProgramDeleted(GLuint program) {
+    if (g_State.program == program) g_State.program = UNKNOWN;
+}
+
+void GLStateCache::OnVertexArrayDeleted(GLuint vao) {
+    if (g_State.vao == vao) g_State.vao = UNKNOWN;
+}
+
+void GLStateCache::OnTextureDeleted(GLuint texture) {
+    for (auto& unit : g_State.textures)
+        for (GLuint& t : unit)
+            if (t == texture) t = UNKNOWN;
+}
+
+void GLStateCache::Invalidate() {
+    g_State = State();
+}
+
+const GLStateCache::Stats& GLStateCache::GetStats() {
+    return g_Stats;
+}
+
+void GLStateCache::ResetStats() {
+    g_Stats = Stats();
+}
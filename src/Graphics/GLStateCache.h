@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+// Shadows the GL binding state we touch every frame (program, VAO, textures per unit,
+// depth mask/func and blending) and skips calls that would not change anything.
+// All code that changes these states must go through this class, or call Invalidate()
+// afterwards, otherwise the shadow copy goes stale.
+class GLStateCache {
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+    static const unsigned int UPLOAD_TEXTURE_UNIT = MAX_TEXTURE_UNITS - 1; // Never sampled by a shader
+
+    struct Stats {
+        uint64_t issued = 0;  // GL calls actually made
+        uint64_t skipped = 0; // Redundant GL calls avoided
+    };
+
+    static void UseProgram(GLuint program);
+    static void BindVertexArray(GLuint vao);
+    static void BindTexture(unsigned int unit, GLenum target, GLuint texture);
+    static void DepthMask(bool enabled);
+    static void DepthFunc(GLenum func);
+    static void SetBlend(bool enabled);
+    static void BlendFunc(GLenum srcFactor, GLenum dstFactor);
+
+    static unsigned int GetActiveTextureUnit();
+    // Binds the texture on UPLOAD_TEXTURE_UNIT and makes that unit active, so it can be created
+    // or updated mid-frame without replacing a texture the current pass has bound
+    static void BindTextureForUpload(GLenum target, GLuint texture);
+
+    // Deleted names may be reused by the driver, so forget any binding that refers to them
+    static void OnProgramDeleted(GLuint program);
+    static void OnVertexArrayDeleted(GLuint vao);
+    static void OnTextureDeleted(GLuint texture);
+
+    // Forget everything (e.g. after code that changed state with raw GL calls)
+    static void Invalidate();
+
+    static const Stats& GetStats();
+    static void ResetStats();
+};
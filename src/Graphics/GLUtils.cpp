@@ -1,10 +1,58 @@
 #include <glad/glad.h> // Must be first OpenGL include
 #include "GLUtils.h"
+#include "GLStateCache.h"
 #include <iostream>
+#include <cstring>
 #include <stb_image.h>
 
-GLFWwindow* InitializeWindow(unsigned int width, unsigned int height, const char* title) {
+namespace {
+    GLOptionalFunctions g_OptionalFunctions;
+
+    void loadOptionalFunctions() {
+        GLOptionalFunctions& f = g_OptionalFunctions;
+
+        // Program binaries: core in 4.1, otherwise the ARB extension exposes the same names
+        GLint binaryFormats = 0;
+        bool hasProgramBinary = HasGLExtension("GL_ARB_get_program_binary");
+        if (hasProgramBinary || GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1)) {
+            f.GetProgramBinary = reinterpret_cast<decltype(f.GetProgramBinary)>(glfwGetProcAddress("glGetProgramBinary"));
+            f.ProgramBinary = reinterpret_cast<decltype(f.ProgramBinary)>(glfwGetProcAddress("glProgramBinary"));
+            f.ProgramParameteri = reinterpret_cast<decltype(f.ProgramParameteri)>(glfwGetProcAddress("glProgramParameteri"));
+            glGetIntegerv(0x87FE /* GL_NUM_PROGRAM_BINARY_FORMATS */, &binaryFormats);
+        }
+        // Some drivers expose the entry points but no formats, which means binaries can't be saved
+        f.programBinary = f.GetProgramBinary && f.ProgramBinary && f.ProgramParameteri && binaryFormats > 0;
+
+        if (HasGLExtension("GL_KHR_parallel_shader_compile")) {
+            f.MaxShaderCompilerThreads = reinterpret_cast<decltype(f.MaxShaderCompilerThreads)>(
+                glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+            f.parallelShaderCompile = f.MaxShaderCompilerThreads != nullptr;
+            if (f.parallelShaderCompile)
+                f.MaxShaderCompilerThreads(0xFFFFFFFFu); // Let the driver pick the thread count
+        }
+
+        if (HasGLExtension("GL_ARB_buffer_storage") || GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4)) {
+            f.BufferStorage = reinterpret_cast<decltype(f.BufferStorage)>(glfwGetProcAddress("glBufferStorage"));
+            f.bufferStorage = f.BufferStorage != nullptr;
+        }
+
+        std::cout << "Program binaries: " << (f.programBinary ? "yes" : "no")
+                  << ", parallel shader compile: " << (f.parallelShaderCompile ? "yes" : "no")
+                  << ", persistent mapping: " << (f.bufferStorage ? "yes" : "no") << std::endl;
+    }
+}
+
+const GLOptionalFunctions& GetGLOptionalFunctions() {
+    return g_OptionalFunctions;
+}
+
+GLFWwindow* InitializeWindow(unsigned int width, unsigned int height, const char* title, ContextMode mode) {
     glfwSetErrorCallback(nullptr);
+#ifdef GLFW_PLATFORM_NULL
+    // GLFW 3.4: no window system at all, the context is the only thing created
+    if (mode != ContextMode::Window)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return nullptr;
@@ -12,9 +60,15 @@ GLFWwindow* InitializeWindow(unsigned int width, unsigned int height, const char
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (mode != ContextMode::Window) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+                       mode == ContextMode::OffscreenOSMesa ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+    }
     GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, NULL);
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
+        std::cerr << (mode == ContextMode::Window ? "Failed to create GLFW window" : "Failed to create offscreen GL context")
+                  << std::endl;
         glfwTerminate();
         return nullptr;
     }
@@ -31,17 +85,30 @@ bool InitializeGLAD() {
     const GLubyte* version = glGetString(GL_VERSION);
     std::cout << "Renderer: " << renderer << std::endl;
     std::cout << "OpenGL version supported: " << version << std::endl;
+    loadOptionalFunctions();
     return true;
 }
 
 void SetupOpenGL() {
     glEnable(GL_DEPTH_TEST);
+    GLStateCache::Invalidate(); // Start from a clean shadow state on the new context
+}
+
+bool HasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
 }
 
 unsigned int LoadCubemap(const std::vector<std::string>& faces, bool flipVerticallyOnLoad) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_CUBE_MAP, textureID);
     stbi_set_flip_vertically_on_load(flipVerticallyOnLoad);
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++) {
@@ -64,21 +131,5 @@ unsigned int LoadCubemap(const std::vector<std::string>& faces, bool flipVertica
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
     return textureID;
 }
-
-void RenderSkybox(Shader &skyboxShader, unsigned int skyboxVAO, unsigned int cubemapTextureID, const glm::mat4 &view, const glm::mat4 &projection) {
-    glDepthMask(GL_FALSE);
-    skyboxShader.use();
-    glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-    skyboxShader.setMat4("view", skyboxView);
-    skyboxShader.setMat4("projection", projection);
-    skyboxShader.setInt("skybox", 0);
-    glBindVertexArray(skyboxVAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureID);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-    glDepthMask(GL_TRUE);
-}
@@ -4,8 +4,33 @@
 #include <vector>
 #include "Shader.h"
 
-GLFWwindow* InitializeWindow(unsigned int width, unsigned int height, const char* title);
+// How InitializeWindow creates the GL context. The offscreen modes create an invisible window
+// whose default framebuffer must not be relied on: render into a framebuffer object.
+//   OffscreenEGL     EGL context; on GLFW 3.4+ on the null platform, i.e. surfaceless EGL
+//                    with no display server (Mesa llvmpipe works without a GPU)
+//   OffscreenOSMesa  Mesa's software OSMesa context, also without a display on GLFW 3.4+
+// Older GLFW versions still need a display for the invisible window.
+enum class ContextMode { Window, OffscreenEGL, OffscreenOSMesa };
+
+GLFWwindow* InitializeWindow(unsigned int width, unsigned int height, const char* title,
+                             ContextMode mode = ContextMode::Window);
 bool InitializeGLAD();
 void SetupOpenGL();
+// True if the current context advertises the extension (e.g. "GL_EXT_texture_compression_s3tc")
+bool HasGLExtension(const char* name);
+
+// Entry points newer than the 3.3 core profile GLAD was generated for. They are resolved
+// through GLFW after context creation; check the flags before calling any of them.
+struct GLOptionalFunctions {
+    bool programBinary = false;         // GL 4.1 / ARB_get_program_binary
+    bool parallelShaderCompile = false; // KHR_parallel_shader_compile
+    bool bufferStorage = false;         // GL 4.4 / ARB_buffer_storage (persistent mapping)
+
+    void (APIENTRY *GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) = nullptr;
+    void (APIENTRY *ProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) = nullptr;
+    void (APIENTRY *ProgramParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+    void (APIENTRY *MaxShaderCompilerThreads)(GLuint count) = nullptr;
+    void (APIENTRY *BufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) = nullptr;
+};
+const GLOptionalFunctions& GetGLOptionalFunctions();
 unsigned int LoadCubemap(const std::vector<std::string>& faces, bool flipVerticallyOnLoad = false);
-void RenderSkybox(Shader &skyboxShader, unsigned int skyboxVAO, unsigned int cubemapTextureID, const glm::mat4 &view, const glm::mat4 &projection);
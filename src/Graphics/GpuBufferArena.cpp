@@ -0,0 +1,157 @@
+#include "GpuBufferArena.h"
+#include "Mesh.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+GpuBufferArena::GpuBufferArena(size_t pageSize)
+    : M_PageSize(pageSize)
+{
+}
+
+GpuBufferArena::~GpuBufferArena()
+{
+    for (Page& page : M_Pages)
+        glDeleteBuffers(1, &page.buffer);
+}
+
+GpuBufferArena::Allocation GpuBufferArena::Allocate(size_t size, size_t alignment)
+{
+    Allocation allocation;
+    if (size == 0)
+        return allocation;
+    alignment = std::max<size_t>(alignment, 1);
+
+    for (int i = 0; i < static_cast<int>(M_Pages.size()); ++i)
+    {
+        if (allocateFrom(i, size, alignment, allocation))
+            return allocation;
+    }
+
+    // Worst case the block starts just past an aligned offset, hence the extra alignment
+    int page = addPage(std::max(M_PageSize, size + alignment));
+    if (page < 0 || !allocateFrom(page, size, alignment, allocation))
+        std::cerr << "GpuBufferArena: failed to allocate " << size << " bytes" << std::endl;
+    return allocation;
+}
+
+void GpuBufferArena::Free(const Allocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    std::map<size_t, size_t>& blocks = M_Pages[allocation.page].freeBlocks;
+    size_t offset = allocation.offset;
+    size_t size = allocation.size;
+
+    // Merge with the following block...
+    auto next = blocks.lower_bound(offset);
+    if (next != blocks.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = blocks.erase(next);
+    }
+    // ...and the preceding one
+    if (next != blocks.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            M_Stats.usedBytes -= allocation.size;
+            --M_Stats.allocations;
+            return;
+        }
+    }
+    blocks[offset] = size;
+    M_Stats.usedBytes -= allocation.size;
+    --M_Stats.allocations;
+}
+
+void GpuBufferArena::Upload(const Allocation& allocation, const void* data, size_t size)
+{
+    if (!allocation.IsValid() || size == 0)
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, M_Pages[allocation.page].buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(allocation.offset),
+                    static_cast<GLsizeiptr>(std::min(size, allocation.size)), data);
+}
+
+bool GpuBufferArena::allocateFrom(int pageIndex, size_t size, size_t alignment, Allocation& allocation)
+{
+    std::map<size_t, size_t>& blocks = M_Pages[pageIndex].freeBlocks;
+    for (auto it = blocks.begin(); it != blocks.end(); ++it)
+    {
+        size_t blockStart = it->first;
+        size_t blockEnd = blockStart + it->second;
+        size_t start = (blockStart + alignment - 1) / alignment * alignment;
+        if (start + size > blockEnd)
+            continue;
+
+        // Keep whatever is left on either side of the allocation
+        blocks.erase(it);
+        if (start > blockStart)
+            blocks[blockStart] = start - blockStart;
+        if (start + size < blockEnd)
+            blocks[start + size] = blockEnd - (start + size);
+
+        allocation.page = pageIndex;
+        allocation.offset = start;
+        allocation.size = size;
+        M_Stats.usedBytes += size;
+        ++M_Stats.allocations;
+        return true;
+    }
+    return false;
+}
+
+int GpuBufferArena::addPage(size_t size)
+{
+    Page page;
+    glGenBuffers(1, &page.buffer);
+    if (page.buffer == 0)
+        return -1;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STATIC_DRAW);
+    page.size = size;
+    page.freeBlocks[0] = size;
+
+    M_Pages.push_back(page);
+    ++M_Stats.pages;
+    M_Stats.capacityBytes += size;
+    return static_cast<int>(M_Pages.size()) - 1;
+}
+
+GeometryPool::GeometryPool(size_t vertexPageBytes, size_t indexPageBytes)
+    : M_Vertices(vertexPageBytes), M_Indices(indexPageBytes)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+    for (auto& entry : M_VertexArrays)
+    {
+        GLStateCache::OnVertexArrayDeleted(entry.second);
+        glDeleteVertexArrays(1, &entry.second);
+    }
+}
+
+GLuint GeometryPool::GetVertexArray(int vertexPage, int indexPage, VertexFormat format)
+{
+    auto key = std::make_tuple(vertexPage, indexPage, static_cast<int>(format));
+    auto it = M_VertexArrays.find(key);
+    if (it != M_VertexArrays.end())
+        return it->second;
+
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    GLStateCache::BindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, M_Vertices.GetBuffer(vertexPage));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, M_Indices.GetBuffer(indexPage));
+    Mesh::SetVertexAttributes(format); // Meshes select their range with the base vertex
+    GLStateCache::BindVertexArray(0);
+
+    M_VertexArrays[key] = vao;
+    return vao;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <vector>
+
+enum class VertexFormat; // Mesh.h
+
+// Sub-allocates ranges of large GL buffers ("pages") with a first-fit free list.
+// Freed ranges are merged with free neighbours, so a page that is emptied becomes one block
+// again. Requests larger than a page get a page of their own.
+class GpuBufferArena {
+public:
+    struct Allocation {
+        int page = -1;
+        size_t offset = 0; // Bytes from the start of the page's buffer
+        size_t size = 0;
+        bool IsValid() const { return page >= 0; }
+    };
+
+    struct Stats {
+        size_t pages = 0;
+        size_t capacityBytes = 0;
+        size_t usedBytes = 0;
+        size_t allocations = 0;
+    };
+
+    explicit GpuBufferArena(size_t pageSize);
+    ~GpuBufferArena();
+
+    GpuBufferArena(const GpuBufferArena&) = delete;
+    GpuBufferArena& operator=(const GpuBufferArena&) = delete;
+
+    // offset is a multiple of alignment (which need not be a power of two, so vertex ranges
+    // can be aligned to the vertex size for base-vertex draws)
+    Allocation Allocate(size_t size, size_t alignment);
+    void Free(const Allocation& allocation);
+
+    // Copies data into an allocation. Uses GL_COPY_WRITE_BUFFER so no VAO is modified.
+    void Upload(const Allocation& allocation, const void* data, size_t size);
+
+    GLuint GetBuffer(int page) const { return M_Pages[page].buffer; }
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    struct Page {
+        GLuint buffer;
+        size_t size;
+        std::map<size_t, size_t> freeBlocks; // offset -> size, kept merged
+    };
+
+    std::vector<Page> M_Pages;
+    size_t M_PageSize;
+    Stats M_Stats;
+
+    bool allocateFrom(int pageIndex, size_t size, size_t alignment, Allocation& allocation);
+    int addPage(size_t size);
+};
+
+// Shared storage for meshes: one vertex arena and one index arena, plus a VAO for every
+// combination of vertex page, index page and vertex format in use. Meshes created with a
+// pool own ranges instead of GL objects and draw with glDrawElementsBaseVertex, so any number
+// of them share a handful of buffers and VAOs (and consecutive draws skip the VAO bind).
+// The pool must outlive its meshes.
+class GeometryPool {
+public:
+    explicit GeometryPool(size_t vertexPageBytes = 16 * 1024 * 1024, size_t indexPageBytes = 8 * 1024 * 1024);
+    ~GeometryPool();
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    GpuBufferArena& GetVertexArena() { return M_Vertices; }
+    GpuBufferArena& GetIndexArena() { return M_Indices; }
+
+    // Created on first request, with attributes for the format starting at offset 0
+    GLuint GetVertexArray(int vertexPage, int indexPage, VertexFormat format);
+
+    size_t GetVertexArrayCount() const { return M_VertexArrays.size(); }
+
+private:
+    GpuBufferArena M_Vertices;
+    GpuBufferArena M_Indices;
+    std::map<std::tuple<int, int, int>, GLuint> M_VertexArrays;
+};
@@ -0,0 +1,88 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+    : M_CurrentFrame(0), M_OpenSection(-1), M_CollectedFrames(0)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    if (!M_AllQueries.empty())
+        glDeleteQueries(static_cast<GLsizei>(M_AllQueries.size()), M_AllQueries.data());
+}
+
+void GpuTimer::BeginFrame()
+{
+    if (M_OpenSection >= 0)
+        End();
+
+    M_CurrentFrame = (M_CurrentFrame + 1) % FRAME_LATENCY;
+    Frame& frame = M_Frames[M_CurrentFrame];
+    if (frame.used)
+        collect(frame); // Issued FRAME_LATENCY frames ago
+    frame.used = true;
+}
+
+void GpuTimer::Begin(const std::string& label)
+{
+    if (M_OpenSection >= 0)
+        End();
+
+    GLuint query;
+    if (M_FreeQueries.empty())
+    {
+        glGenQueries(1, &query);
+        M_AllQueries.push_back(query);
+    }
+    else
+    {
+        query = M_FreeQueries.back();
+        M_FreeQueries.pop_back();
+    }
+
+    M_OpenSection = findSection(label);
+    M_Frames[M_CurrentFrame].queries.push_back({ query, M_OpenSection });
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void GpuTimer::End()
+{
+    if (M_OpenSection < 0)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    M_OpenSection = -1;
+}
+
+double GpuTimer::GetAverageMs(const Section& section) const
+{
+    return M_CollectedFrames > 0 ? section.totalMs / M_CollectedFrames : 0.0;
+}
+
+void GpuTimer::collect(Frame& frame)
+{
+    for (const PendingQuery& pending : frame.queries)
+    {
+        // Normally long finished; if the GPU is that far behind this waits for it
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &nanoseconds);
+        Section& section = M_Sections[pending.section];
+        section.totalMs += nanoseconds / 1.0e6;
+        ++section.queries;
+        M_FreeQueries.push_back(pending.query);
+    }
+    frame.queries.clear();
+    ++M_CollectedFrames;
+}
+
+int GpuTimer::findSection(const std::string& label)
+{
+    for (size_t i = 0; i < M_Sections.size(); ++i)
+    {
+        if (M_Sections[i].label == label)
+            return static_cast<int>(i);
+    }
+    Section section;
+    section.label = label;
+    M_Sections.push_back(section);
+    return static_cast<int>(M_Sections.size()) - 1;
+}
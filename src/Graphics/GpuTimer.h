@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GPU time of labelled sections, measured with GL_TIME_ELAPSED queries.
+// Results are collected FRAME_LATENCY frames after they were issued, by which time the GPU
+// has finished them, so measuring never makes the CPU wait. Only one section can be open at
+// a time (timer queries don't nest); sections with the same label add up.
+class GpuTimer {
+public:
+    static const int FRAME_LATENCY = 4;
+
+    struct Section {
+        std::string label;
+        double totalMs = 0.0;    // Over all collected frames
+        uint64_t queries = 0;
+    };
+
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Call once per frame before any Begin; collects the oldest frame's results
+    void BeginFrame();
+
+    void Begin(const std::string& label);
+    void End();
+
+    const std::vector<Section>& GetSections() const { return M_Sections; }
+    uint64_t GetCollectedFrames() const { return M_CollectedFrames; }
+    // Average GPU time per collected frame
+    double GetAverageMs(const Section& section) const;
+
+private:
+    struct PendingQuery {
+        GLuint query;
+        int section;
+    };
+
+    struct Frame {
+        std::vector<PendingQuery> queries;
+        bool used = false;
+    };
+
+    std::vector<Section> M_Sections;
+    std::vector<GLuint> M_FreeQueries;
+    std::vector<GLuint> M_AllQueries;
+    Frame M_Frames[FRAME_LATENCY];
+    int M_CurrentFrame;
+    int M_OpenSection;         // -1 when no query is active
+    uint64_t M_CollectedFrames;
+
+    void collect(Frame& frame);
+    int findSection(const std::string& label);
+};
@@ -0,0 +1,206 @@
+#include "Light.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    double nowMs() {
+        using namespace std::chrono;
+        return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    enum BufferIndex { LIGHT_BUFFER = 0, CLUSTER_BUFFER = 1, INDEX_BUFFER = 2 };
+}
+
+LightSystem::LightSystem()
+    : M_ClustersX(0), M_ClustersZ(0), M_BinningDirty(true), M_DataDirty(true)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        M_Buffers[i] = 0;
+        M_Textures[i] = 0;
+    }
+}
+
+LightSystem::~LightSystem()
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (M_Textures[i] != 0)
+        {
+            GLStateCache::OnTextureDeleted(M_Textures[i]);
+            glDeleteTextures(1, &M_Textures[i]);
+        }
+        if (M_Buffers[i] != 0)
+            glDeleteBuffers(1, &M_Buffers[i]);
+    }
+}
+
+void LightSystem::Build(int mazeWidth, int mazeHeight, const Settings& settings)
+{
+    M_Settings = settings;
+    M_Settings.cellsPerCluster = std::max(1, settings.cellsPerCluster);
+    M_Settings.slices = std::max(1, settings.slices);
+    M_ClustersX = (mazeWidth + M_Settings.cellsPerCluster - 1) / M_Settings.cellsPerCluster;
+    M_ClustersZ = (mazeHeight + M_Settings.cellsPerCluster - 1) / M_Settings.cellsPerCluster;
+    M_BinningDirty = true;
+
+    if (M_Buffers[0] == 0)
+    {
+        glGenBuffers(3, M_Buffers);
+        glGenTextures(3, M_Textures);
+    }
+}
+
+int LightSystem::Add(const PointLight& light)
+{
+    M_Lights.push_back(light);
+    M_BinningDirty = true;
+    return static_cast<int>(M_Lights.size()) - 1;
+}
+
+void LightSystem::Set(int index, const PointLight& light)
+{
+    PointLight& current = M_Lights[index];
+    if (current.position != light.position || current.radius != light.radius)
+        M_BinningDirty = true;
+    current = light;
+    M_DataDirty = true;
+}
+
+void LightSystem::Clear()
+{
+    M_Lights.clear();
+    M_BinningDirty = true;
+}
+
+void LightSystem::Update()
+{
+    if (!M_BinningDirty && !M_DataDirty)
+        return;
+    double start = nowMs();
+
+    std::vector<glm::vec4> lightData;
+    lightData.reserve(M_Lights.size() * 2);
+    for (const PointLight& light : M_Lights)
+    {
+        lightData.push_back(glm::vec4(light.position, light.radius));
+        lightData.push_back(glm::vec4(light.color * light.intensity, light.flicker));
+    }
+    if (lightData.empty())
+        lightData.push_back(glm::vec4(0.0f)); // Keep the buffers non-empty
+    upload(LIGHT_BUFFER, GL_RGBA32F, lightData.data(), lightData.size() * sizeof(glm::vec4));
+
+    if (M_BinningDirty)
+    {
+        std::vector<uint32_t> clusterTable;
+        std::vector<uint32_t> indices;
+        bin(clusterTable, indices);
+        if (indices.empty())
+            indices.push_back(0);
+        upload(CLUSTER_BUFFER, GL_RG32UI, clusterTable.data(), clusterTable.size() * sizeof(uint32_t));
+        upload(INDEX_BUFFER, GL_R32UI, indices.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    M_BinningDirty = false;
+    M_DataDirty = false;
+    M_Stats.lights = M_Lights.size();
+    M_Stats.binMs = nowMs() - start;
+}
+
+void LightSystem::bin(std::vector<uint32_t>& clusterTable, std::vector<uint32_t>& indices)
+{
+    const int clusterCount = M_ClustersX * M_ClustersZ * M_Settings.slices;
+    const float size = static_cast<float>(M_Settings.cellsPerCluster);
+    const float sliceHeight = M_Settings.height / M_Settings.slices;
+
+    // Calls visit(cluster) for every cluster the light's sphere overlaps
+    auto forEachCluster = [&](const PointLight& light, auto visit) {
+        int x0 = std::max(0, static_cast<int>(std::floor((light.position.x - light.radius) / size)));
+        int x1 = std::min(M_ClustersX - 1, static_cast<int>(std::floor((light.position.x + light.radius) / size)));
+        int z0 = std::max(0, static_cast<int>(std::floor((light.position.z - light.radius) / size)));
+        int z1 = std::min(M_ClustersZ - 1, static_cast<int>(std::floor((light.position.z + light.radius) / size)));
+        int s0 = std::max(0, static_cast<int>(std::floor((light.position.y - light.radius) / sliceHeight)));
+        int s1 = std::min(M_Settings.slices - 1, static_cast<int>(std::floor((light.position.y + light.radius) / sliceHeight)));
+        const float radiusSquared = light.radius * light.radius;
+        for (int s = s0; s <= s1; ++s)
+        {
+            for (int z = z0; z <= z1; ++z)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    // Closest point of the cluster's box to the light; the outer slices extend
+                    // to infinity since fragments above or below the grid clamp into them
+                    glm::vec3 minimum(x * size, s == 0 ? -1e30f : s * sliceHeight, z * size);
+                    glm::vec3 maximum((x + 1) * size, s == M_Settings.slices - 1 ? 1e30f : (s + 1) * sliceHeight, (z + 1) * size);
+                    glm::vec3 offset = glm::clamp(light.position, minimum, maximum) - light.position;
+                    if (glm::dot(offset, offset) <= radiusSquared)
+                        visit((s * M_ClustersZ + z) * M_ClustersX + x);
+                }
+            }
+        }
+    };
+
+    // Count, prefix sum, then fill, so the index list is one flat array
+    std::vector<uint32_t> counts(clusterCount, 0);
+    for (const PointLight& light : M_Lights)
+        forEachCluster(light, [&](int cluster) { ++counts[cluster]; });
+
+    M_Stats.clusterEntries = 0;
+    M_Stats.maxClusterLights = 0;
+    M_Stats.droppedEntries = 0;
+    clusterTable.assign(static_cast<size_t>(clusterCount) * 2, 0);
+    uint32_t offset = 0;
+    for (int i = 0; i < clusterCount; ++i)
+    {
+        uint32_t count = std::min<uint32_t>(counts[i], MAX_LIGHTS_PER_CLUSTER);
+        M_Stats.droppedEntries += counts[i] - count;
+        M_Stats.maxClusterLights = std::max(M_Stats.maxClusterLights, static_cast<int>(count));
+        clusterTable[i * 2] = offset;
+        clusterTable[i * 2 + 1] = 0; // Filled below, up to count
+        counts[i] = count;
+        offset += count;
+    }
+    M_Stats.clusterEntries = offset;
+
+    indices.assign(offset, 0);
+    for (size_t l = 0; l < M_Lights.size(); ++l)
+    {
+        forEachCluster(M_Lights[l], [&](int cluster) {
+            uint32_t& filled = clusterTable[cluster * 2 + 1];
+            if (filled < counts[cluster])
+                indices[clusterTable[cluster * 2] + filled++] = static_cast<uint32_t>(l);
+        });
+    }
+}
+
+void LightSystem::upload(int buffer, GLenum format, const void* data, size_t size)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, M_Buffers[buffer]);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    // Re-attach: the store may have been reallocated
+    GLStateCache::BindTexture(LIGHT_TEXTURE_UNIT + buffer, GL_TEXTURE_BUFFER, M_Textures[buffer]);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, M_Buffers[buffer]);
+}
+
+void LightSystem::Apply(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("lightData", static_cast<int>(LIGHT_TEXTURE_UNIT));
+    shader.setInt("lightClusters", static_cast<int>(CLUSTER_TEXTURE_UNIT));
+    shader.setInt("lightIndices", static_cast<int>(INDEX_TEXTURE_UNIT));
+    shader.setVec3("clusterCounts", glm::vec3((float)M_ClustersX, (float)M_Settings.slices, (float)M_ClustersZ));
+    shader.setVec3("clusterSize", glm::vec3((float)M_Settings.cellsPerCluster, M_Settings.height / M_Settings.slices,
+                                            (float)M_Settings.cellsPerCluster));
+}
+
+void LightSystem::Bind() const
+{
+    for (int i = 0; i < 3; ++i)
+        GLStateCache::BindTexture(LIGHT_TEXTURE_UNIT + i, GL_TEXTURE_BUFFER, M_Textures[i]);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A point light (torch, glowing exit...) with a finite range
+struct PointLight {
+    glm::vec3 position;
+    float radius = 3.0f;             // No contribution beyond this distance
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    float flicker = 0.0f;            // Intensity swings by up to this fraction, animated in maze.frag
+};
+
+// Point lights shaded with clustered forward lighting.
+// The maze's bounding box is split into a world-space grid of clusters: cellsPerCluster
+// maze cells in x/z and a few slices over the wall height. Update() bins every light into
+// the clusters its sphere touches and uploads three texture buffers:
+//   lights       two RGBA32F texels per light (position, radius; color * intensity, flicker)
+//   clusters     one RG32UI texel per cluster (offset into the index list, light count)
+//   indices      R32UI light indices, grouped by cluster
+// The POINT_LIGHTS variants of maze.frag look up the fragment's cluster and loop over its
+// lights only, so the cost per fragment depends on how many lights overlap it, not on the
+// total. The grid is in world space rather than view space: the lights are mostly static,
+// so the binning only reruns when a light moves. Flicker is animated by the shader from the
+// Lighting block's time, so flickering lights are never re-uploaded either.
+class LightSystem {
+public:
+    static const int MAX_LIGHTS_PER_CLUSTER = 32;
+    static const GLenum LIGHT_TEXTURE_UNIT = 2;   // Units 0 and 1: materials, pulled maze walls
+    static const GLenum CLUSTER_TEXTURE_UNIT = 3;
+    static const GLenum INDEX_TEXTURE_UNIT = 4;
+
+    struct Settings {
+        int cellsPerCluster = 2;
+        int slices = 2;          // Clusters over the height
+        float height = 2.0f;     // Height covered by the slices (the wall height)
+    };
+
+    struct Stats {
+        size_t lights = 0;
+        size_t clusterEntries = 0; // Light references over all clusters
+        int maxClusterLights = 0;
+        size_t droppedEntries = 0; // Lights left out of full clusters
+        double binMs = 0.0;        // Last Update's CPU time
+    };
+
+    LightSystem();
+    ~LightSystem();
+
+    LightSystem(const LightSystem&) = delete;
+    LightSystem& operator=(const LightSystem&) = delete;
+
+    // Sizes the cluster grid for a maze of the given size (in cells, one world unit each)
+    void Build(int mazeWidth, int mazeHeight, const Settings& settings);
+
+    // Returns the light's index
+    int Add(const PointLight& light);
+    void Set(int index, const PointLight& light);
+    const PointLight& Get(int index) const { return M_Lights[index]; }
+    const std::vector<PointLight>& GetLights() const { return M_Lights; }
+    void Clear();
+    size_t GetLightCount() const { return M_Lights.size(); }
+
+    // Rebins and uploads if lights changed since the last call; color/intensity-only changes
+    // just re-upload the light data
+    void Update();
+
+    // Sets the grid uniforms of a POINT_LIGHTS program (constant, so once per program)
+    void Apply(Shader& shader) const;
+
+    // Binds the three texture buffers to their units; call before the draws are executed
+    void Bind() const;
+
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    std::vector<PointLight> M_Lights;
+    Settings M_Settings;
+    int M_ClustersX;
+    int M_ClustersZ;
+    bool M_BinningDirty;
+    bool M_DataDirty;
+    Stats M_Stats;
+
+    GLuint M_Buffers[3];  // Light data, cluster table, index list
+    GLuint M_Textures[3]; // Texture buffer views of them
+
+    void bin(std::vector<uint32_t>& clusterTable, std::vector<uint32_t>& indices);
+    void upload(int buffer, GLenum format, const void* data, size_t size);
+};
@@ -0,0 +1,257 @@
+#include "LightBaker.h"
+#include "GLStateCache.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+    const size_t BYTES_PER_TEXEL = 6 + 4; // RGB16F light + RGBA8 occlusion
+
+    // True if no wall lies between the two points (x/z only), stepping cell by cell
+    bool isVisible(const std::vector<unsigned char>& walls, int width, glm::vec2 from, glm::vec2 to) {
+        int cx = static_cast<int>(std::floor(from.x));
+        int cy = static_cast<int>(std::floor(from.y));
+        const int targetX = static_cast<int>(std::floor(to.x));
+        const int targetY = static_cast<int>(std::floor(to.y));
+        float dx = to.x - from.x, dy = to.y - from.y;
+        int stepX = dx > 0.0f ? 1 : -1;
+        int stepY = dy > 0.0f ? 1 : -1;
+        float tDeltaX = dx != 0.0f ? std::fabs(1.0f / dx) : 1e30f;
+        float tDeltaY = dy != 0.0f ? std::fabs(1.0f / dy) : 1e30f;
+        float tMaxX = dx != 0.0f ? ((dx > 0.0f ? cx + 1 : cx) - from.x) / dx : 1e30f;
+        float tMaxY = dy != 0.0f ? ((dy > 0.0f ? cy + 1 : cy) - from.y) / dy : 1e30f;
+
+        int steps = std::abs(targetX - cx) + std::abs(targetY - cy);
+        for (int i = 0; i < steps; ++i)
+        {
+            unsigned char cellWalls = walls[static_cast<size_t>(cy) * width + cx];
+            if (tMaxX < tMaxY)
+            {
+                if (cellWalls & (stepX > 0 ? WALL_RIGHT : WALL_LEFT)) return false;
+                cx += stepX;
+                tMaxX += tDeltaX;
+            }
+            else
+            {
+                if (cellWalls & (stepY > 0 ? WALL_BOTTOM : WALL_TOP)) return false;
+                cy += stepY;
+                tMaxY += tDeltaY;
+            }
+        }
+        return true;
+    }
+}
+
+LightBaker::LightBaker()
+    : M_LightTexture(0), M_OcclusionTexture(0), M_Size(0), M_WorldSize(1.0f), M_TexelsPerCell(1), M_BakeTimeMs(0.0)
+{
+}
+
+LightBaker::~LightBaker()
+{
+    GLuint textures[2] = { M_LightTexture, M_OcclusionTexture };
+    for (GLuint texture : textures)
+    {
+        if (texture != 0)
+        {
+            GLStateCache::OnTextureDeleted(texture);
+            glDeleteTextures(1, &texture);
+        }
+    }
+}
+
+bool LightBaker::Bake(const Maze& maze, const std::vector<PointLight>& lights, const Settings& settings)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    M_Settings = settings;
+    const int width = maze.GetWidth();
+    const int height = maze.GetHeight();
+
+    // Fewer texels per cell for large mazes, so the volumes fit the GL size limit and the budget
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+    const int layers = std::min(std::max(1, settings.layers), static_cast<int>(maxSize));
+    int texelsPerCell = std::min(std::max(1, settings.texelsPerCell), static_cast<int>(maxSize) / std::max(width, height));
+    auto volumeBytes = [&](int texels) {
+        return static_cast<size_t>(width) * texels * static_cast<size_t>(height) * texels * layers * BYTES_PER_TEXEL;
+    };
+    while (texelsPerCell > 1 && volumeBytes(texelsPerCell) > settings.memoryBudget)
+        --texelsPerCell;
+    if (texelsPerCell < 1 || volumeBytes(texelsPerCell) > settings.memoryBudget)
+    {
+        std::cerr << "Error: a " << width << "x" << height << " maze is too large to bake lighting for (3D textures are limited to "
+                  << maxSize << " texels per axis and " << settings.memoryBudget / (1024 * 1024) << " MB)" << std::endl;
+        return false;
+    }
+    if (texelsPerCell != settings.texelsPerCell)
+        std::cout << "Baked lighting uses " << texelsPerCell << " texels per cell (" << settings.texelsPerCell
+                  << " requested) to fit the size limit" << std::endl;
+    M_TexelsPerCell = texelsPerCell;
+    M_Size = glm::ivec3(width * texelsPerCell, layers, height * texelsPerCell);
+    M_WorldSize = glm::vec3((float)width, settings.wallHeight, (float)height);
+    const std::vector<unsigned char> walls = maze.BuildWallMask();
+
+    // Lights reaching each cell, so texels only look at nearby lights
+    std::vector<std::vector<int>> cellLights(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        const PointLight& light = lights[i];
+        int x0 = std::max(0, static_cast<int>(std::floor(light.position.x - light.radius)));
+        int x1 = std::min(width - 1, static_cast<int>(std::floor(light.position.x + light.radius)));
+        int z0 = std::max(0, static_cast<int>(std::floor(light.position.z - light.radius)));
+        int z1 = std::min(height - 1, static_cast<int>(std::floor(light.position.z + light.radius)));
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                cellLights[static_cast<size_t>(z) * width + x].push_back(static_cast<int>(i));
+    }
+
+    // Light is stored as half floats, so the CPU copy is no larger than the GPU one
+    std::vector<uint16_t> lightData(static_cast<size_t>(M_Size.x) * M_Size.y * M_Size.z * 3, 0);
+    std::vector<unsigned char> occlusionData(static_cast<size_t>(M_Size.x) * M_Size.y * M_Size.z * 4, 255);
+
+    const float halfThickness = settings.wallThickness * 0.5f;
+    auto occlusion = [&settings](float distance) {
+        return 1.0f - settings.occlusionStrength * std::exp(-std::max(distance, 0.0f) / settings.occlusionRadius);
+    };
+
+    // Workers take texel rows (one z, all layers and x) from a shared counter
+    std::atomic<int> nextRow(0);
+    auto worker = [&]() {
+        for (int k = nextRow++; k < M_Size.z; k = nextRow++)
+        {
+            const float pz = (k + 0.5f) / texelsPerCell;
+            const int cz = k / texelsPerCell;
+            for (int l = 0; l < layers; ++l)
+            {
+                const float py = (l + 0.5f) / layers * settings.wallHeight;
+                for (int i = 0; i < M_Size.x; ++i)
+                {
+                    const float px = (i + 0.5f) / texelsPerCell;
+                    const int cx = i / texelsPerCell;
+                    const unsigned char bits = walls[static_cast<size_t>(cz) * width + cx];
+                    const size_t texel = (static_cast<size_t>(k) * layers + l) * M_Size.x + i;
+
+                    // Occluders, grouped by the axis of their normal
+                    float planesX = 1.0f, planesZ = 1.0f; // Walls along z (normal x), walls along x (normal z)
+                    if (bits & WALL_LEFT) planesX *= occlusion(px - cx - halfThickness);
+                    if (bits & WALL_RIGHT) planesX *= occlusion(cx + 1 - px - halfThickness);
+                    if (bits & WALL_TOP) planesZ *= occlusion(pz - cz - halfThickness);
+                    if (bits & WALL_BOTTOM) planesZ *= occlusion(cz + 1 - pz - halfThickness);
+                    float planesY = occlusion(py) * occlusion(settings.wallHeight - py);
+
+                    // Wall ends from neighbouring cells at corners the cell's own walls don't cover
+                    float posts = 1.0f;
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        for (int c = 0; c < 2; ++c)
+                        {
+                            int lineX = cx + c, lineZ = cz + j;
+                            bool ownWall = (bits & (j == 0 ? WALL_TOP : WALL_BOTTOM)) || (bits & (c == 0 ? WALL_LEFT : WALL_RIGHT));
+                            if (ownWall)
+                                continue;
+                            bool post = Maze::HasHorizontalWall(walls, width, height, lineX - 1, lineZ) ||
+                                        Maze::HasHorizontalWall(walls, width, height, lineX, lineZ) ||
+                                        Maze::HasVerticalWall(walls, width, height, lineX, lineZ - 1) ||
+                                        Maze::HasVerticalWall(walls, width, height, lineX, lineZ);
+                            if (post)
+                                posts *= occlusion(glm::length(glm::vec2(px - lineX, pz - lineZ)) - halfThickness);
+                        }
+                    }
+
+                    // A face is only occluded by surfaces perpendicular to it
+                    float aoX = planesZ * planesY * posts;
+                    float aoY = planesX * planesZ * posts;
+                    float aoZ = planesX * planesY * posts;
+                    occlusionData[texel * 4 + 0] = static_cast<unsigned char>(aoX * 255.0f + 0.5f);
+                    occlusionData[texel * 4 + 1] = static_cast<unsigned char>(aoY * 255.0f + 0.5f);
+                    occlusionData[texel * 4 + 2] = static_cast<unsigned char>(aoZ * 255.0f + 0.5f);
+
+                    // Static point lights, shadowed by the walls between them and the texel
+                    glm::vec3 position(px, py, pz);
+                    glm::vec3 irradiance(0.0f);
+                    for (int index : cellLights[static_cast<size_t>(cz) * width + cx])
+                    {
+                        const PointLight& light = lights[index];
+                        glm::vec3 toLight = light.position - position;
+                        float distanceSquared = glm::dot(toLight, toLight);
+                        float radiusSquared = light.radius * light.radius;
+                        if (distanceSquared >= radiusSquared)
+                            continue;
+                        if (!isVisible(walls, width, glm::vec2(px, pz), glm::vec2(light.position.x, light.position.z)))
+                            continue;
+                        float falloff = 1.0f - distanceSquared / radiusSquared; // Same falloff as maze.frag
+                        irradiance += falloff * falloff * light.color * light.intensity;
+                    }
+                    lightData[texel * 3 + 0] = glm::packHalf1x16(irradiance.x);
+                    lightData[texel * 3 + 1] = glm::packHalf1x16(irradiance.y);
+                    lightData[texel * 3 + 2] = glm::packHalf1x16(irradiance.z);
+                }
+            }
+        }
+    };
+
+    unsigned int threadCount = settings.threadCount;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(std::max(M_Size.z, 1)));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker(); // Main thread takes a share too
+    for (auto& t : threads)
+        t.join();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    M_BakeTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    // Upload both volumes with linear filtering; texel centres stay clear of the walls
+    auto upload = [this](GLuint& texture, GLenum internalFormat, GLenum format, GLenum type, const void* data) {
+        if (texture == 0)
+            glGenTextures(1, &texture);
+        GLStateCache::BindTextureForUpload(GL_TEXTURE_3D, texture);
+        glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, M_Size.x, M_Size.y, M_Size.z, 0, format, type, data);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Light rows are 6 bytes per texel, not 4-byte aligned for odd widths
+    upload(M_LightTexture, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, lightData.data());
+    upload(M_OcclusionTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, occlusionData.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    std::cout << "Lighting baked for " << width << "x" << height << " maze (" << lights.size() << " static lights, "
+              << M_Size.x << "x" << M_Size.y << "x" << M_Size.z << " texels) in " << M_BakeTimeMs << " ms using "
+              << threadCount << " threads (" << GetGpuMemoryBytes() / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+void LightBaker::Apply(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("bakedLight", static_cast<int>(LIGHT_TEXTURE_UNIT));
+    shader.setInt("bakedOcclusion", static_cast<int>(OCCLUSION_TEXTURE_UNIT));
+    shader.setVec3("bakedLightScale", 1.0f / M_WorldSize);
+    // Half a texel: surfaces sample on their own side of the wall
+    shader.setFloat("bakedLightOffset", 0.5f / std::max(1, M_TexelsPerCell));
+}
+
+void LightBaker::Bind() const
+{
+    GLStateCache::BindTexture(LIGHT_TEXTURE_UNIT, GL_TEXTURE_3D, M_LightTexture);
+    GLStateCache::BindTexture(OCCLUSION_TEXTURE_UNIT, GL_TEXTURE_3D, M_OcclusionTexture);
+}
+
+size_t LightBaker::GetGpuMemoryBytes() const
+{
+    return static_cast<size_t>(M_Size.x) * M_Size.y * M_Size.z * BYTES_PER_TEXEL;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Light.h"
+#include "Shader.h"
+#include "../Game/Maze.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Static lighting baked once per maze into two 3D textures covering its bounding box.
+// The maze never changes after generation, so the contribution of static point lights
+// (with wall shadows, traced on the cell grid) and the ambient occlusion of walls, posts,
+// floor and ceiling are computed on the CPU, in parallel, instead of per fragment:
+//   light      RGB16F, summed point light irradiance
+//   occlusion  RGBA8, ambient occlusion for surfaces facing along x, y and z; a face is
+//              only occluded by surfaces perpendicular to it, so each axis gets its own value
+// The BAKED_LIGHTING variants of maze.frag sample both at the fragment position pushed off
+// the surface along its normal, and skip the point light loop and the specular term.
+// Texel centres never lie on a cell edge, so light doesn't leak through walls.
+// The volume stores irradiance without direction, so baked point lights have no N.L term.
+class LightBaker {
+public:
+    static const GLenum LIGHT_TEXTURE_UNIT = 5; // After the LightSystem buffers
+    static const GLenum OCCLUSION_TEXTURE_UNIT = 6;
+
+    struct Settings {
+        int texelsPerCell = 4;      // Along x and z
+        int layers = 4;             // Along the height
+        float wallHeight = 2.0f;
+        float wallThickness = 0.1f;
+        float occlusionStrength = 0.6f; // Darkening right at an occluder
+        float occlusionRadius = 0.25f;  // Distance over which it fades
+        unsigned int threadCount = 0;   // 0 = use all hardware threads
+        size_t memoryBudget = 256u << 20; // Bytes for both volumes; texelsPerCell drops to fit
+    };
+
+    LightBaker();
+    ~LightBaker();
+
+    LightBaker(const LightBaker&) = delete;
+    LightBaker& operator=(const LightBaker&) = delete;
+
+    // texelsPerCell is lowered as far as 1 for mazes whose volumes would exceed
+    // GL_MAX_3D_TEXTURE_SIZE or the memory budget. Returns false (and uploads nothing) if even
+    // one texel per cell doesn't fit.
+    bool Bake(const Maze& maze, const std::vector<PointLight>& lights, const Settings& settings);
+
+    // Sets the sampler units and volume mapping of a BAKED_LIGHTING program (once per program)
+    void Apply(Shader& shader) const;
+
+    // Binds both volumes to their units; call before the draws are executed
+    void Bind() const;
+
+    double GetBakeTimeMs() const { return M_BakeTimeMs; }
+    size_t GetGpuMemoryBytes() const;
+
+private:
+    GLuint M_LightTexture;
+    GLuint M_OcclusionTexture;
+    glm::ivec3 M_Size; // Texels along x, y (height) and z
+    glm::vec3 M_WorldSize;
+    Settings M_Settings;
+    int M_TexelsPerCell; // After fitting the size limits
+    double M_BakeTimeMs;
+};
@@ -0,0 +1,67 @@
+#include "MaterialLibrary.h"
+
+#include <iostream>
+
+int MaterialLibrary::Add(const Material& material)
+{
+    if (M_Materials.size() >= static_cast<size_t>(MAX_MATERIALS))
+    {
+        std::cerr << "Too many materials, can't add " << material.name << std::endl;
+        return 0;
+    }
+    if (M_TextureArray)
+    {
+        std::cerr << "Materials must be added before MaterialLibrary::Load: " << material.name << std::endl;
+        return 0;
+    }
+    M_Materials.push_back(material);
+    return static_cast<int>(M_Materials.size()) - 1;
+}
+
+void MaterialLibrary::Load(TextureLoader& loader, int layerSize)
+{
+    if (M_Materials.empty())
+        return;
+
+    M_TextureArray = std::make_unique<TextureArray>(layerSize, layerSize, static_cast<int>(M_Materials.size()));
+    for (size_t layer = 0; layer < M_Materials.size(); ++layer)
+        loader.LoadLayer(*M_TextureArray, static_cast<int>(layer), M_Materials[layer].texturePath);
+}
+
+void MaterialLibrary::Apply(Shader& shader) const
+{
+    // x: shininess, y: specular strength (read by the SPECULAR variant only)
+    glm::vec4 table[MAX_MATERIALS];
+    for (size_t i = 0; i < M_Materials.size(); ++i)
+    {
+        const Material& material = M_Materials[i];
+        table[i] = glm::vec4(material.shininess, material.specularStrength, 0.0f, 0.0f);
+    }
+
+    shader.use();
+    shader.setInt("materialTextures", 0);
+    shader.setVec4Array(shader.GetUniformLocation("materials"), table, static_cast<int>(M_Materials.size()));
+}
+
+uint32_t MaterialLibrary::GetFeatures(int layer) const
+{
+    if (layer < 0 || layer >= static_cast<int>(M_Materials.size()))
+        return 0;
+
+    const Material& material = M_Materials[layer];
+    if (material.unlit)
+        return ShaderFeature::Unlit;
+    if (material.ceiling)
+        return ShaderFeature::Ceiling;
+    return material.specularStrength > 0.0f ? static_cast<uint32_t>(ShaderFeature::Specular) : static_cast<uint32_t>(0);
+}
+
+int MaterialLibrary::FindLayer(const std::string& name) const
+{
+    for (size_t i = 0; i < M_Materials.size(); ++i)
+    {
+        if (M_Materials[i].name == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
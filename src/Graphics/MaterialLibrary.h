@@ -0,0 +1,56 @@
+#pragma once
+
+#include "TextureArray.h"
+#include "TextureLoader.h"
+#include "Shader.h"
+#include "ShaderVariants.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Surface description for maze geometry. Every material is one layer of a shared texture
+// array, so geometry using different materials can be drawn with one shader, one texture
+// bind and one draw call; vertices pick their material through Vertex::Layer. The flags
+// below select the maze shader variant (see GetFeatures), so surfaces whose variants differ
+// end up in separate draws.
+struct Material {
+    std::string name;
+    std::string texturePath;
+    float shininess = 32.0f;
+    float specularStrength = 0.4f;
+    bool unlit = false;   // Texture color only, no lighting (e.g. the exit marker)
+    bool ceiling = false; // Flat surface seen from below: constant normal, never specular
+};
+
+class MaterialLibrary {
+public:
+    // Must match the size of the materials[] array in maze.frag
+    static const int MAX_MATERIALS = 16;
+
+    // Registers a material and returns its layer index (0 if it can't be added). Call before Load.
+    int Add(const Material& material);
+
+    // Creates the texture array (layerSize x layerSize per layer) and queues every layer on
+    // the loader. Layers show up as the loader uploads them.
+    void Load(TextureLoader& loader, int layerSize = 512);
+
+    // Sets the sampler unit and the material table of a program built from maze.frag.
+    // The table is constant, so this is done once after linking (ShaderVariants initializer).
+    void Apply(Shader& shader) const;
+
+    // ShaderFeature bits a surface with this material needs: UNLIT, CEILING, and SPECULAR
+    // only if the material has a highlight at all
+    uint32_t GetFeatures(int layer) const;
+
+    // Layer of a registered material, or -1
+    int FindLayer(const std::string& name) const;
+
+    const TextureArray* GetTextureArray() const { return M_TextureArray.get(); }
+    size_t GetMaterialCount() const { return M_Materials.size(); }
+
+private:
+    std::vector<Material> M_Materials;
+    std::unique_ptr<TextureArray> M_TextureArray;
+};
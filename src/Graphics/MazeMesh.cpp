@@ -0,0 +1,424 @@
+#include "MazeMesh.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Unit cube with four vertices per face, so every face shows the whole texture
+    const Vertex UNIT_CUBE[24] = {
+        // Back face
+        {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+        {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+        {{0.5f, 0.5f, -0.5f}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f}},
+        {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}},
+        // Front face
+        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{0.5f, 0.5f, 0.5f}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},
+        // Left face
+        {{-0.5f, 0.5f, 0.5f}, {1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}},
+        {{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}},
+        {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}},
+        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}},
+        // Right face
+        {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{0.5f, -0.5f, -0.5f}, {1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+        {{0.5f, -0.5f, 0.5f}, {0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},
+        // Bottom face
+        {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+        {{0.5f, -0.5f, -0.5f}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+        {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+        // Top face
+        {{-0.5f, 0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.5f, 0.5f, 0.5f}, {1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},
+        {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}}
+    };
+
+    void appendBox(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                   const glm::vec3& center, const glm::vec3& size, int layer) {
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        for (const Vertex& corner : UNIT_CUBE) {
+            Vertex vertex = corner;
+            vertex.Position = center + corner.Position * size;
+            vertex.Layer = static_cast<float>(layer);
+            vertices.push_back(vertex);
+        }
+        for (unsigned int face = 0; face < 6; ++face) {
+            unsigned int f = base + face * 4;
+            unsigned int quad[6] = { f, f + 1, f + 2, f + 2, f + 3, f };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    // Horizontal quad over [x0, x1] x [z0, z1]; one texture repeat per cell
+    void appendHorizontalQuad(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                              float x0, float z0, float x1, float z1, float y, int layer) {
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        // Normal stays +Y for the ceiling too, matching how the plane mesh was lit before
+        const glm::vec3 normal(0.0f, 1.0f, 0.0f);
+        const float l = static_cast<float>(layer);
+        vertices.push_back({{x1, y, z1}, {x1, z1}, normal, l});
+        vertices.push_back({{x1, y, z0}, {x1, z0}, normal, l});
+        vertices.push_back({{x0, y, z0}, {x0, z0}, normal, l});
+        vertices.push_back({{x0, y, z1}, {x0, z1}, normal, l});
+        unsigned int quad[6] = { base, base + 1, base + 3, base + 1, base + 2, base + 3 };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+
+    // Vertical quad from (x0, z0) to (x1, z1), floor to wall height, facing `normal`.
+    // Texture repeats once per cell along the wall and once over its height.
+    void appendVerticalQuad(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                            float x0, float z0, float x1, float z1, float height, const glm::vec3& normal, int layer) {
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        const float length = std::abs(x1 - x0) + std::abs(z1 - z0);
+        const float l = static_cast<float>(layer);
+        vertices.push_back({{x0, 0.0f, z0}, {0.0f, 0.0f}, normal, l});
+        vertices.push_back({{x1, 0.0f, z1}, {length, 0.0f}, normal, l});
+        vertices.push_back({{x1, height, z1}, {length, 1.0f}, normal, l});
+        vertices.push_back({{x0, height, z0}, {0.0f, 1.0f}, normal, l});
+        unsigned int quad[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+
+    // Bounding box of a far level chunk, 8 corners and 12 triangles. maze.frag's IMPOSTOR march
+    // finds the chunk from the texture coordinates, which carry its chunk coordinates (exact in
+    // half floats up to 2048 chunks per side); the normal is unused.
+    void appendImpostorBox(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                           const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec2& chunk, int layer) {
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        const float l = static_cast<float>(layer);
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 position((corner & 1) ? boxMax.x : boxMin.x, (corner & 2) ? boxMax.y : boxMin.y,
+                               (corner & 4) ? boxMax.z : boxMin.z);
+            vertices.push_back({position, chunk, glm::vec3(0.0f, 1.0f, 0.0f), l});
+        }
+        // Corners of the -x, +x, -y, +y, -z and +z faces
+        const unsigned int FACES[6][4] = {
+            { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 }
+        };
+        for (const auto& face : FACES) {
+            unsigned int quad[6] = { base + face[0], base + face[1], base + face[2], base + face[2], base + face[3], base + face[0] };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    // Walls on the given edge lines (see Maze::HasHorizontalWall) as zero-thickness planes, with
+    // collinear neighbours merged into one quad per run. Each run is a single quad, which
+    // maze.frag lights from whichever side is in view (nothing enables back-face culling).
+    void appendWallRuns(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                        const std::vector<unsigned char>& walls, int width, int height,
+                        const std::vector<int>& rows, int minX, int maxX,
+                        const std::vector<int>& columns, int minY, int maxY, float wallHeight, int layer) {
+        for (int j : rows)
+        {
+            int x = minX;
+            while (x <= maxX)
+            {
+                if (!Maze::HasHorizontalWall(walls, width, height, x, j)) { ++x; continue; }
+                int start = x;
+                while (x <= maxX && Maze::HasHorizontalWall(walls, width, height, x, j))
+                    ++x;
+                appendVerticalQuad(vertices, indices, (float)start, (float)j, (float)x, (float)j, wallHeight, glm::vec3(0.0f, 0.0f, -1.0f), layer);
+            }
+        }
+        for (int i : columns)
+        {
+            int y = minY;
+            while (y <= maxY)
+            {
+                if (!Maze::HasVerticalWall(walls, width, height, i, y)) { ++y; continue; }
+                int start = y;
+                while (y <= maxY && Maze::HasVerticalWall(walls, width, height, i, y))
+                    ++y;
+                appendVerticalQuad(vertices, indices, (float)i, (float)start, (float)i, (float)y, wallHeight, glm::vec3(-1.0f, 0.0f, 0.0f), layer);
+            }
+        }
+    }
+}
+
+MazeMesh::~MazeMesh()
+{
+    if (M_WallMaskTexture != 0)
+    {
+        GLStateCache::OnTextureDeleted(M_WallMaskTexture);
+        glDeleteTextures(1, &M_WallMaskTexture);
+    }
+}
+
+void MazeMesh::Build(const Maze& maze, const Layers& layers, const MaterialLibrary& materials, const Settings& settings,
+                     GeometryPool* pool)
+{
+    M_Chunks.clear();
+    M_Width = maze.GetWidth();
+    M_Height = maze.GetHeight();
+    M_ChunkSize = std::max(1, settings.chunkSize);
+    M_ChunksX = (M_Width + M_ChunkSize - 1) / M_ChunkSize;
+    M_ChunksY = (M_Height + M_ChunkSize - 1) / M_ChunkSize;
+    M_ChunkMarks.assign(static_cast<size_t>(M_ChunksX) * M_ChunksY, 0);
+
+    const std::vector<unsigned char> walls = maze.BuildWallMask();
+    const float h = settings.wallHeight;
+    const float t = settings.wallThickness;
+    M_WallHeight = h;
+
+    // One vertex/index list per shader variant; reused for every chunk
+    struct Group {
+        uint32_t features;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+    std::vector<Group> groups;
+    auto groupFor = [&](int layer, uint32_t extraFeatures = 0) -> Group& {
+        uint32_t features = materials.GetFeatures(layer) | extraFeatures;
+        for (Group& group : groups)
+        {
+            if (group.features == features)
+                return group;
+        }
+        groups.push_back({ features, {}, {} });
+        return groups.back();
+    };
+
+    const int chunkRows = settings.buildChunks ? M_ChunksY : 0;
+    if (chunkRows > 0)
+    {
+        // The far level's walls, fetched per cell by the IMPOSTOR march
+        if (M_WallMaskTexture == 0)
+            glGenTextures(1, &M_WallMaskTexture);
+        GLStateCache::BindTextureForUpload(GL_TEXTURE_2D, M_WallMaskTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are width bytes, not 4-byte aligned
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, M_Width, M_Height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, walls.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    for (int cy = 0; cy < chunkRows; ++cy)
+    {
+        for (int cx = 0; cx < M_ChunksX; ++cx)
+        {
+            Chunk chunk;
+            chunk.minX = cx * M_ChunkSize;
+            chunk.minY = cy * M_ChunkSize;
+            chunk.maxX = std::min(chunk.minX + M_ChunkSize, M_Width) - 1;
+            chunk.maxY = std::min(chunk.minY + M_ChunkSize, M_Height) - 1;
+            chunk.center = glm::vec3((chunk.minX + chunk.maxX + 1) * 0.5f, h * 0.5f, (chunk.minY + chunk.maxY + 1) * 0.5f);
+
+            // Edge lines owned by this chunk: its top/left borders and interior lines, plus the
+            // outer bottom/right borders of the maze
+            std::vector<int> rows, columns;
+            for (int j = chunk.minY; j <= chunk.maxY; ++j) rows.push_back(j);
+            for (int i = chunk.minX; i <= chunk.maxX; ++i) columns.push_back(i);
+            if (chunk.maxY == M_Height - 1) rows.push_back(M_Height);
+            if (chunk.maxX == M_Width - 1) columns.push_back(M_Width);
+
+            for (int level = 0; level < LOD_COUNT; ++level)
+            {
+                for (Group& group : groups)
+                {
+                    group.vertices.clear();
+                    group.indices.clear();
+                }
+                // References into groups are only used until the next groupFor call
+                Group& floorGroup = groupFor(layers.floor);
+                appendHorizontalQuad(floorGroup.vertices, floorGroup.indices, (float)chunk.minX, (float)chunk.minY,
+                                     (float)chunk.maxX + 1.0f, (float)chunk.maxY + 1.0f, 0.0f, layers.floor);
+                Group& ceilingGroup = groupFor(layers.ceiling);
+                appendHorizontalQuad(ceilingGroup.vertices, ceilingGroup.indices, (float)chunk.minX, (float)chunk.minY,
+                                     (float)chunk.maxX + 1.0f, (float)chunk.maxY + 1.0f, h, layers.ceiling);
+
+                if (level == LOD_FAR)
+                {
+                    Group& impostorGroup = groupFor(layers.wall, ShaderFeature::Impostor);
+                    appendImpostorBox(impostorGroup.vertices, impostorGroup.indices,
+                                      glm::vec3((float)chunk.minX, 0.0f, (float)chunk.minY),
+                                      glm::vec3(chunk.maxX + 1.0f, h, chunk.maxY + 1.0f), glm::vec2((float)cx, (float)cy), layers.wall);
+                }
+                else if (level == LOD_FULL)
+                {
+                    Group& wallGroup = groupFor(layers.wall);
+                    // Each shared edge is emitted once: cells own their top and left walls, and the
+                    // last row/column also emit the outer bottom/right walls
+                    for (int y = chunk.minY; y <= chunk.maxY; ++y)
+                    {
+                        for (int x = chunk.minX; x <= chunk.maxX; ++x)
+                        {
+                            unsigned char bits = walls[static_cast<size_t>(y) * M_Width + x];
+                            if (bits & WALL_TOP)
+                                appendBox(wallGroup.vertices, wallGroup.indices, glm::vec3(x + 0.5f, h / 2.0f, (float)y), glm::vec3(1.0f, h, t), layers.wall);
+                            if (bits & WALL_LEFT)
+                                appendBox(wallGroup.vertices, wallGroup.indices, glm::vec3((float)x, h / 2.0f, y + 0.5f), glm::vec3(t, h, 1.0f), layers.wall);
+                            if ((bits & WALL_BOTTOM) && y == M_Height - 1)
+                                appendBox(wallGroup.vertices, wallGroup.indices, glm::vec3(x + 0.5f, h / 2.0f, y + 1.0f), glm::vec3(1.0f, h, t), layers.wall);
+                            if ((bits & WALL_RIGHT) && x == M_Width - 1)
+                                appendBox(wallGroup.vertices, wallGroup.indices, glm::vec3(x + 1.0f, h / 2.0f, y + 0.5f), glm::vec3(t, h, 1.0f), layers.wall);
+                        }
+                    }
+                }
+                else
+                {
+                    // Merged zero-thickness planes, one quad per run
+                    Group& wallGroup = groupFor(layers.wall);
+                    appendWallRuns(wallGroup.vertices, wallGroup.indices, walls, M_Width, M_Height,
+                                   rows, chunk.minX, chunk.maxX, columns, chunk.minY, chunk.maxY, h, layers.wall);
+                }
+
+                for (const Group& group : groups)
+                {
+                    if (group.indices.empty())
+                        continue;
+                    std::unique_ptr<Mesh> mesh = pool
+                        ? std::make_unique<Mesh>(*pool, group.vertices, group.indices, settings.vertexFormat)
+                        : std::make_unique<Mesh>(group.vertices, group.indices, settings.vertexFormat);
+                    mesh->ReleaseCpuData(); // Only the GPU copy is drawn
+                    chunk.lods[level].push_back({ group.features, std::move(mesh) });
+                }
+            }
+            M_Chunks.push_back(std::move(chunk));
+        }
+    }
+
+    // The exit marker is a unit box placed by its instance transform
+    std::vector<Vertex> boxVertices;
+    std::vector<unsigned int> boxIndices;
+    appendBox(boxVertices, boxIndices, glm::vec3(0.0f), glm::vec3(1.0f), layers.exit);
+    M_ExitMarker = std::make_unique<Mesh>(boxVertices, boxIndices, VertexFormat::Packed); // Instanced: no quantization
+    const glm::ivec2 exitCell = maze.GetEndCellCoords();
+    glm::mat4 exitTransform(0.3f);
+    exitTransform[3] = glm::vec4(exitCell.x + 0.5f, 0.5f, exitCell.y + 0.5f, 1.0f);
+    M_ExitMarker->SetInstanceTransforms({ exitTransform });
+    M_ExitMarkerMin = glm::vec3(exitTransform[3]) - glm::vec3(0.15f); // Half of the 0.3 scale
+    M_ExitMarkerMax = glm::vec3(exitTransform[3]) + glm::vec3(0.15f);
+    M_ExitMarkerFeatures = materials.GetFeatures(layers.exit) | ShaderFeature::Instanced;
+
+    size_t vertexBytes = GetVertexBufferBytes();
+    size_t floatBytes = vertexBytes / Mesh::GetVertexSize(settings.vertexFormat) * sizeof(Vertex);
+    M_ChunkLods.assign(M_Chunks.size(), static_cast<unsigned char>(LOD_FULL));
+    M_LodDistances[0] = settings.lodMidDistance;
+    M_LodDistances[1] = settings.lodFarDistance;
+    M_LodHysteresis = settings.lodHysteresis;
+
+    std::cout << "Maze mesh: " << M_Chunks.size() << " chunks, " << GetTriangleCount(LOD_FULL) << " / "
+              << GetTriangleCount(LOD_MID) << " / " << GetTriangleCount(LOD_FAR) << " triangles (full / mid / far LOD), "
+              << GetUsedFeatures().size() << " shader variants, " << vertexBytes / 1024.0 << " KB of vertices ("
+              << floatBytes / 1024.0 << " KB as float)" << std::endl;
+}
+
+void MazeMesh::CollectVisibleChunks(const MazePVS& pvs, int cellX, int cellY, std::vector<int>& chunkIndices) const
+{
+    chunkIndices.clear();
+    std::vector<unsigned char>& marks = M_ChunkMarks;
+    std::fill(marks.begin(), marks.end(), 0);
+
+    auto mark = [&](int x, int y) {
+        if (x >= M_Width || y >= M_Height)
+            return;
+        int index = (y / M_ChunkSize) * M_ChunksX + (x / M_ChunkSize);
+        if (!marks[index])
+        {
+            marks[index] = 1;
+            chunkIndices.push_back(index);
+        }
+    };
+
+    int minX, minY, maxX, maxY;
+    pvs.GetVisibleBounds(cellX, cellY, minX, minY, maxX, maxY);
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            if (!pvs.IsVisible(cellX, cellY, x, y))
+                continue;
+            // A visible cell's bottom and right walls are owned by its neighbours
+            mark(x, y);
+            mark(x + 1, y);
+            mark(x, y + 1);
+        }
+    }
+}
+
+void MazeMesh::Apply(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("wallMask", static_cast<int>(WALL_MASK_TEXTURE_UNIT));
+    shader.setVec4("impostorGrid", glm::vec4((float)M_Width, (float)M_Height, (float)M_ChunkSize, M_WallHeight));
+}
+
+void MazeMesh::BindWallMask() const
+{
+    GLStateCache::BindTexture(WALL_MASK_TEXTURE_UNIT, GL_TEXTURE_2D, M_WallMaskTexture);
+}
+
+size_t MazeMesh::GetTriangleCount(int lod) const
+{
+    size_t triangles = 0;
+    for (const Chunk& chunk : M_Chunks)
+    {
+        for (const Surface& surface : chunk.lods[lod])
+            triangles += surface.mesh->GetIndexCount() / 3;
+    }
+    if (M_ExitMarker)
+        triangles += M_ExitMarker->GetIndexCount() / 3;
+    return triangles;
+}
+
+size_t MazeMesh::GetVertexBufferBytes() const
+{
+    size_t bytes = 0;
+    for (const Chunk& chunk : M_Chunks)
+    {
+        for (const std::vector<Surface>& level : chunk.lods)
+        {
+            for (const Surface& surface : level)
+                bytes += surface.mesh->GetVertexBufferBytes();
+        }
+    }
+    return bytes;
+}
+
+void MazeMesh::UpdateLods(const glm::vec3& cameraPosition)
+{
+    for (size_t i = 0; i < M_Chunks.size(); ++i)
+    {
+        const Chunk& chunk = M_Chunks[i];
+        // Distance to the chunk's bounding box (zero inside it)
+        glm::vec3 minimum((float)chunk.minX, 0.0f, (float)chunk.minY);
+        glm::vec3 maximum(chunk.maxX + 1.0f, M_WallHeight, chunk.maxY + 1.0f);
+        float distance = glm::length(glm::max(glm::max(minimum - cameraPosition, cameraPosition - maximum), glm::vec3(0.0f)));
+
+        // Only switch once clearly past a threshold, so a camera hovering around one doesn't
+        // make the chunk flicker between levels
+        int lod = M_ChunkLods[i];
+        while (lod < LOD_COUNT - 1 && distance > M_LodDistances[lod] + M_LodHysteresis)
+            ++lod;
+        while (lod > 0 && distance < M_LodDistances[lod - 1] - M_LodHysteresis)
+            --lod;
+        M_ChunkLods[i] = static_cast<unsigned char>(lod);
+    }
+}
+
+std::vector<uint32_t> MazeMesh::GetUsedFeatures() const
+{
+    std::vector<uint32_t> features;
+    auto add = [&](uint32_t value) {
+        if (std::find(features.begin(), features.end(), value) == features.end())
+            features.push_back(value);
+    };
+    for (const Chunk& chunk : M_Chunks)
+    {
+        for (const std::vector<Surface>& level : chunk.lods)
+        {
+            for (const Surface& surface : level)
+                add(surface.features);
+        }
+    }
+    if (M_ExitMarker)
+        add(M_ExitMarkerFeatures);
+    return features;
+}
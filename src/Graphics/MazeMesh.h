@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Mesh.h"
+#include "MaterialLibrary.h"
+#include "Shader.h"
+#include "../Game/Maze.h"
+#include "../Game/MazePVS.h"
+
+#include <memory>
+#include <vector>
+
+// Static maze geometry merged into a few large meshes.
+// The maze is split into square chunks of cells; each chunk holds its floor, ceiling and
+// walls in world space, with the material chosen per vertex (Vertex::Layer). Within a chunk,
+// surfaces are grouped by the shader variant their material needs (MaterialLibrary::GetFeatures),
+// one mesh and one draw per group, and the PVS culls whole chunks instead of individual walls.
+// Each chunk is built at LOD_COUNT levels of detail: full wall boxes up close, merged
+// zero-thickness wall planes at mid range (one quad per run, lit on the side in view), and far
+// away a fixed 12-triangle box around the chunk (IMPOSTOR variant), inside which maze.frag finds
+// the walls by marching the view ray through a wall-mask texture, so the far level's cost
+// doesn't grow with the walls.
+// UpdateLods picks a level per chunk from its distance to the camera.
+// The exit marker is a separate instanced mesh, drawn with the INSTANCED variant.
+class MazeMesh {
+public:
+    enum Lod { LOD_FULL = 0, LOD_MID = 1, LOD_FAR = 2 };
+    static const int LOD_COUNT = 3;
+    static const GLenum WALL_MASK_TEXTURE_UNIT = 8; // After the shadow map
+
+    struct Settings {
+        float wallHeight = 2.0f;
+        float wallThickness = 0.1f;
+        int chunkSize = 8; // Cells per chunk side
+        VertexFormat vertexFormat = VertexFormat::PackedQuantized; // For the chunk meshes
+        bool buildChunks = true; // false: exit marker only (e.g. when PulledMaze draws the maze)
+        float lodMidDistance = 16.0f; // Chunks further than this use LOD_MID...
+        float lodFarDistance = 40.0f; // ...and further than this LOD_FAR
+        float lodHysteresis = 2.0f;   // Distance past a threshold before switching level
+    };
+
+    // Texture array layers for each surface (see MaterialLibrary)
+    struct Layers {
+        int wall = 0;
+        int floor = 0;
+        int ceiling = 0;
+        int exit = 0;
+    };
+
+    // Geometry of one chunk drawn with one shader variant
+    struct Surface {
+        uint32_t features; // ShaderFeature bits
+        std::unique_ptr<Mesh> mesh;
+    };
+
+    struct Chunk {
+        std::vector<Surface> lods[LOD_COUNT]; // Surfaces of each level of detail
+        int minX, minY, maxX, maxY; // Cell range covered, inclusive
+        glm::vec3 center; // Of the chunk's bounds; the meshes are in world space, so this is their sort position
+    };
+
+    MazeMesh() = default;
+    ~MazeMesh();
+
+    MazeMesh(const MazeMesh&) = delete;
+    MazeMesh& operator=(const MazeMesh&) = delete;
+
+    // With a pool, chunk meshes are sub-allocated from its shared buffers (it must outlive
+    // this MazeMesh); without one each chunk mesh has buffers of its own
+    void Build(const Maze& maze, const Layers& layers, const MaterialLibrary& materials, const Settings& settings,
+               GeometryPool* pool = nullptr);
+
+    const std::vector<Chunk>& GetChunks() const { return M_Chunks; }
+
+    // Unit box with one instance transform placing it in the exit cell
+    Mesh* GetExitMarker() const { return M_ExitMarker.get(); }
+    uint32_t GetExitMarkerFeatures() const { return M_ExitMarkerFeatures; }
+    // World bounds of the marker, e.g. for its shadow pass
+    void GetExitMarkerBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const { boundsMin = M_ExitMarkerMin; boundsMax = M_ExitMarkerMax; }
+
+    // Every variant Build produced geometry for, so they can be created (and compiled) up front
+    std::vector<uint32_t> GetUsedFeatures() const;
+
+    // Indices of the chunks that can contain anything visible from cell (cellX, cellY)
+    void CollectVisibleChunks(const MazePVS& pvs, int cellX, int cellY, std::vector<int>& chunkIndices) const;
+
+    // Re-selects each chunk's level of detail for the given camera position
+    void UpdateLods(const glm::vec3& cameraPosition);
+    int GetChunkLod(int chunk) const { return M_ChunkLods[chunk]; }
+
+    // Wall-mask unit and grid for the far level's march (ignored without IMPOSTOR)
+    void Apply(Shader& shader) const;
+    // Binds the wall mask to WALL_MASK_TEXTURE_UNIT; call before far chunks are drawn
+    void BindWallMask() const;
+
+    size_t GetTriangleCount(int lod = LOD_FULL) const; // If every chunk used the given level
+    size_t GetVertexBufferBytes() const;
+
+private:
+    std::vector<Chunk> M_Chunks;
+    std::unique_ptr<Mesh> M_ExitMarker;
+    GLuint M_WallMaskTexture = 0; // R8UI, one Maze::BuildWallMask byte per cell
+    uint32_t M_ExitMarkerFeatures = 0;
+    glm::vec3 M_ExitMarkerMin = glm::vec3(0.0f);
+    glm::vec3 M_ExitMarkerMax = glm::vec3(0.0f);
+    int M_ChunksX = 0;
+    int M_ChunksY = 0;
+    int M_ChunkSize = 1;
+    int M_Width = 0;
+    int M_Height = 0;
+    mutable std::vector<unsigned char> M_ChunkMarks; // Scratch for CollectVisibleChunks
+    std::vector<unsigned char> M_ChunkLods;
+    float M_LodDistances[LOD_COUNT - 1] = { 0.0f, 0.0f };
+    float M_LodHysteresis = 0.0f;
+    float M_WallHeight = 0.0f;
+};
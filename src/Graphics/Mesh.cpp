@@ -1,7 +1,74 @@
 #include "Mesh.h"
 #include "Shader.h" // Mesh::Draw might need to interact with shader if material properties were part of mesh
+#include "GLStateCache.h"
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // GPU layouts for the compact vertex formats (see VertexFormat)
+    struct PackedVertex {
+        float position[3];
+        uint32_t normal;       // GL_INT_2_10_10_10_REV, normalized
+        uint16_t texCoords[2]; // GL_HALF_FLOAT
+        uint16_t layer;
+        uint16_t padding;
+    };
+    static_assert(sizeof(PackedVertex) == 24, "PackedVertex must stay tightly packed");
+
+    struct QuantizedVertex {
+        uint16_t position[3];  // GL_UNSIGNED_SHORT, normalized
+        uint16_t layer;
+        uint32_t normal;
+        uint16_t texCoords[2];
+    };
+    static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must stay tightly packed");
+
+    // Signed 10-bit components, w = 0
+    uint32_t packNormal(const glm::vec3& normal) {
+        auto component = [](float value) {
+            int quantized = static_cast<int>(std::round(glm::clamp(value, -1.0f, 1.0f) * 511.0f));
+            return static_cast<uint32_t>(quantized) & 0x3FFu;
+        };
+        return component(normal.x) | (component(normal.y) << 10) | (component(normal.z) << 20);
+    }
+
+    // IEEE half, round to nearest. Out of range values saturate to infinity; tiny ones flush to zero.
+    uint16_t toHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent <= 0) {
+            return sign;
+        }
+        if (exponent >= 31) {
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        }
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000u) {
+            ++half; // Carries into the exponent correctly
+        }
+        return static_cast<uint16_t>(sign | std::min<uint32_t>(half, 0x7C00u));
+    }
+}
+
+size_t Mesh::GetVertexSize(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed: return sizeof(PackedVertex);
+        case VertexFormat::PackedQuantized: return sizeof(QuantizedVertex);
+        default: return sizeof(Vertex);
+    }
+}
+
+Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, VertexFormat format)
+    : VAO(0), VBO(0), EBO(0), instanceVBO(0), instanceCount(0), format(format), positionTransform(1.0f),
+      vertexBufferBytes(0), vertexCount(0), indexCount(0), pool(nullptr), baseVertex(0) {
     this->vertices = vertices;
     this->indices = indices;
     // this->textureId = 0; // Initialize if used
@@ -9,22 +76,151 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>&
     setupMesh();
 }
 
+Mesh::Mesh(GeometryPool& pool, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+           VertexFormat format)
+    : VAO(0), VBO(0), EBO(0), instanceVBO(0), instanceCount(0), format(format), positionTransform(1.0f),
+      vertexBufferBytes(0), vertexCount(0), indexCount(0), pool(&pool), baseVertex(0) {
+    this->vertices = vertices;
+    this->indices = indices;
+
+    setupPooled();
+}
+
+Mesh::Mesh(GLsizei vertexCount, GLsizei instanceCount)
+    : VAO(0), VBO(0), EBO(0), instanceVBO(0), instanceCount(instanceCount), format(VertexFormat::Float), positionTransform(1.0f),
+      vertexBufferBytes(0), vertexCount(vertexCount), indexCount(0), pool(nullptr), baseVertex(0) {
+    glGenVertexArrays(1, &VAO); // Core profile needs a VAO bound to draw, even with no attributes
+}
+
 Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    if (!indices.empty()) {
-        glDeleteBuffers(1, &EBO);
+    release();
+}
+
+Mesh::Mesh(Mesh&& other) noexcept
+    : VAO(0), VBO(0), EBO(0), instanceVBO(0), instanceCount(0), format(VertexFormat::Float), positionTransform(1.0f),
+      vertexBufferBytes(0), vertexCount(0), indexCount(0), pool(nullptr), baseVertex(0) {
+    *this = std::move(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    release();
+
+    vertices = std::move(other.vertices);
+    indices = std::move(other.indices);
+    VAO = other.VAO;
+    VBO = other.VBO;
+    EBO = other.EBO;
+    instanceVBO = other.instanceVBO;
+    instanceCount = other.instanceCount;
+    format = other.format;
+    positionTransform = other.positionTransform;
+    vertexBufferBytes = other.vertexBufferBytes;
+    vertexCount = other.vertexCount;
+    indexCount = other.indexCount;
+    pool = other.pool;
+    vertexAllocation = other.vertexAllocation;
+    indexAllocation = other.indexAllocation;
+    baseVertex = other.baseVertex;
+
+    // Leave the source empty so its destructor releases nothing
+    other.VAO = other.VBO = other.EBO = other.instanceVBO = 0;
+    other.instanceCount = other.vertexCount = other.indexCount = 0;
+    other.vertexBufferBytes = 0;
+    other.pool = nullptr;
+    other.vertexAllocation = GpuBufferArena::Allocation();
+    other.indexAllocation = GpuBufferArena::Allocation();
+    return *this;
+}
+
+void Mesh::release() {
+    if (pool) {
+        // The VAO and buffers belong to the pool
+        pool->GetVertexArena().Free(vertexAllocation);
+        pool->GetIndexArena().Free(indexAllocation);
+        pool = nullptr;
+    } else {
+        if (VAO != 0) {
+            GLStateCache::OnVertexArrayDeleted(VAO);
+            glDeleteVertexArrays(1, &VAO);
+        }
+        if (VBO != 0) {
+            glDeleteBuffers(1, &VBO);
+        }
+        if (EBO != 0) {
+            glDeleteBuffers(1, &EBO);
+        }
+        if (instanceVBO != 0) {
+            glDeleteBuffers(1, &instanceVBO);
+        }
+    }
+    VAO = VBO = EBO = instanceVBO = 0;
+}
+
+void Mesh::ReleaseCpuData() {
+    std::vector<Vertex>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
+
+std::vector<unsigned char> Mesh::packVertices() {
+    std::vector<unsigned char> packed;
+    if (format == VertexFormat::Float) {
+        packed.resize(vertices.size() * sizeof(Vertex));
+        if (!vertices.empty()) {
+            std::memcpy(packed.data(), vertices.data(), packed.size());
+        }
+    } else if (format == VertexFormat::Packed) {
+        packed.resize(vertices.size() * sizeof(PackedVertex));
+        PackedVertex* out = reinterpret_cast<PackedVertex*>(packed.data());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Vertex& v = vertices[i];
+            out[i] = { { v.Position.x, v.Position.y, v.Position.z }, packNormal(v.Normal),
+                       { toHalf(v.TexCoords.x), toHalf(v.TexCoords.y) }, static_cast<uint16_t>(v.Layer), 0 };
+        }
+    } else {
+        // Bounds of the mesh, quantized with one step size for all axes
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!vertices.empty()) {
+            minimum = maximum = vertices[0].Position;
+        }
+        for (const Vertex& v : vertices) {
+            minimum = glm::min(minimum, v.Position);
+            maximum = glm::max(maximum, v.Position);
+        }
+        glm::vec3 extent = maximum - minimum;
+        float range = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+        positionTransform = glm::mat4(range);
+        positionTransform[3] = glm::vec4(minimum, 1.0f);
+
+        packed.resize(vertices.size() * sizeof(QuantizedVertex));
+        QuantizedVertex* out = reinterpret_cast<QuantizedVertex*>(packed.data());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Vertex& v = vertices[i];
+            glm::vec3 q = glm::round((v.Position - minimum) / range * 65535.0f);
+            out[i] = { { static_cast<uint16_t>(q.x), static_cast<uint16_t>(q.y), static_cast<uint16_t>(q.z) },
+                       static_cast<uint16_t>(v.Layer), packNormal(v.Normal),
+                       { toHalf(v.TexCoords.x), toHalf(v.TexCoords.y) } };
+        }
     }
+    return packed;
 }
 
 void Mesh::setupMesh() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
+    GLStateCache::BindVertexArray(VAO);
 
+    // Convert to the GPU layout. The CPU copy in `vertices` keeps the full precision.
+    std::vector<unsigned char> packed = packVertices();
+    vertexCount = static_cast<GLsizei>(vertices.size());
+    indexCount = static_cast<GLsizei>(indices.size());
+    vertexBufferBytes = packed.size();
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBufferBytes, packed.empty() ? nullptr : packed.data(), GL_STATIC_DRAW);
 
     if (!indices.empty()) {
         glGenBuffers(1, &EBO);
@@ -32,17 +228,94 @@ void Mesh::setupMesh() {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
     }
 
-    // Vertex Positions
+    SetVertexAttributes(format);
+
+    // Unbind so later GL_ELEMENT_ARRAY_BUFFER binds can't modify this VAO
+    GLStateCache::BindVertexArray(0);
+}
+
+void Mesh::setupPooled() {
+    std::vector<unsigned char> packed = packVertices();
+    vertexCount = static_cast<GLsizei>(vertices.size());
+    indexCount = static_cast<GLsizei>(indices.size());
+    vertexBufferBytes = packed.size();
+
+    // Vertex ranges are aligned to the vertex size so they start at a whole base vertex
+    const size_t stride = GetVertexSize(format);
+    vertexAllocation = pool->GetVertexArena().Allocate(packed.size(), stride);
+    indexAllocation = pool->GetIndexArena().Allocate(indices.size() * sizeof(unsigned int), sizeof(unsigned int));
+    if (!vertexAllocation.IsValid() || !indexAllocation.IsValid()) {
+        std::cerr << "Mesh: no room in the geometry pool" << std::endl;
+        vertexCount = indexCount = 0;
+        return;
+    }
+    pool->GetVertexArena().Upload(vertexAllocation, packed.data(), packed.size());
+    pool->GetIndexArena().Upload(indexAllocation, indices.data(), indices.size() * sizeof(unsigned int));
+
+    baseVertex = static_cast<GLint>(vertexAllocation.offset / stride);
+    VAO = pool->GetVertexArray(vertexAllocation.page, indexAllocation.page, format);
+    VBO = pool->GetVertexArena().GetBuffer(vertexAllocation.page);
+    EBO = pool->GetIndexArena().GetBuffer(indexAllocation.page);
+}
+
+void Mesh::SetVertexAttributes(VertexFormat format) {
+    const GLsizei stride = static_cast<GLsizei>(GetVertexSize(format));
+
+    // Same attribute locations in every format; the shaders see floats either way
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-    // Vertex Texture Coords
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    // Vertex Normals (if we add them)
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glEnableVertexAttribArray(3);
+    switch (format) {
+        case VertexFormat::Float:
+            // Vertex Positions
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, Position));
+            // Vertex Texture Coords
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, TexCoords));
+            // Vertex Normals
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, Normal));
+            // Material layer (ignored by shaders that don't sample the texture array)
+            glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, Layer));
+            break;
+        case VertexFormat::Packed:
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+            glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texCoords));
+            glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+            glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*)offsetof(PackedVertex, layer));
+            break;
+        case VertexFormat::PackedQuantized:
+            // Normalized to [0, 1]; GetPositionTransform() scales it back
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, position));
+            glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(QuantizedVertex, texCoords));
+            glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(QuantizedVertex, normal));
+            glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*)offsetof(QuantizedVertex, layer));
+            break;
+    }
+}
+
+void Mesh::SetInstanceTransforms(const std::vector<glm::mat4>& transforms) {
+    if (pool) {
+        std::cerr << "Mesh: instancing is not supported for pooled meshes" << std::endl;
+        return;
+    }
+    if (instanceVBO == 0) {
+        glGenBuffers(1, &instanceVBO);
+        GLStateCache::BindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        // A mat4 attribute takes four consecutive locations, one column each
+        for (GLuint column = 0; column < 4; ++column) {
+            glEnableVertexAttribArray(4 + column);
+            glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void*)(sizeof(glm::vec4) * column));
+            glVertexAttribDivisor(4 + column, 1);
+        }
+        GLStateCache::BindVertexArray(0);
+    }
 
-    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(glm::mat4),
+                 transforms.empty() ? nullptr : &transforms[0], GL_STATIC_DRAW);
+    instanceCount = static_cast<GLsizei>(transforms.size());
 }
 
 void Mesh::Draw(Shader& shader) {
@@ -51,15 +324,24 @@ void Mesh::Draw(Shader& shader) {
     // glActiveTexture(GL_TEXTURE0);
     // glBindTexture(GL_TEXTURE_2D, textureId);
 
-    // Draw mesh
-    glBindVertexArray(VAO);
-    if (!indices.empty()) {
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    // Draw mesh. The VAO stays bound: consecutive draws of the same mesh skip the rebind,
+    // and GLStateCache knows what is bound for everyone else.
+    GLStateCache::BindVertexArray(VAO);
+    if (pool) {
+        // Shared VAO: the range is selected by the index offset and the base vertex
+        if (indexCount > 0) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT,
+                                     reinterpret_cast<const void*>(indexAllocation.offset), baseVertex);
+        }
+    } else if (instanceCount > 0) {
+        if (indexCount > 0) {
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+        } else {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
+        }
+    } else if (indexCount > 0) {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
     } else {
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
     }
-    glBindVertexArray(0);
-
-    // Always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0); // Reset active texture unit
 }
\ No newline at end of file
@@ -3,36 +3,110 @@
 #include <glad/glad.h>
 #include <vector>
 #include <glm/glm.hpp> // For potential future use with vertex data struct
+#include "GpuBufferArena.h"
 
 // A simple vertex structure (can be expanded)
 struct Vertex {
     glm::vec3 Position;
     glm::vec2 TexCoords;
     glm::vec3 Normal; // For lighting later
+    float Layer = 0.0f; // Material layer in the maze texture array (see MaterialLibrary)
+};
+
+// How vertices are stored on the GPU. The CPU side always uses Vertex; the compact formats
+// are produced when the mesh is uploaded.
+//   Float:           Vertex as is (36 bytes)
+//   Packed:          float position, 10:10:10:2 normal, half-float UVs, 16-bit layer (24 bytes)
+//   PackedQuantized: Packed with 16-bit positions relative to the mesh bounds (16 bytes)
+// Half-float UVs are exact for the integer texture coordinates the maze uses. Quantized
+// positions are decoded by GetPositionTransform(), which the Renderer folds into the model
+// matrix; the scale is the same on every axis so normals stay correct.
+enum class VertexFormat {
+    Float,
+    Packed,
+    PackedQuantized
 };
 
 class Shader; // Forward declaration of Shader class
 
 class Mesh {
 public:
-    // Mesh Data
+    // Mesh Data. Empty after ReleaseCpuData(); use the counts below for sizes.
     std::vector<Vertex>       vertices; // Using a struct for vertices
     std::vector<unsigned int> indices;
     // unsigned int              textureId; // If mesh has a specific texture
 
-    // Render state
+    // Render state. Pooled meshes share VAO/VBO/EBO with the other meshes in the same pages.
     unsigned int VAO, VBO, EBO;
 
     // Constructor for indexed meshes
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+         VertexFormat format = VertexFormat::Float);
+    // Stores the mesh in ranges of the pool's shared buffers instead of buffers of its own.
+    // Needs indices; the pool must outlive the mesh.
+    Mesh(GeometryPool& pool, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+         VertexFormat format = VertexFormat::Float);
+    // Attribute-less mesh: Draw issues vertexCount vertices per instance from an empty VAO and
+    // the vertex shader builds everything from gl_VertexID/gl_InstanceID (see PulledMaze)
+    Mesh(GLsizei vertexCount, GLsizei instanceCount);
     // Constructor for non-indexed meshes (less common for complex shapes but possible)
     // Mesh(const std::vector<Vertex>& vertices);
     ~Mesh();
 
+    // Owns GL objects (or pool ranges), so it can be moved but not copied
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&& other) noexcept;
+    Mesh& operator=(Mesh&& other) noexcept;
+
     // Render the mesh
     void Draw(Shader& shader); // Shader is passed in for setting uniforms specific to this mesh/material
 
+    // Frees the CPU copies of vertices and indices; the GPU data is unaffected
+    void ReleaseCpuData();
+
+    GLsizei GetVertexCount() const { return vertexCount; }
+    GLsizei GetIndexCount() const { return indexCount; }
+    bool IsPooled() const { return pool != nullptr; }
+
+    // Per-instance model matrices, fed to attribute locations 4-7 (the INSTANCED shader
+    // variant). Once set, Draw renders the mesh once per matrix in a single call. The model
+    // matrix is not used then, so instanced meshes can't be PackedQuantized. Not available
+    // for pooled meshes (their VAO is shared).
+    void SetInstanceTransforms(const std::vector<glm::mat4>& transforms);
+    GLsizei GetInstanceCount() const { return instanceCount; }
+
+    VertexFormat GetVertexFormat() const { return format; }
+    // Maps stored positions to mesh space; identity unless the format is PackedQuantized
+    const glm::mat4& GetPositionTransform() const { return positionTransform; }
+    bool HasPositionTransform() const { return format == VertexFormat::PackedQuantized; }
+    // Size of the vertex data on the GPU
+    size_t GetVertexBufferBytes() const { return vertexBufferBytes; }
+    static size_t GetVertexSize(VertexFormat format);
+
+    // Enables attributes 0-3 for the format on the bound VAO, reading from the bound
+    // GL_ARRAY_BUFFER at offset 0
+    static void SetVertexAttributes(VertexFormat format);
+
 private:
+    unsigned int instanceVBO;
+    GLsizei instanceCount; // 0 = not instanced
+    VertexFormat format;
+    glm::mat4 positionTransform;
+    size_t vertexBufferBytes;
+    GLsizei vertexCount;
+    GLsizei indexCount;
+
+    // Pooled meshes only
+    GeometryPool* pool;
+    GpuBufferArena::Allocation vertexAllocation;
+    GpuBufferArena::Allocation indexAllocation;
+    GLint baseVertex;
+
     // Initializes all the buffer objects/arrays
     void setupMesh();
+    void setupPooled();
+    // Converts `vertices` to the GPU layout of `format` (and sets positionTransform)
+    std::vector<unsigned char> packVertices();
+    void release();
 };
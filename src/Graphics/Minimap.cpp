@@ -0,0 +1,155 @@
+#include "Minimap.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    const int DIRECTION_COUNT = 4;
+    const int DIRECTION_X[DIRECTION_COUNT] = { 0, 1, 0, -1 };
+    const int DIRECTION_Y[DIRECTION_COUNT] = { -1, 0, 1, 0 };
+    const unsigned char DIRECTION_WALL[DIRECTION_COUNT] = { WALL_TOP, WALL_RIGHT, WALL_BOTTOM, WALL_LEFT };
+}
+
+Minimap::Minimap()
+    : M_Texture(0), M_Width(0), M_Height(0), M_ExitCell(0), M_PlayerCell(-1), M_PlayerPosition(0.0f),
+      M_PlayerFront(0.0f, -1.0f), M_ExploredCount(0), M_Mode(Mode::Corner)
+{
+}
+
+Minimap::~Minimap()
+{
+    if (M_Texture != 0)
+    {
+        GLStateCache::OnTextureDeleted(M_Texture);
+        glDeleteTextures(1, &M_Texture);
+    }
+}
+
+void Minimap::Build(const Maze& maze, const Settings& settings)
+{
+    M_Width = maze.GetWidth();
+    M_Height = maze.GetHeight();
+    M_ExitCell = maze.GetEndCellCoords();
+    M_PlayerCell = glm::ivec2(-1);
+    M_ExploredCount = 0;
+    M_Settings = settings;
+    M_Cells = maze.BuildWallMask();
+
+    if (M_Texture == 0)
+        glGenTextures(1, &M_Texture);
+    GLStateCache::BindTextureForUpload(GL_TEXTURE_2D, M_Texture);
+
+    // Integer texture: fetched with texelFetch, so no filtering or mips
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are width bytes, not 4-byte aligned
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, M_Width, M_Height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, M_Cells.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // Attribute-less quad; minimap.vert places the corners from gl_VertexID
+    if (!M_Mesh)
+        M_Mesh = std::make_unique<Mesh>(6, 1);
+
+    std::cout << "Minimap: " << M_Width << "x" << M_Height << " cells in a " << M_Cells.size()
+              << " byte texture" << std::endl;
+}
+
+void Minimap::Update(const glm::vec3& playerPosition, const glm::vec3& playerFront)
+{
+    M_PlayerPosition = glm::vec2(playerPosition.x, playerPosition.z);
+    glm::vec2 front(playerFront.x, playerFront.z);
+    float length = glm::length(front);
+    if (length > 0.0001f)
+        M_PlayerFront = front / length; // Keep the last heading when looking straight down
+
+    glm::ivec2 cell(static_cast<int>(std::floor(M_PlayerPosition.x)), static_cast<int>(std::floor(M_PlayerPosition.y)));
+    if (cell == M_PlayerCell)
+        return;
+    M_PlayerCell = cell;
+    if (cell.x < 0 || cell.y < 0 || cell.x >= M_Width || cell.y >= M_Height || M_Texture == 0)
+        return;
+
+    // Runs mid-frame, while the scene's textures (e.g. the shadow map) are bound
+    GLStateCache::BindTextureForUpload(GL_TEXTURE_2D, M_Texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    explore(cell.x, cell.y);
+    // Everything down a straight corridor is visible from here
+    for (int d = 0; d < DIRECTION_COUNT; ++d)
+    {
+        int x = cell.x;
+        int y = cell.y;
+        while (!(M_Cells[static_cast<size_t>(y) * M_Width + x] & DIRECTION_WALL[d]))
+        {
+            x += DIRECTION_X[d];
+            y += DIRECTION_Y[d];
+            if (x < 0 || y < 0 || x >= M_Width || y >= M_Height)
+                break;
+            explore(x, y);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Minimap::explore(int x, int y)
+{
+    unsigned char& texel = M_Cells[static_cast<size_t>(y) * M_Width + x];
+    if (texel & EXPLORED)
+        return;
+    texel |= EXPLORED;
+    ++M_ExploredCount;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &texel);
+}
+
+void Minimap::Apply(Shader& shader, float screenWidth, float screenHeight) const
+{
+    // Cells covered by the quad: a square around the player, or the whole maze
+    glm::vec4 viewRect(0.0f, 0.0f, (float)M_Width, (float)M_Height);
+    if (M_Mode == Mode::Corner)
+    {
+        float r = M_Settings.cornerRadius;
+        viewRect = glm::vec4(M_PlayerPosition.x - r, M_PlayerPosition.y - r, 2.0f * r, 2.0f * r);
+    }
+    glm::vec4 screenRect = getScreenRect(screenWidth, screenHeight);
+
+    shader.use();
+    shader.setInt("cells", 0); // The renderer binds the command's texture to unit 0
+    shader.setInt("mazeWidth", M_Width);
+    shader.setInt("mazeHeight", M_Height);
+    shader.setVec4("viewRect", viewRect);
+    shader.setVec2("playerPosition", M_PlayerPosition);
+    shader.setVec2("playerFront", M_PlayerFront);
+    shader.setVec2("exitCell", glm::vec2(M_ExitCell));
+    shader.setFloat("pixelsPerCell", screenRect.z / viewRect.z);
+    shader.setInt("revealAll", M_Settings.revealAll ? 1 : 0);
+}
+
+glm::mat4 Minimap::GetTransform(float screenWidth, float screenHeight) const
+{
+    // Unit quad [0, 1]^2 to the screen rectangle in normalized device coordinates
+    glm::vec4 rect = getScreenRect(screenWidth, screenHeight);
+    glm::mat4 transform(1.0f);
+    transform[0][0] = 2.0f * rect.z / screenWidth;
+    transform[1][1] = 2.0f * rect.w / screenHeight;
+    transform[3][0] = 2.0f * rect.x / screenWidth - 1.0f;
+    transform[3][1] = 2.0f * rect.y / screenHeight - 1.0f;
+    return transform;
+}
+
+glm::vec4 Minimap::getScreenRect(float screenWidth, float screenHeight) const
+{
+    if (M_Mode == Mode::Corner)
+    {
+        float size = std::min(M_Settings.cornerSize, std::min(screenWidth, screenHeight) - 2.0f * M_Settings.cornerMargin);
+        // Window coordinates start at the bottom left, so the top right corner is at high x and y
+        return glm::vec4(screenWidth - M_Settings.cornerMargin - size, screenHeight - M_Settings.cornerMargin - size, size, size);
+    }
+
+    // Largest rectangle with the maze's aspect ratio filling 90% of the screen
+    float scale = 0.9f * std::min(screenWidth / std::max(M_Width, 1), screenHeight / std::max(M_Height, 1));
+    float width = scale * M_Width;
+    float height = scale * M_Height;
+    return glm::vec4((screenWidth - width) / 2.0f, (screenHeight - height) / 2.0f, width, height);
+}
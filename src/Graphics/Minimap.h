@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "../Game/Maze.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+// In-game map drawn from maze data on the GPU.
+// The maze is uploaded once as an R8UI texture with one texel per cell (WallBits plus an
+// EXPLORED bit), and shaders/minimap.frag draws walls, fog over unexplored cells, the exit
+// and the player in one screen-space quad. The cost depends on the quad's pixel count, not
+// on the maze size, and exploring a cell is a single-texel update.
+// Two modes: a corner minimap centred on the player, and a full-screen overview of the maze.
+class Minimap {
+public:
+    static const unsigned char EXPLORED = 1 << 4; // Above the WallBits flags
+
+    enum class Mode {
+        Corner,
+        Overview
+    };
+
+    struct Settings {
+        float cornerSize = 256.0f;  // Corner map side, pixels
+        float cornerMargin = 16.0f; // Distance from the top-right corner, pixels
+        float cornerRadius = 10.0f; // Cells shown around the player in corner mode
+        bool revealAll = false;     // Draw unexplored cells too
+    };
+
+    Minimap();
+    ~Minimap();
+
+    Minimap(const Minimap&) = delete;
+    Minimap& operator=(const Minimap&) = delete;
+
+    void Build(const Maze& maze, const Settings& settings);
+
+    // Marks the player's cell and everything in straight line of sight from it as explored,
+    // and stores the position to draw (world x/z, in cells). Uploads only on cell changes.
+    void Update(const glm::vec3& playerPosition, const glm::vec3& playerFront);
+
+    void SetMode(Mode mode) { M_Mode = mode; }
+    Mode GetMode() const { return M_Mode; }
+    void ToggleMode() { M_Mode = M_Mode == Mode::Corner ? Mode::Overview : Mode::Corner; }
+
+    // Sets the per-frame uniforms (view rectangle, player) of a program built from the minimap
+    // shaders; call between BeginScene and EndScene, before submitting GetMesh()
+    void Apply(Shader& shader, float screenWidth, float screenHeight) const;
+
+    // Places the unit quad on screen (in NDC); pass as the model matrix when submitting
+    glm::mat4 GetTransform(float screenWidth, float screenHeight) const;
+
+    Mesh& GetMesh() { return *M_Mesh; }
+    GLuint GetTexture() const { return M_Texture; }
+
+    size_t GetExploredCount() const { return M_ExploredCount; }
+
+private:
+    GLuint M_Texture;
+    std::unique_ptr<Mesh> M_Mesh;
+    std::vector<unsigned char> M_Cells; // CPU copy of the texture
+    int M_Width;
+    int M_Height;
+    glm::ivec2 M_ExitCell;
+    glm::ivec2 M_PlayerCell;
+    glm::vec2 M_PlayerPosition;
+    glm::vec2 M_PlayerFront;
+    size_t M_ExploredCount;
+    Settings M_Settings;
+    Mode M_Mode;
+
+    void explore(int x, int y);
+    glm::vec4 getScreenRect(float screenWidth, float screenHeight) const; // Pixels: x, y, width, height
+};
@@ -0,0 +1,73 @@
+#include "PulledMaze.h"
+#include "GLStateCache.h"
+
+#include <iostream>
+
+PulledMaze::PulledMaze()
+    : M_WallTexture(0), M_Width(0), M_Height(0)
+{
+}
+
+PulledMaze::~PulledMaze()
+{
+    if (M_WallTexture != 0)
+    {
+        GLStateCache::OnTextureDeleted(M_WallTexture);
+        glDeleteTextures(1, &M_WallTexture);
+    }
+}
+
+void PulledMaze::Build(const Maze& maze, const MazeMesh::Layers& layers, const Settings& settings)
+{
+    M_Width = maze.GetWidth();
+    M_Height = maze.GetHeight();
+    M_Layers = layers;
+    M_Settings = settings;
+
+    if (M_WallTexture == 0)
+        glGenTextures(1, &M_WallTexture);
+    GLStateCache::BindTexture(WALL_TEXTURE_UNIT, GL_TEXTURE_2D, M_WallTexture);
+
+    // Integer texture: fetched with texelFetch, so no filtering or mips
+    const std::vector<unsigned char> walls = maze.BuildWallMask();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are width bytes, not 4-byte aligned
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, M_Width, M_Height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, walls.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // One instance per cell plus the extra row and column for the outer walls
+    M_Mesh = std::make_unique<Mesh>(VERTICES_PER_CELL, (M_Width + 1) * (M_Height + 1));
+
+    std::cout << "Pulled maze: " << M_Width << "x" << M_Height << " cells in a " << GetGpuMemoryBytes()
+              << " byte wall texture, one draw" << std::endl;
+}
+
+void PulledMaze::UpdateCell(int x, int y, unsigned char wallBits)
+{
+    if (x < 0 || y < 0 || x >= M_Width || y >= M_Height)
+        return;
+    GLStateCache::BindTexture(WALL_TEXTURE_UNIT, GL_TEXTURE_2D, M_WallTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &wallBits);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void PulledMaze::Apply(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("wallBits", static_cast<int>(WALL_TEXTURE_UNIT));
+    shader.setInt("mazeWidth", M_Width);
+    shader.setInt("mazeHeight", M_Height);
+    shader.setFloat("wallHeight", M_Settings.wallHeight);
+    shader.setFloat("wallThickness", M_Settings.wallThickness);
+    shader.setInt("wallLayer", M_Layers.wall);
+    shader.setInt("floorLayer", M_Layers.floor);
+    shader.setInt("ceilingLayer", M_Layers.ceiling);
+}
+
+void PulledMaze::BindWallTexture() const
+{
+    GLStateCache::BindTexture(WALL_TEXTURE_UNIT, GL_TEXTURE_2D, M_WallTexture);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Mesh.h"
+#include "MazeMesh.h"
+#include "Shader.h"
+#include "../Game/Maze.h"
+
+#include <memory>
+
+// Alternative to MazeMesh that stores no geometry at all.
+// The maze is uploaded as an R8UI texture with one texel of WallBits per cell, and
+// shaders/maze_pulled.vert generates floors, ceilings and walls from gl_VertexID and
+// gl_InstanceID, one instance per cell. The whole maze is one draw, GPU memory is one byte
+// per cell, and editing a wall is a single-texel update. There is no chunking, so the PVS
+// doesn't apply; use it for large mazes where geometry memory and submission dominate.
+class PulledMaze {
+public:
+    static const int VERTICES_PER_CELL = 84; // Two wall boxes, floor and ceiling quads
+    static const GLenum WALL_TEXTURE_UNIT = 1; // Unit 0 is the material array
+
+    struct Settings {
+        float wallHeight = 2.0f;
+        float wallThickness = 0.1f;
+    };
+
+    PulledMaze();
+    ~PulledMaze();
+
+    PulledMaze(const PulledMaze&) = delete;
+    PulledMaze& operator=(const PulledMaze&) = delete;
+
+    void Build(const Maze& maze, const MazeMesh::Layers& layers, const Settings& settings);
+
+    // Rewrites one cell's wall bits. An edge belongs to two cells, so update both neighbours
+    // when a wall between them changes.
+    void UpdateCell(int x, int y, unsigned char wallBits);
+
+    // Sets the uniforms of a program built from maze_pulled.vert (constant, so once per program)
+    void Apply(Shader& shader) const;
+
+    // Binds the wall texture to WALL_TEXTURE_UNIT; call before the draw is executed
+    void BindWallTexture() const;
+
+    // The attribute-less mesh to submit (with Apply'd shader and the material array)
+    Mesh& GetMesh() { return *M_Mesh; }
+
+    size_t GetGpuMemoryBytes() const { return static_cast<size_t>(M_Width) * M_Height; }
+
+private:
+    GLuint M_WallTexture;
+    std::unique_ptr<Mesh> M_Mesh;
+    int M_Width;
+    int M_Height;
+    MazeMesh::Layers M_Layers;
+    Settings M_Settings;
+};
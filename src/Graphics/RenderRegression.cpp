@@ -0,0 +1,209 @@
+#include "RenderRegression.h"
+#include "GLStateCache.h"
+#include "../Utils/Image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace {
+    double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Baselines are "name value" lines
+    bool readBaseline(const std::string& path, std::map<std::string, double>& values) {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+        std::string key;
+        double value;
+        while (file >> key >> value)
+            values[key] = value;
+        return true;
+    }
+}
+
+RenderRegression::RenderRegression(int width, int height, const Settings& settings)
+    : M_Width(std::max(1, width)), M_Height(std::max(1, height)), M_Settings(settings), M_Framebuffer(0), M_Failures(0)
+{
+    M_Settings.timedFrames = std::max(1, M_Settings.timedFrames);
+    if (M_Settings.update)
+    {
+        // The write checks below report it if this fails
+        std::error_code error;
+        std::filesystem::create_directories(M_Settings.goldenDirectory, error);
+    }
+
+    glGenRenderbuffers(2, M_Renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, M_Renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, M_Width, M_Height);
+    glBindRenderbuffer(GL_RENDERBUFFER, M_Renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, M_Width, M_Height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &M_Framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, M_Renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, M_Renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "RenderRegression: framebuffer is incomplete" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+RenderRegression::~RenderRegression()
+{
+    glDeleteFramebuffers(1, &M_Framebuffer);
+    glDeleteRenderbuffers(2, M_Renderbuffers);
+}
+
+bool RenderRegression::RunScene(const std::string& name, Renderer& renderer, const std::function<void()>& renderFrame)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffer);
+    glViewport(0, 0, M_Width, M_Height);
+
+    // Warm-up covers shader finalization and the streaming buffer's first laps
+    for (int i = 0; i < M_Settings.warmupFrames; ++i)
+        renderFrame();
+    glFinish();
+
+    Counters counters;
+    const uint64_t issuedBefore = GLStateCache::GetStats().issued;
+    auto sceneStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < M_Settings.timedFrames; ++i)
+    {
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        renderFrame();
+        counters.submitMs += elapsedMs(frameStart);
+    }
+    glFinish();
+    counters.frameMs = elapsedMs(sceneStart) / M_Settings.timedFrames;
+    counters.submitMs /= M_Settings.timedFrames;
+    counters.stateCalls = (GLStateCache::GetStats().issued - issuedBefore) / M_Settings.timedFrames;
+    const Renderer::Stats& stats = renderer.GetStats();
+    counters.drawCalls = stats.drawCalls;
+    counters.shaderChanges = stats.shaderChanges;
+    counters.textureChanges = stats.textureChanges;
+
+    readPixels();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    std::cout << "Scene " << name << ": " << counters.submitMs << " ms submit, " << counters.frameMs << " ms per frame, "
+              << counters.drawCalls << " draws, " << counters.shaderChanges << " shader changes, "
+              << counters.textureChanges << " texture changes, " << counters.stateCalls << " state calls" << std::endl;
+
+    // Both checks always run, so one report shows everything that regressed
+    bool imagePassed = checkImage(name);
+    bool countersPassed = checkCounters(name, counters);
+    if (!imagePassed || !countersPassed)
+    {
+        ++M_Failures;
+        return false;
+    }
+    return true;
+}
+
+void RenderRegression::readPixels()
+{
+    const size_t rowBytes = static_cast<size_t>(M_Width) * 4;
+    std::vector<unsigned char> bottomUp(rowBytes * M_Height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, M_Width, M_Height, GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+
+    // GL rows start at the bottom
+    M_Pixels.resize(bottomUp.size());
+    for (int y = 0; y < M_Height; ++y)
+        std::memcpy(&M_Pixels[rowBytes * y], &bottomUp[rowBytes * (M_Height - 1 - y)], rowBytes);
+}
+
+bool RenderRegression::checkImage(const std::string& name)
+{
+    const std::string path = M_Settings.goldenDirectory + "/" + name + ".ppm";
+    std::vector<unsigned char> golden;
+    int width = 0, height = 0;
+    if (M_Settings.update)
+    {
+        if (!WritePPM(path, M_Pixels.data(), M_Width, M_Height))
+            return false;
+        std::cout << "  recorded " << path << std::endl;
+        return true;
+    }
+    if (!ReadPPM(path, golden, width, height))
+    {
+        std::cerr << "  FAIL no golden image " << path << " (record it with --update-golden)" << std::endl;
+        return false;
+    }
+    if (width != M_Width || height != M_Height)
+    {
+        std::cerr << "  FAIL " << path << " is " << width << "x" << height << ", rendered " << M_Width << "x" << M_Height << std::endl;
+        return false;
+    }
+
+    ImageDiff diff = CompareImages(M_Pixels.data(), golden.data(), M_Width, M_Height, M_Settings.channelTolerance);
+    const uint64_t allowed = static_cast<uint64_t>(M_Settings.maxMismatchFraction * M_Width * M_Height);
+    if (diff.mismatchedPixels > allowed)
+    {
+        // Keep the failing frame next to the golden one for inspection
+        const std::string actualPath = M_Settings.goldenDirectory + "/" + name + ".actual.ppm";
+        WritePPM(actualPath, M_Pixels.data(), M_Width, M_Height);
+        std::cerr << "  FAIL image: " << diff.mismatchedPixels << " pixels differ (allowed " << allowed << "), max difference "
+                  << diff.maxChannelDifference << "; wrote " << actualPath << std::endl;
+        return false;
+    }
+    std::cout << "  image matches (" << diff.mismatchedPixels << " pixels over tolerance, mean difference "
+              << diff.meanChannelDifference << ")" << std::endl;
+    return true;
+}
+
+bool RenderRegression::checkCounters(const std::string& name, const Counters& counters)
+{
+    const std::string path = M_Settings.goldenDirectory + "/" + name + ".txt";
+    std::map<std::string, double> baseline;
+    if (M_Settings.update)
+    {
+        std::ofstream file(path);
+        file << "drawCalls " << counters.drawCalls << "\n"
+             << "shaderChanges " << counters.shaderChanges << "\n"
+             << "textureChanges " << counters.textureChanges << "\n"
+             << "stateCalls " << counters.stateCalls << "\n"
+             << "submitMs " << counters.submitMs << "\n";
+        file.close();
+        if (!file)
+        {
+            std::cerr << "  Failed to write " << path << std::endl;
+            return false;
+        }
+        std::cout << "  recorded " << path << std::endl;
+        return true;
+    }
+    if (!readBaseline(path, baseline))
+    {
+        std::cerr << "  FAIL no baseline " << path << " (record it with --update-golden)" << std::endl;
+        return false;
+    }
+
+    bool passed = true;
+    auto checkCount = [&](const char* key, uint64_t value) {
+        auto it = baseline.find(key);
+        if (it != baseline.end() && static_cast<double>(value) > it->second)
+        {
+            std::cerr << "  FAIL " << key << ": " << value << ", baseline " << it->second << std::endl;
+            passed = false;
+        }
+    };
+    checkCount("drawCalls", counters.drawCalls);
+    checkCount("shaderChanges", counters.shaderChanges);
+    checkCount("textureChanges", counters.textureChanges);
+    checkCount("stateCalls", counters.stateCalls);
+
+    // Report only: timing depends on the machine and its load
+    auto submit = baseline.find("submitMs");
+    if (submit != baseline.end())
+        std::cout << "  submitMs " << counters.submitMs << ", baseline " << submit->second << std::endl;
+    return passed;
+}
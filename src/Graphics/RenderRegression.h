@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Renderer.h"
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Offscreen render checks, meant for CI on an offscreen context (see ContextMode).
+// Each scene is drawn into a framebuffer object for a few warm-up frames and then a run of
+// timed frames. The last frame is read back and compared against <scene>.ppm in the golden
+// directory, and its counters (draw calls, shader/texture changes, GL state calls issued and
+// CPU submit time) against the baseline recorded in <scene>.txt. Counts may not grow; the
+// submit time is too noisy on shared CI machines to gate on, so it is only reported next to
+// the baseline. A missing golden file is a failure; Settings::update records the current
+// results instead (creating the directory), and fails if they can't be written.
+// Golden images are only meaningful for the GL implementation they were recorded on, e.g.
+// Mesa llvmpipe in CI.
+class RenderRegression {
+public:
+    struct Settings {
+        std::string goldenDirectory = "golden";
+        bool update = false;              // Re-record images and baselines
+        int warmupFrames = 5;
+        int timedFrames = 100;
+        int channelTolerance = 8;         // Per RGB channel, for rasterization differences
+        float maxMismatchFraction = 0.005f;
+    };
+
+    // Per-frame figures of a scene
+    struct Counters {
+        double submitMs = 0.0;  // CPU time of the frame callback, averaged
+        double frameMs = 0.0;   // Including the wait for the GPU, averaged
+        uint64_t drawCalls = 0;
+        uint64_t shaderChanges = 0;
+        uint64_t textureChanges = 0;
+        uint64_t stateCalls = 0; // GL state calls issued through GLStateCache
+    };
+
+    RenderRegression(int width, int height, const Settings& settings);
+    ~RenderRegression();
+
+    RenderRegression(const RenderRegression&) = delete;
+    RenderRegression& operator=(const RenderRegression&) = delete;
+
+    // Renders a scene with renderFrame, which draws one complete frame through the renderer
+    // into the bound framebuffer. Returns false if the image or a counter regressed.
+    bool RunScene(const std::string& name, Renderer& renderer, const std::function<void()>& renderFrame);
+
+    int GetFailureCount() const { return M_Failures; }
+    int GetWidth() const { return M_Width; }
+    int GetHeight() const { return M_Height; }
+
+private:
+    int M_Width;
+    int M_Height;
+    Settings M_Settings;
+    GLuint M_Framebuffer;
+    GLuint M_Renderbuffers[2]; // Color, depth
+    std::vector<unsigned char> M_Pixels;
+    int M_Failures;
+
+    void readPixels();
+    bool checkImage(const std::string& name);
+    bool checkCounters(const std::string& name, const Counters& counters);
+};
@@ -1,9 +1,70 @@
 #include "Renderer.h"
+#include "GLStateCache.h"
 #include <glad/glad.h> // For glClear, etc.
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
-Renderer::Renderer() {
-    // Constructor: Could initialize default clear color or other states if needed
+namespace {
+    // Sort key layout, most significant first:
+    //   [63..62] pass | [61..50] shader | [49..38] texture | [37..26] mesh | [25..0] depth
+    // Object names are truncated to 12 bits, which only affects grouping, never correctness.
+    const int KEY_PASS_SHIFT = 62;
+    const int KEY_SHADER_SHIFT = 50;
+    const int KEY_TEXTURE_SHIFT = 38;
+    const int KEY_MESH_SHIFT = 26;
+    const uint64_t KEY_ID_MASK = 0xFFF;
+    const uint64_t KEY_DEPTH_MAX = (1u << 26) - 1;
+    const float KEY_DEPTH_RANGE = 100.0f; // Camera far plane
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // LSD radix sort on 8-bit digits. Digits that are identical for every key are skipped,
+    // which is most of them for a typical frame (few passes/shaders/textures).
+    void radixSort(SortEntry* entries, SortEntry* scratch, size_t count) {
+        size_t histograms[8][256];
+        std::memset(histograms, 0, sizeof(histograms));
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t key = entries[i].key;
+            for (int digit = 0; digit < 8; ++digit)
+                ++histograms[digit][(key >> (digit * 8)) & 0xFF];
+        }
+
+        SortEntry* src = entries;
+        SortEntry* dst = scratch;
+        for (int digit = 0; digit < 8; ++digit) {
+            size_t* histogram = histograms[digit];
+            if (histogram[(src[0].key >> (digit * 8)) & 0xFF] == count)
+                continue; // All keys share this digit
+
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b) {
+                size_t n = histogram[b];
+                histogram[b] = offset;
+                offset += n;
+            }
+            for (size_t i = 0; i < count; ++i)
+                dst[histogram[(src[i].key >> (digit * 8)) & 0xFF]++] = src[i];
+            std::swap(src, dst);
+        }
+
+        if (src != entries)
+            std::memcpy(entries, src, count * sizeof(SortEntry));
+    }
+}
+
+Renderer::Renderer()
+    : M_Arena(256 * 1024), M_Commands(nullptr), M_CommandCount(0), M_CommandCapacity(1024), M_GpuTimer(nullptr),
+      M_DynamicResolution(nullptr), M_ScreenWidth(0), M_ScreenHeight(0) {
     // For now, we assume OpenGL state like depth testing is enabled elsewhere (e.g., main)
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    M_UniformAlignment = static_cast<size_t>(std::max(uniformAlignment, 1));
+    M_FrameData = std::make_unique<StreamBuffer>(GL_UNIFORM_BUFFER, 64 * 1024);
+    M_LightingUBO = std::make_unique<UniformBuffer>(sizeof(LightingBlock), UniformBlockBinding::Lighting);
 }
 
 Renderer::~Renderer() {
@@ -13,6 +74,7 @@ Renderer::~Renderer() {
 void Renderer::Clear() const {
     // Default clear color, can be made configurable
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Default clear color
+    GLStateCache::DepthMask(true);        // glClear respects the depth mask
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
@@ -20,30 +82,194 @@ void Renderer::BeginScene(Camera& camera, float screenWidth, float screenHeight)
     // Calculate and store view and projection matrices for this frame
     M_ViewMatrix = camera.GetViewMatrix();
     M_ProjectionMatrix = camera.GetProjectionMatrix(screenWidth, screenHeight);
+    M_ScreenWidth = static_cast<int>(screenWidth);
+    M_ScreenHeight = static_cast<int>(screenHeight);
+
+    // Written straight into this frame's region of the ring buffer; every program reads the
+    // Camera block from there
+    M_FrameData->BeginFrame();
+    size_t cameraOffset = 0;
+    CameraBlock* block = static_cast<CameraBlock*>(M_FrameData->Allocate(sizeof(CameraBlock), M_UniformAlignment, cameraOffset));
+    if (block) {
+        block->view = M_ViewMatrix;
+        block->projection = M_ProjectionMatrix;
+        block->viewPos = glm::vec4(camera.Position, 1.0f);
+        glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlockBinding::Camera, M_FrameData->GetBuffer(),
+                          static_cast<GLintptr>(cameraOffset), sizeof(CameraBlock));
+    }
 
-    // Note: Shaders will still need to be activated (`shader.use()`) before setting these
-    // uniforms, typically done just before calling Submit/Draw.
+    // Fresh command queue for this frame
+    M_Arena.Reset();
+    M_Commands = M_Arena.AllocateArray<RenderCommand>(M_CommandCapacity);
+    M_CommandCount = 0;
+
+    if (M_GpuTimer) {
+        M_GpuTimer->BeginFrame();
+    }
+}
+
+void Renderer::SetLighting(const glm::vec3& direction, const glm::vec3& color, float ambientIntensity) {
+    LightingBlock block;
+    block.direction = glm::vec4(direction, 0.0f);
+    block.color = glm::vec4(color, ambientIntensity);
+    M_LightingUBO->SetData(&block, offsetof(LightingBlock, time));
+}
+
+void Renderer::SetLightingTime(float seconds) {
+    glm::vec4 time(seconds, 0.0f, 0.0f, 0.0f);
+    M_LightingUBO->SetData(&time, sizeof(time), offsetof(LightingBlock, time));
 }
 
-void Renderer::Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform) {
-    // It's assumed the correct shader is already active (`shader.use()`)
-    // and view/projection are set if BeginScene was called.
+void Renderer::SetShadowSpace(const glm::mat4& shadowSpace) {
+    M_LightingUBO->SetData(&shadowSpace, sizeof(shadowSpace), offsetof(LightingBlock, shadowSpace));
+}
 
-    shader.setMat4("model", modelTransform);
-    // If BeginScene wasn't called, or if a shader needs VP matrices directly:
-    // shader.setMat4("view", M_ViewMatrix);       // This implies shader must be active
-    // shader.setMat4("projection", M_ProjectionMatrix); // This implies shader must be active
+void Renderer::Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform,
+                      const Texture* texture, RenderPass pass) {
+    Submit(shader, mesh, modelTransform, texture ? texture->Target : GL_TEXTURE_2D, texture ? texture->ID : 0, pass);
+}
 
-    mesh.Draw(shader); // Mesh::Draw binds VAO and calls glDrawElements/Arrays
+void Renderer::Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform,
+                      GLenum textureTarget, GLuint textureID, RenderPass pass) {
+    Submit(shader, mesh, modelTransform, textureTarget, textureID, glm::vec3(modelTransform[3]), pass);
+}
+
+void Renderer::Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform,
+                      GLenum textureTarget, GLuint textureID, const glm::vec3& sortPosition, RenderPass pass) {
+    if (M_CommandCount == M_CommandCapacity) {
+        // Out of room: double the queue inside the arena. The larger capacity is kept, so
+        // this only happens while the scene grows.
+        M_CommandCapacity *= 2;
+        RenderCommand* grown = M_Arena.AllocateArray<RenderCommand>(M_CommandCapacity);
+        std::memcpy(grown, M_Commands, M_CommandCount * sizeof(RenderCommand));
+        M_Commands = grown;
+    }
+
+    RenderCommand& command = M_Commands[M_CommandCount++];
+    command.SortKey = makeSortKey(pass, shader, textureID, mesh, sortPosition);
+    command.shader = &shader;
+    command.mesh = &mesh;
+    command.textureTarget = textureTarget;
+    command.textureID = textureID;
+    // Quantized meshes store positions relative to their bounds; decoding them is one more
+    // transform, so it rides along in the model matrix instead of costing shader work
+    command.model = mesh.HasPositionTransform() ? modelTransform * mesh.GetPositionTransform() : modelTransform;
+}
+
+uint64_t Renderer::makeSortKey(RenderPass pass, const Shader& shader, GLuint textureID, const Mesh& mesh,
+                               const glm::vec3& sortPosition) const {
+    // View-space distance of the sort position, so opaque draws within a batch go front to back.
+    // Pooled meshes share their VAO, and so the mesh bits; the depth alone orders those.
+    uint64_t depthBits = 0;
+    if (pass == RenderPass::Opaque) {
+        glm::vec4 viewPos = M_ViewMatrix * glm::vec4(sortPosition, 1.0f);
+        float depth = glm::clamp(-viewPos.z / KEY_DEPTH_RANGE, 0.0f, 1.0f);
+        depthBits = static_cast<uint64_t>(depth * KEY_DEPTH_MAX);
+    }
+
+    return (static_cast<uint64_t>(pass) << KEY_PASS_SHIFT) |
+           ((static_cast<uint64_t>(shader.ID) & KEY_ID_MASK) << KEY_SHADER_SHIFT) |
+           ((static_cast<uint64_t>(textureID) & KEY_ID_MASK) << KEY_TEXTURE_SHIFT) |
+           ((static_cast<uint64_t>(mesh.VAO) & KEY_ID_MASK) << KEY_MESH_SHIFT) |
+           depthBits;
 }
 
 void Renderer::EndScene() {
-    // Could be used for post-processing passes, flushing render queues, etc.
-    // For now, it does nothing.
+    M_Stats = Stats();
+    M_Stats.commands = static_cast<uint32_t>(M_CommandCount);
+    M_FrameData->Commit(); // Streamed data must be visible before the draws read it
+    if (M_CommandCount == 0) {
+        M_FrameData->EndFrame();
+        return;
+    }
+
+    // Sort (key, index) pairs rather than the commands themselves
+    SortEntry* entries = M_Arena.AllocateArray<SortEntry>(M_CommandCount);
+    SortEntry* scratch = M_Arena.AllocateArray<SortEntry>(M_CommandCount);
+    for (size_t i = 0; i < M_CommandCount; ++i) {
+        entries[i].key = M_Commands[i].SortKey;
+        entries[i].index = static_cast<uint32_t>(i);
+    }
+    radixSort(entries, scratch, M_CommandCount);
+
+    // The scene passes go to the scaled offscreen target; Resolve upscales them into the window
+    if (M_DynamicResolution) {
+        M_DynamicResolution->Begin(M_ScreenWidth, M_ScreenHeight);
+        Clear();
+    }
+
+    const Shader* currentShader = nullptr;
+    const Mesh* currentMesh = nullptr;
+    GLuint currentTexture = 0xFFFFFFFFu;
+    int currentPass = -1;
+
+    for (size_t i = 0; i < M_CommandCount; ++i) {
+        const RenderCommand& command = M_Commands[entries[i].index];
+
+        int pass = static_cast<int>(command.SortKey >> KEY_PASS_SHIFT);
+        if (pass != currentPass) {
+            if (M_DynamicResolution && pass >= static_cast<int>(RenderPass::Overlay)) {
+                M_DynamicResolution->Resolve(); // Overlays are drawn at full resolution
+            }
+            applyPassState(static_cast<RenderPass>(pass));
+            currentPass = pass;
+        }
+        if (command.shader != currentShader) {
+            if (M_GpuTimer) {
+                M_GpuTimer->Begin(command.shader->GetName()); // Closes the previous program's section
+            }
+            command.shader->use();
+            currentShader = command.shader;
+            ++M_Stats.shaderChanges;
+        }
+        if (command.textureID != currentTexture) {
+            GLStateCache::BindTexture(0, command.textureTarget, command.textureID);
+            currentTexture = command.textureID;
+            ++M_Stats.textureChanges;
+        }
+        if (command.mesh != currentMesh) {
+            currentMesh = command.mesh;
+            ++M_Stats.meshChanges;
+        }
+
+        command.shader->setMat4(command.shader->GetModelLocation(), command.model); // Cached location
+        command.mesh->Draw(*command.shader); // Mesh::Draw binds VAO (if needed) and draws
+        ++M_Stats.drawCalls;
+    }
+
+    if (M_GpuTimer) {
+        M_GpuTimer->End();
+    }
+    if (M_DynamicResolution) {
+        M_DynamicResolution->Resolve(); // No-op if an overlay already triggered it
+    }
+
+    // The ring region can be reused once the GPU has finished these draws
+    M_FrameData->EndFrame();
+
+    // Leave default depth state for the next frame's clear and for code outside the queue
+    applyPassState(RenderPass::Opaque);
+    M_CommandCount = 0;
 }
 
-void Renderer::SetShaderMatrices(Shader& shader) {
-    // Set view and projection matrices in the shader
-    shader.setMat4("view", M_ViewMatrix);
-    shader.setMat4("projection", M_ProjectionMatrix);
-}
\ No newline at end of file
+void Renderer::applyPassState(RenderPass pass) {
+    switch (pass) {
+        case RenderPass::Opaque:
+            GLStateCache::DepthMask(true);
+            GLStateCache::DepthFunc(GL_LESS);
+            GLStateCache::SetBlend(false);
+            break;
+        case RenderPass::Skybox:
+            // The skybox is at depth 1.0 (pos.xyww): pass only where nothing was drawn
+            GLStateCache::DepthMask(false);
+            GLStateCache::DepthFunc(GL_LEQUAL);
+            GLStateCache::SetBlend(false);
+            break;
+        case RenderPass::Overlay:
+            GLStateCache::DepthMask(false);
+            GLStateCache::DepthFunc(GL_ALWAYS);
+            GLStateCache::SetBlend(true);
+            GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+    }
+}
@@ -2,37 +2,129 @@
 
 #include "Shader.h"
 #include "Mesh.h"
-#include "Camera.h" // Renderer needs to know about the camera for view/projection
+#include "Texture.h"
+#include "camera.h" // Renderer needs to know about the camera for view/projection
+#include "UniformBuffer.h"
+#include "GpuTimer.h"
+#include "StreamBuffer.h"
+#include "DynamicResolution.h"
+#include "../Utils/FrameArena.h"
 
 #include <glm/glm.hpp>
+#include <memory>
+#include <cstdint>
+
+// Passes are executed in this order. The skybox goes last so it only shades pixels that
+// no opaque geometry covered (it is drawn at the far plane with depth writes off).
+// Overlays are screen-space UI drawn on top of everything, alpha blended, without depth.
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Skybox = 1,
+    Overlay = 2
+};
+
+// A recorded draw. Kept trivially copyable so the queue can live in a FrameArena.
+struct RenderCommand {
+    uint64_t SortKey;
+    Shader* shader;
+    Mesh* mesh;
+    GLenum textureTarget;
+    GLuint textureID;
+    glm::mat4 model;
+};
 
 class Renderer {
 public:
+    // Per-frame counters of what EndScene actually issued
+    struct Stats {
+        uint32_t commands = 0;
+        uint32_t drawCalls = 0;
+        uint32_t shaderChanges = 0;
+        uint32_t textureChanges = 0;
+        uint32_t meshChanges = 0;
+    };
+
     Renderer();
     ~Renderer();
 
     void Clear() const;
 
-    // Sets up view and projection matrices for the scene
+    // Sets up view and projection matrices for the scene, writes them to the shared Camera
+    // uniform block (streamed, see GetFrameData) and starts a new command queue
     void BeginScene(Camera& camera, float screenWidth, float screenHeight);
 
-    // Submits a mesh to be rendered with a specific shader and model transformation
-    void Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform = glm::mat4(1.0f));
-    // Alternatively, a more direct Draw function:
-    // void Draw(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform = glm::mat4(1.0f));
+    // Uploads the directional light to the shared Lighting uniform block.
+    // Only needs calling when the light changes.
+    void SetLighting(const glm::vec3& direction, const glm::vec3& color, float ambientIntensity);
+
+    // Updates just the time in the Lighting block (once per frame, for the point light flicker)
+    void SetLightingTime(float seconds);
+
+    // Updates just the shadow map matrix in the Lighting block (when the map's region moves)
+    void SetShadowSpace(const glm::mat4& shadowSpace);
+
+    // Records a draw. Nothing is drawn until EndScene, so all state the draw needs (program,
+    // texture, model matrix) must be part of the command rather than set beforehand.
+    void Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform = glm::mat4(1.0f),
+                const Texture* texture = nullptr, RenderPass pass = RenderPass::Opaque);
+    void Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform,
+                GLenum textureTarget, GLuint textureID, RenderPass pass = RenderPass::Opaque);
+    // Opaque draws are ordered front to back by the model matrix origin. Meshes built in world
+    // space (identity model, like the maze chunks) pass a world position for that instead,
+    // usually their bounds centre.
+    void Submit(Shader& shader, Mesh& mesh, const glm::mat4& modelTransform,
+                GLenum textureTarget, GLuint textureID, const glm::vec3& sortPosition,
+                RenderPass pass = RenderPass::Opaque);
 
-    void EndScene(); // For now, might not do much
+    // Sorts the recorded commands by key and executes them with minimal state changes
+    void EndScene();
 
     // Getter methods for view and projection matrices
     const glm::mat4& GetViewMatrix() const { return M_ViewMatrix; }
     const glm::mat4& GetProjectionMatrix() const { return M_ProjectionMatrix; }
 
-    // Method to set view and projection uniforms for a shader
-    void SetShaderMatrices(Shader& shader);
+    // Counters for the last EndScene
+    const Stats& GetStats() const { return M_Stats; }
+
+    // Ring buffer for data that changes every frame. Space allocated between BeginScene and
+    // EndScene stays valid until this frame's draws are done; EndScene commits it before drawing.
+    StreamBuffer& GetFrameData() { return *M_FrameData; }
+    // Offset alignment required to bind a range of it as a uniform block
+    size_t GetUniformBufferAlignment() const { return M_UniformAlignment; }
+
+    // Optional: time each run of draws sharing a program on the GPU, labelled with the
+    // program's name (so shader variants show up separately). nullptr turns it off.
+    void SetGpuTimer(GpuTimer* timer) { M_GpuTimer = timer; }
+
+    // Optional: render the Opaque and Skybox passes at a reduced resolution and upscale them
+    // before the Overlay pass, which stays at full resolution. nullptr turns it off.
+    void SetDynamicResolution(DynamicResolution* dynamicResolution) { M_DynamicResolution = dynamicResolution; }
 
 private:
     // Store current view and projection matrices for the frame
     // This avoids passing them around constantly or recalculating if camera hasn't moved
     glm::mat4 M_ViewMatrix;
     glm::mat4 M_ProjectionMatrix;
+
+    // Per-frame data shared by every program through std140 uniform blocks. The camera
+    // changes every frame, so its block lives in the streaming buffer; lighting rarely changes.
+    std::unique_ptr<StreamBuffer> M_FrameData;
+    size_t M_UniformAlignment;
+    std::unique_ptr<UniformBuffer> M_LightingUBO;
+
+    // Command queue for the current frame, allocated from M_Arena
+    FrameArena M_Arena;
+    RenderCommand* M_Commands;
+    size_t M_CommandCount;
+    size_t M_CommandCapacity; // Persists across frames so the queue is sized after warm-up
+
+    Stats M_Stats;
+    GpuTimer* M_GpuTimer;
+    DynamicResolution* M_DynamicResolution;
+    int M_ScreenWidth;  // From BeginScene, for the dynamic resolution target
+    int M_ScreenHeight;
+
+    uint64_t makeSortKey(RenderPass pass, const Shader& shader, GLuint textureID, const Mesh& mesh,
+                         const glm::vec3& sortPosition) const;
+    void applyPassState(RenderPass pass);
 };
@@ -1,7 +1,56 @@
 #include "Shader.h"
+#include "UniformBuffer.h"
+#include "GLStateCache.h"
+#include "GLUtils.h"
+#include "ShaderCache.h"
+#include <chrono>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+    // "#define NAME 1" lines go right after the #version directive, which must stay first
+    std::string injectDefines(const std::string& source, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+        {
+            return source;
+        }
+        std::string block;
+        for (const std::string& define : defines)
+        {
+            block += "#define " + define + " 1\n";
+        }
+
+        size_t insertAt = 0;
+        size_t version = source.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = source.find('\n', version);
+            insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+        }
+        std::string result = source;
+        if (insertAt == result.size() && !result.empty() && result.back() != '\n')
+        {
+            result += '\n';
+            insertAt = result.size();
+        }
+        result.insert(insertAt, block);
+        return result;
+    }
+}
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : Shader(vertexPath, fragmentPath, std::vector<std::string>())
+{
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines)
+    : M_Name(fragmentPath), M_ModelLocation(-1), M_CacheKey(0), M_LinkPending(false), M_Linked(false), M_VertexShader(0), M_FragmentShader(0)
 {
+    auto start = std::chrono::steady_clock::now();
+
     std::string vertexCode; // Vertex shader code
     std::string fragmentCode; // Fragment shader code
     std::ifstream vShaderFile; // Vertex shader file
@@ -29,102 +78,272 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
     }
 
-    const char* vShaderCode = vertexCode.c_str(); // Convert vertex shader string to C-style string
-    const char* fShaderCode = fragmentCode.c_str(); // Convert fragment shader string to C-style string
+    // Feature switches for this variant; the cache key below covers them since it hashes the result
+    vertexCode = injectDefines(vertexCode, defines);
+    fragmentCode = injectDefines(fragmentCode, defines);
 
-    unsigned int vertex, fragment; // Shader IDs
+    ID = glCreateProgram(); // Create shader program
+    M_CacheKey = ShaderCache::IsEnabled() ? ShaderCache::MakeKey(vertexCode, fragmentCode) : 0;
 
-    vertex = glCreateShader(GL_VERTEX_SHADER); // Create vertex shader
-    glShaderSource(vertex, 1, &vShaderCode, NULL); // Set vertex shader source code
-    glCompileShader(vertex); // Compile vertex shader
-    checkCompileErrors(vertex, "VERTEX"); // Check for compilation errors in vertex shader
+    ShaderCache::Stats& stats = ShaderCache::GetStats();
+    if (M_CacheKey != 0 && ShaderCache::Load(ID, M_CacheKey))
+    {
+        // Restored from the binary cache: already linked, nothing to wait for
+        ++stats.binaryHits;
+        M_Linked = true;
+        finishLink();
+    }
+    else
+    {
+        const char* vShaderCode = vertexCode.c_str(); // Convert vertex shader string to C-style string
+        const char* fShaderCode = fragmentCode.c_str(); // Convert fragment shader string to C-style string
+
+        M_VertexShader = glCreateShader(GL_VERTEX_SHADER); // Create vertex shader
+        glShaderSource(M_VertexShader, 1, &vShaderCode, NULL); // Set vertex shader source code
+        glCompileShader(M_VertexShader); // Compile vertex shader
+
+        M_FragmentShader = glCreateShader(GL_FRAGMENT_SHADER); // Create fragment shader
+        glShaderSource(M_FragmentShader, 1, &fShaderCode, NULL); // Set fragment shader source code
+        glCompileShader(M_FragmentShader); // Compile fragment shader
+
+        glAttachShader(ID, M_VertexShader); // Attach vertex shader to program
+        glAttachShader(ID, M_FragmentShader); // Attach fragment shader to program
+        ShaderCache::PrepareForSave(ID);
+        glLinkProgram(ID); // Link shader program
+
+        // Compile and link status are not queried here: the driver may still be working on them
+        // (in parallel with KHR_parallel_shader_compile), and asking would block. The results
+        // are collected on first use, see ensureLinked().
+        M_LinkPending = true;
+        ++stats.compiled;
+    }
+    stats.createMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER); // Create fragment shader
-    glShaderSource(fragment, 1, &fShaderCode, NULL); // Set fragment shader source code
-    glCompileShader(fragment); // Compile fragment shader
-    checkCompileErrors(fragment, "FRAGMENT"); // Check for compilation errors in fragment shader
+bool Shader::IsReady() const
+{
+    if (!M_LinkPending)
+    {
+        return true;
+    }
+    if (!GetGLOptionalFunctions().parallelShaderCompile)
+    {
+        return false; // No way to ask without blocking
+    }
+    GLint complete = GL_FALSE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
 
-    ID = glCreateProgram(); // Create shader program
-    glAttachShader(ID, vertex); // Attach vertex shader to program
-    glAttachShader(ID, fragment); // Attach fragment shader to program
-    glLinkProgram(ID); // Link shader program
-    checkCompileErrors(ID, "PROGRAM"); // Check for linking errors in shader program
+bool Shader::IsLinked() const
+{
+    ensureLinked();
+    return M_Linked;
+}
 
-    glDeleteShader(vertex); // Delete vertex shader
-    glDeleteShader(fragment); // Delete fragment shader
+void Shader::ensureLinked() const
+{
+    if (!M_LinkPending)
+    {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    checkCompileErrors(M_VertexShader, "VERTEX"); // Check for compilation errors in vertex shader
+    checkCompileErrors(M_FragmentShader, "FRAGMENT"); // Check for compilation errors in fragment shader
+    GLint linked = checkCompileErrors(ID, "PROGRAM"); // Check for linking errors in shader program
+
+    glDetachShader(ID, M_VertexShader);
+    glDetachShader(ID, M_FragmentShader);
+    glDeleteShader(M_VertexShader); // Delete vertex shader
+    glDeleteShader(M_FragmentShader); // Delete fragment shader
+    M_VertexShader = 0;
+    M_FragmentShader = 0;
+    M_LinkPending = false;
+    M_Linked = linked != 0;
+
+    finishLink();
+    if (linked && M_CacheKey != 0)
+    {
+        ShaderCache::Save(ID, M_CacheKey); // Next launch skips compilation
+    }
+
+    ShaderCache::GetStats().finalizeMs +=
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Shader::finishLink() const
+{
+    cacheUniformLocations(); // Resolve all uniform locations once
+
+    // Shared per-frame blocks (no-ops for programs that don't declare them)
+    BindUniformBlock("Camera", UniformBlockBinding::Camera);
+    BindUniformBlock("Lighting", UniformBlockBinding::Lighting);
 }
 
 Shader::~Shader()
 {
+    if (M_LinkPending)
+    {
+        glDeleteShader(M_VertexShader);
+        glDeleteShader(M_FragmentShader);
+    }
+    GLStateCache::OnProgramDeleted(ID);
     glDeleteProgram(ID); // Delete shader program
 }
 
 void Shader::use()
 {
-    glUseProgram(ID); // Use shader program
+    ensureLinked();
+    GLStateCache::UseProgram(ID); // Use shader program (skipped if already current)
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); // Set boolean uniform
+    glUniform1i(GetUniformLocation(name), (int)value); // Set boolean uniform
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); // Set integer uniform
+    glUniform1i(GetUniformLocation(name), value); // Set integer uniform
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); // Set float uniform
+    glUniform1f(GetUniformLocation(name), value); // Set float uniform
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(GetUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(GetUniformLocation(name), x, y);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(GetUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(GetUniformLocation(name), x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(GetUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(GetUniformLocation(name), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
+    glUniformMatrix2fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
 }
 
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
+    glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
+    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat)); // Set matrix uniform
+}
+
+GLint Shader::GetUniformLocation(const std::string& name) const
+{
+    ensureLinked();
+    auto it = M_UniformLocations.find(name);
+    return it != M_UniformLocations.end() ? it->second : -1; // -1 makes glUniform* a no-op
+}
+
+void Shader::setInt(GLint location, int value) const
+{
+    glUniform1i(location, value);
+}
+
+void Shader::setFloat(GLint location, float value) const
+{
+    glUniform1f(location, value);
+}
+
+void Shader::setVec3(GLint location, const glm::vec3& value) const
+{
+    glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setVec4(GLint location, const glm::vec4& value) const
+{
+    glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::setVec4Array(GLint location, const glm::vec4* values, int count) const
+{
+    glUniform4fv(location, count, &values[0][0]);
+}
+
+void Shader::setMat3(GLint location, const glm::mat3& mat) const
+{
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::setMat4(GLint location, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::BindUniformBlock(const std::string& blockName, unsigned int bindingPoint) const
+{
+    GLuint blockIndex = glGetUniformBlockIndex(ID, blockName.c_str());
+    if (blockIndex != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(ID, blockIndex, bindingPoint);
+    }
+}
+
+void Shader::cacheUniformLocations() const
+{
+    M_UniformLocations.clear();
+
+    GLint uniformCount = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+    GLchar nameBuffer[256];
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), sizeof(nameBuffer), &length, &size, &type, nameBuffer);
+        std::string name(nameBuffer, length);
+
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0)
+        {
+            continue; // Members of uniform blocks have no location
+        }
+        M_UniformLocations[name] = location;
+
+        // Arrays are reported as "name[0]"; make them reachable by their plain name as well
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos)
+        {
+            M_UniformLocations[name.substr(0, bracket)] = location;
+        }
+    }
+
+    M_ModelLocation = GetUniformLocation("model");
 }
 
-void Shader::checkCompileErrors(GLuint shader, std::string type)
+GLint Shader::checkCompileErrors(GLuint shader, std::string type) const
 {
     GLint success; // Compilation status
     GLchar infoLog[1024]; // Error message buffer
@@ -146,6 +365,7 @@ void Shader::checkCompileErrors(GLuint shader, std::string type)
             std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
+    return success;
 }
 
 
@@ -154,21 +374,32 @@ void Shader::checkCompileErrors(GLuint shader, std::string type)
  Explanation:
   Constructor (Shader::Shader):
       Takes paths to vertex and fragment shader files.
-      Reads the content of these files into strings.
-      Creates a vertex shader object (glCreateShader(GL_VERTEX_SHADER)), sets its source (glShaderSource), and compiles it (glCompileShader).
-      Does the same for the fragment shader.
-      Creates a shader program (glCreateProgram()), attaches the compiled shaders (glAttachShader), and links them (glLinkProgram).
-      Calls checkCompileErrors to report any issues during compilation or linking.
-      Deletes the individual shader objects (glDeleteShader) after linking, as they are now part of the program.
+      Reads the content of these files into strings. The overload taking defines inserts "#define NAME 1" lines
+      after the #version directive of both sources, which is how ShaderVariants builds specialised programs.
+      Tries ShaderCache first: a program binary saved by an earlier run for the same sources and driver is
+      restored with glProgramBinary, skipping compilation entirely.
+      Otherwise creates the vertex and fragment shader objects, sets their sources and compiles them, then
+      attaches them to a new program and links it. Nothing is queried yet, so the constructor returns while
+      the driver is still compiling; several programs created back to back compile in parallel on drivers
+      that support it.
+
+      ensureLinked():
+          Runs on first use (use() or a uniform lookup). Calls checkCompileErrors to report any issues,
+          deletes the individual shader objects, resolves uniform locations and saves the binary to the cache.
+          IsLinked() forces it and reports the outcome, so failures surface where the result is read rather
+          than at construction (where the program ID is valid either way).
 
       Destructor (Shader::~Shader):
           Cleans up by deleting the shader program (glDeleteProgram(ID)).
 
       use():
-          Activates the shader program for subsequent rendering calls (glUseProgram(ID)).
+          Activates the shader program for subsequent rendering calls (glUseProgram(ID) through GLStateCache,
+          so re-activating the current program costs nothing).
 
       setBool, setInt, setFloat:
-          These are helper functions to set uniform variables in the shader. glGetUniformLocation finds the location of a uniform by its name, and glUniform* functions set its value. We'll add more for vectors and matrices when we need GLM.
+          These are helper functions to set uniform variables in the shader. Locations are looked up in a table
+          filled once after linking (cacheUniformLocations), and glUniform* functions set the value. The overloads
+          taking a GLint location skip the lookup for code that sets the same uniform many times per frame.
 
       checkCompileErrors():
           A private helper to check for errors after compiling a shader or linking a program. It prints error messages to std::cerr.
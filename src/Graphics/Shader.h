@@ -7,15 +7,36 @@
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
 class Shader
 {
 public:
     unsigned int ID; // Shader program ID
 
+    // Starts compiling and linking (or restores the program from ShaderCache) without waiting
+    // for the result; the first use() or uniform lookup collects it.
     Shader(const char *vertexPath, const char *fragmentPath);
+    // Same, with "#define NAME 1" injected into both stages for each entry (see ShaderVariants)
+    Shader(const char *vertexPath, const char *fragmentPath, const std::vector<std::string> &defines);
     ~Shader();
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    // Label for diagnostics such as GPU timings (defaults to the fragment shader path)
+    const std::string& GetName() const { return M_Name; }
+    void SetName(const std::string &name) { M_Name = name; }
     void use();
+
+    // Non-blocking: true once the program can be used without stalling. Only drivers with
+    // KHR_parallel_shader_compile can answer this before the program is first used.
+    bool IsReady() const;
+    // Blocking: collects the compile/link result if it is still pending (printing any errors)
+    // and returns whether the program linked
+    bool IsLinked() const;
     void setBool(const std::string &name, bool value) const; 
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
@@ -30,6 +51,37 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
+    // Uniform locations are resolved once after linking. Look a location up once and use the
+    // handle-based setters below in hot loops to skip the name lookup entirely.
+    GLint GetUniformLocation(const std::string &name) const;
+    GLint GetModelLocation() const { ensureLinked(); return M_ModelLocation; }
+
+    void setInt(GLint location, int value) const;
+    void setFloat(GLint location, float value) const;
+    void setVec3(GLint location, const glm::vec3 &value) const;
+    void setVec4(GLint location, const glm::vec4 &value) const;
+    void setVec4Array(GLint location, const glm::vec4 *values, int count) const; // Arrays are cached without "[0]"
+    void setMat3(GLint location, const glm::mat3 &mat) const;
+    void setMat4(GLint location, const glm::mat4 &mat) const;
+
+    // Connects a named std140 block in this program to a uniform buffer binding point
+    void BindUniformBlock(const std::string &blockName, unsigned int bindingPoint) const;
+
 private:
-    void checkCompileErrors(GLuint shader, std::string type);
+    std::string M_Name;
+
+    // Filled in when the link result is collected, hence mutable
+    mutable std::unordered_map<std::string, GLint> M_UniformLocations;
+    mutable GLint M_ModelLocation;
+
+    uint64_t M_CacheKey;                 // 0 when the binary cache is unavailable
+    mutable bool M_LinkPending;          // Compile/link issued but results not collected yet
+    mutable bool M_Linked;               // Valid once M_LinkPending is false
+    mutable GLuint M_VertexShader;
+    mutable GLuint M_FragmentShader;
+
+    GLint checkCompileErrors(GLuint shader, std::string type) const;
+    void cacheUniformLocations() const;
+    void ensureLinked() const;
+    void finishLink() const;
 };
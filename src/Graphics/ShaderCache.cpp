@@ -0,0 +1,153 @@
+#include "ShaderCache.h"
+#include "GLUtils.h"
+#include "../Utils/Utils.h"
+#include "../Utils/FileSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+namespace {
+    const char BINARY_MAGIC[4] = { 'M', 'S', 'H', 'B' };
+    const uint32_t BINARY_VERSION = 1;
+
+    bool g_Enabled = true;
+    std::string g_Directory = "shader_cache";
+    ShaderCache::Stats g_Stats;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t length;
+    };
+
+    std::string pathFor(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return g_Directory + "/" + name;
+    }
+
+    // Vendor, renderer and version strings: binaries are only valid for the exact same driver
+    uint64_t driverHash() {
+        static uint64_t hash = 0;
+        if (hash == 0) {
+            const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+            hash = HashBytes(&BINARY_VERSION, sizeof(BINARY_VERSION));
+            for (GLenum name : names) {
+                const char* value = reinterpret_cast<const char*>(glGetString(name));
+                if (value)
+                    hash = HashBytes(value, std::strlen(value), hash);
+            }
+        }
+        return hash;
+    }
+}
+
+void ShaderCache::SetEnabled(bool enabled)
+{
+    g_Enabled = enabled;
+}
+
+bool ShaderCache::IsEnabled()
+{
+    return g_Enabled && GetGLOptionalFunctions().programBinary;
+}
+
+void ShaderCache::SetDirectory(const std::string& directory)
+{
+    g_Directory = directory;
+}
+
+uint64_t ShaderCache::MakeKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    uint64_t hash = driverHash();
+    hash = HashBytes(vertexSource.data(), vertexSource.size(), hash);
+    const char separator = 0; // Keeps "ab" + "c" distinct from "a" + "bc"
+    hash = HashBytes(&separator, 1, hash);
+    return HashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+}
+
+bool ShaderCache::Load(GLuint program, uint64_t key)
+{
+    if (!IsEnabled())
+        return false;
+
+    std::vector<unsigned char> data;
+    if (!ReadFileBytes(pathFor(key), data) || data.size() < sizeof(FileHeader))
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!std::equal(header.magic, header.magic + 4, BINARY_MAGIC) || header.version != BINARY_VERSION ||
+        header.key != key || header.length != data.size() - sizeof(header))
+        return false;
+
+    GetGLOptionalFunctions().ProgramBinary(program, header.binaryFormat, data.data() + sizeof(header),
+                                           static_cast<GLsizei>(header.length));
+
+    // Drivers may reject binaries at any time (e.g. after an update that kept the version string)
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+void ShaderCache::PrepareForSave(GLuint program)
+{
+    if (IsEnabled())
+        GetGLOptionalFunctions().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ShaderCache::Save(GLuint program, uint64_t key)
+{
+    if (!IsEnabled())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<unsigned char> binary(static_cast<size_t>(length));
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    GetGLOptionalFunctions().GetProgramBinary(program, length, &written, &binaryFormat, binary.data());
+    if (written <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(g_Directory, error);
+
+    std::ofstream file(pathFor(key), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write shader cache: " << pathFor(key) << std::endl;
+        return;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.length = static_cast<uint32_t>(written);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(binary.data()), written);
+}
+
+ShaderCache::Stats& ShaderCache::GetStats()
+{
+    return g_Stats;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+// On-disk cache of linked program binaries.
+// Programs are keyed by a hash of their sources and the driver identification strings, so a
+// driver update or an edited shader simply misses and the program is compiled (and saved)
+// again. Needs GL 4.1 or ARB_get_program_binary; without it every call is a miss.
+class ShaderCache {
+public:
+    struct Stats {
+        int binaryHits = 0;       // Programs restored with glProgramBinary
+        int compiled = 0;         // Programs compiled from source
+        double createMs = 0.0;    // Time spent in Shader constructors
+        double finalizeMs = 0.0;  // Time spent waiting for compile/link results on first use
+    };
+
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // Directory the binaries are written to (created on first save)
+    static void SetDirectory(const std::string& directory);
+
+    static uint64_t MakeKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+    // Restores a program from the cache. Returns false on a miss or if the driver rejects the
+    // binary; the program object can then be compiled and linked as usual.
+    static bool Load(GLuint program, uint64_t key);
+    // Saves a successfully linked program
+    static void Save(GLuint program, uint64_t key);
+
+    // Must be called before linking so the driver keeps the binary around
+    static void PrepareForSave(GLuint program);
+
+    static Stats& GetStats();
+};
@@ -0,0 +1,79 @@
+#include "ShaderVariants.h"
+
+namespace {
+    struct FeatureName {
+        uint32_t bit;
+        const char* define;
+    };
+
+    const FeatureName FEATURE_NAMES[] = {
+        { ShaderFeature::Specular, "SPECULAR" },
+        { ShaderFeature::Ceiling, "CEILING" },
+        { ShaderFeature::Instanced, "INSTANCED" },
+        { ShaderFeature::Unlit, "UNLIT" },
+        { ShaderFeature::PointLights, "POINT_LIGHTS" },
+        { ShaderFeature::BakedLighting, "BAKED_LIGHTING" },
+        { ShaderFeature::Shadows, "SHADOWS" },
+        { ShaderFeature::Impostor, "IMPOSTOR" }
+    };
+}
+
+ShaderVariants::ShaderVariants(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath)
+    : M_Name(name), M_VertexPath(vertexPath), M_FragmentPath(fragmentPath)
+{
+}
+
+Shader& ShaderVariants::Get(uint32_t features)
+{
+    auto it = M_Variants.find(features);
+    if (it != M_Variants.end())
+        return *it->second;
+
+    std::vector<std::string> defines;
+    for (const FeatureName& feature : FEATURE_NAMES)
+    {
+        if (features & feature.bit)
+            defines.push_back(feature.define);
+    }
+
+    std::unique_ptr<Shader> shader = std::make_unique<Shader>(M_VertexPath.c_str(), M_FragmentPath.c_str(), defines);
+    std::string description = DescribeFeatures(features);
+    shader->SetName(description.empty() ? M_Name : M_Name + "[" + description + "]");
+    if (M_Initializer)
+        M_Initializer(*shader);
+
+    Shader& result = *shader;
+    M_Variants.emplace(features, std::move(shader));
+    return result;
+}
+
+void ShaderVariants::SetInitializer(std::function<void(Shader&)> initializer)
+{
+    M_Initializer = std::move(initializer);
+    if (!M_Initializer)
+        return;
+    for (auto& variant : M_Variants)
+        M_Initializer(*variant.second);
+}
+
+bool ShaderVariants::IsLinked() const
+{
+    bool linked = true;
+    for (const auto& variant : M_Variants)
+        linked = variant.second->IsLinked() && linked; // Collect all, so every error is printed
+    return linked;
+}
+
+std::string ShaderVariants::DescribeFeatures(uint32_t features)
+{
+    std::string description;
+    for (const FeatureName& feature : FEATURE_NAMES)
+    {
+        if (!(features & feature.bit))
+            continue;
+        if (!description.empty())
+            description += "|";
+        description += feature.define;
+    }
+    return description;
+}
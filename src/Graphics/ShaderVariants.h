@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Feature switches compiled into a shader variant. Each bit becomes a #define of the same
+// name (upper case) in both stages, so a variant contains only the code its draws need
+// instead of branching on uniforms per fragment.
+namespace ShaderFeature {
+    enum : uint32_t {
+        Specular  = 1u << 0, // SPECULAR: Phong highlight from the material table
+        Ceiling   = 1u << 1, // CEILING: flat horizontal surface, constant normal, no specular
+        Instanced = 1u << 2, // INSTANCED: per-instance model matrix from attributes 4-7
+        Unlit     = 1u << 3, // UNLIT: texture color only
+        PointLights = 1u << 4, // POINT_LIGHTS: clustered point lights (see LightSystem)
+        BakedLighting = 1u << 5, // BAKED_LIGHTING: static lights and occlusion from LightBaker's volumes
+        Shadows = 1u << 6, // SHADOWS: directional light shadowed by ShadowMap
+        Impostor = 1u << 7 // IMPOSTOR: far LOD chunk box, walls ray-marched through MazeMesh's wall mask
+    };
+}
+
+// Lazily built permutations of one vertex/fragment shader pair.
+// Get(features) returns the program for that combination, creating it on first request.
+// Creating all variants a scene needs up front lets them compile in parallel (and come from
+// ShaderCache on later launches, each variant being cached under its own key).
+class ShaderVariants {
+public:
+    ShaderVariants(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    Shader& Get(uint32_t features);
+
+    // Called for every variant, existing and future, e.g. to set constant uniforms once.
+    // It runs right after creation, so it forces the variant's link to finish.
+    void SetInitializer(std::function<void(Shader&)> initializer);
+
+    // Shader::IsLinked for every variant created so far; true when there are none
+    bool IsLinked() const;
+
+    size_t GetVariantCount() const { return M_Variants.size(); }
+
+    // "SPECULAR|INSTANCED"; empty for the base variant
+    static std::string DescribeFeatures(uint32_t features);
+
+private:
+    std::string M_Name;
+    std::string M_VertexPath;
+    std::string M_FragmentPath;
+    std::unordered_map<uint32_t, std::unique_ptr<Shader>> M_Variants;
+    std::function<void(Shader&)> M_Initializer;
+};
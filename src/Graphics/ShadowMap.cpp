@@ -0,0 +1,261 @@
+#include "ShadowMap.h"
+#include "GLStateCache.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    enum MapIndex { STATIC_MAP = 0, COMPOSITE_MAP = 1 };
+}
+
+ShadowMap::ShadowMap(int resolution, float regionSize)
+    : M_Resolution(std::max(16, resolution)), M_RegionSize(std::max(regionSize, 1.0f)), M_LightSpace(1.0f),
+      M_BoundsMin(0.0f), M_BoundsMax(0.0f), M_LightDirection(0.0f), M_RegionCenter(0.0f), M_StaticDirty(true), M_CompositeStale(true), M_HasComposite(false), M_SavedFramebuffer(0)
+{
+    for (int i = 0; i < 4; ++i)
+        M_SavedViewport[i] = 0;
+
+    glGenTextures(2, M_Textures);
+    glGenFramebuffers(2, M_Framebuffers);
+    const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // Outside the map counts as lit
+    for (int i = 0; i < 2; ++i)
+    {
+        GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D, M_Textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, M_Resolution, M_Resolution, 0,
+                     GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        // Hardware depth comparison with bilinear filtering: each lookup is a 2x2 PCF
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, M_Textures[i], 0);
+        glDrawBuffer(GL_NONE); // Depth only
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ShadowMap: framebuffer " << i << " is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+ShadowMap::~ShadowMap()
+{
+    glDeleteFramebuffers(2, M_Framebuffers);
+    for (GLuint texture : M_Textures)
+        GLStateCache::OnTextureDeleted(texture);
+    glDeleteTextures(2, M_Textures);
+}
+
+void ShadowMap::Setup(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& lightDirection)
+{
+    glm::vec3 direction = glm::normalize(lightDirection);
+    if (boundsMin == M_BoundsMin && boundsMax == M_BoundsMax && direction == M_LightDirection)
+        return;
+    M_BoundsMin = boundsMin;
+    M_BoundsMax = boundsMax;
+    M_LightDirection = direction;
+
+    // Centred until the first Focus
+    M_RegionCenter = glm::vec2(boundsMin.x + boundsMax.x, boundsMin.z + boundsMax.z) * 0.5f;
+    fit();
+}
+
+bool ShadowMap::Focus(const glm::vec3& position)
+{
+    // Snapped to a quarter of the region, so small moves keep the cached map
+    const float step = M_RegionSize * 0.25f;
+    const float half = M_RegionSize * 0.5f;
+    auto place = [&](float p, float boundsMin, float boundsMax) {
+        if (boundsMax - boundsMin <= M_RegionSize)
+            return (boundsMin + boundsMax) * 0.5f;
+        float snapped = (std::floor(p / step) + 0.5f) * step;
+        return std::min(std::max(snapped, boundsMin + half), boundsMax - half);
+    };
+    glm::vec2 center(place(position.x, M_BoundsMin.x, M_BoundsMax.x), place(position.z, M_BoundsMin.z, M_BoundsMax.z));
+    if (center == M_RegionCenter)
+        return false;
+    M_RegionCenter = center;
+    fit();
+    return true;
+}
+
+bool ShadowMap::Overlaps(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+{
+    return !projectBounds(boundsMin, boundsMax).IsEmpty();
+}
+
+void ShadowMap::fit()
+{
+    const float half = M_RegionSize * 0.5f;
+    glm::vec3 regionMin(std::max(M_BoundsMin.x, M_RegionCenter.x - half), M_BoundsMin.y,
+                        std::max(M_BoundsMin.z, M_RegionCenter.y - half));
+    glm::vec3 regionMax(std::min(M_BoundsMax.x, M_RegionCenter.x + half), M_BoundsMax.y,
+                        std::min(M_BoundsMax.z, M_RegionCenter.y + half));
+
+    // Orthographic box tight around the region in light space; its depth range spans the
+    // whole bounds, so casters outside the region still shadow into it
+    glm::vec3 center = (regionMin + regionMax) * 0.5f;
+    glm::vec3 up = std::fabs(M_LightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 view = glm::lookAt(center - M_LightDirection, center, up);
+    glm::vec3 viewMin(1e30f), viewMax(-1e30f);
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 regionCorner((corner & 1) ? regionMax.x : regionMin.x, (corner & 2) ? regionMax.y : regionMin.y,
+                               (corner & 4) ? regionMax.z : regionMin.z);
+        glm::vec3 boundsCorner((corner & 1) ? M_BoundsMax.x : M_BoundsMin.x, (corner & 2) ? M_BoundsMax.y : M_BoundsMin.y,
+                               (corner & 4) ? M_BoundsMax.z : M_BoundsMin.z);
+        glm::vec3 r = glm::vec3(view * glm::vec4(regionCorner, 1.0f));
+        glm::vec3 b = glm::vec3(view * glm::vec4(boundsCorner, 1.0f));
+        viewMin = glm::min(viewMin, glm::vec3(r.x, r.y, std::min(r.z, b.z)));
+        viewMax = glm::max(viewMax, glm::vec3(r.x, r.y, std::max(r.z, b.z)));
+    }
+    // The view looks down -z
+    glm::mat4 projection = glm::ortho(viewMin.x, viewMax.x, viewMin.y, viewMax.y, -viewMax.z - 1.0f, -viewMin.z + 1.0f);
+    M_LightSpace = projection * view;
+
+    M_StaticDirty = true;
+}
+
+glm::mat4 ShadowMap::GetShadowMatrix() const
+{
+    // Clip space [-1, 1] to texture coordinates and depth [0, 1]
+    glm::mat4 bias(0.5f);
+    bias[3] = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+    return bias * M_LightSpace;
+}
+
+bool ShadowMap::BeginStatic(Shader& depthShader)
+{
+    if (!M_StaticDirty)
+        return false;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &M_SavedFramebuffer); // The scene may render offscreen
+    begin(STATIC_MAP, depthShader);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    M_StaticDirty = false;
+    M_CompositeStale = true; // The composite holds the old static map
+    ++M_Stats.staticRenders;
+    return true;
+}
+
+void ShadowMap::EndStatic()
+{
+    end();
+}
+
+void ShadowMap::BeginDynamic(Shader& depthShader, const glm::vec3& casterMin, const glm::vec3& casterMax)
+{
+    // Saved before the restore blit rebinds the read and draw framebuffers
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &M_SavedFramebuffer);
+    Rect rect = projectBounds(casterMin, casterMax);
+
+    // Restore what the casters drew last frame (or everything after a static update)
+    Rect restore = rect;
+    if (M_CompositeStale)
+    {
+        restore.x0 = restore.y0 = 0;
+        restore.x1 = restore.y1 = M_Resolution;
+    }
+    else if (!M_DynamicRect.IsEmpty())
+    {
+        if (restore.IsEmpty())
+            restore = M_DynamicRect;
+        restore.x0 = std::min(restore.x0, M_DynamicRect.x0);
+        restore.y0 = std::min(restore.y0, M_DynamicRect.y0);
+        restore.x1 = std::max(restore.x1, M_DynamicRect.x1);
+        restore.y1 = std::max(restore.y1, M_DynamicRect.y1);
+    }
+    if (!restore.IsEmpty())
+    {
+        // Blits are scissored, so this must run before begin() sets the scissor
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, M_Framebuffers[STATIC_MAP]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, M_Framebuffers[COMPOSITE_MAP]);
+        glBlitFramebuffer(restore.x0, restore.y0, restore.x1, restore.y1,
+                          restore.x0, restore.y0, restore.x1, restore.y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        M_Stats.dynamicTexels += static_cast<uint64_t>(restore.x1 - restore.x0) * (restore.y1 - restore.y0);
+    }
+
+    begin(COMPOSITE_MAP, depthShader);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect.x0, rect.y0, std::max(rect.x1 - rect.x0, 0), std::max(rect.y1 - rect.y0, 0));
+
+    M_DynamicRect = rect;
+    M_CompositeStale = false;
+    M_HasComposite = true;
+    ++M_Stats.dynamicRenders;
+}
+
+void ShadowMap::EndDynamic()
+{
+    end();
+}
+
+void ShadowMap::DrawCaster(Shader& depthShader, Mesh& mesh, const glm::mat4& model)
+{
+    glm::mat4 transform = mesh.HasPositionTransform() ? model * mesh.GetPositionTransform() : model;
+    depthShader.setMat4(depthShader.GetModelLocation(), transform);
+    mesh.Draw(depthShader);
+}
+
+void ShadowMap::Apply(Shader& shader) const
+{
+    shader.use();
+    shader.setInt("shadowMap", static_cast<int>(TEXTURE_UNIT));
+}
+
+void ShadowMap::Bind() const
+{
+    GLStateCache::BindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, M_Textures[M_HasComposite ? COMPOSITE_MAP : STATIC_MAP]);
+}
+
+void ShadowMap::begin(int target, Shader& depthShader)
+{
+    glGetIntegerv(GL_VIEWPORT, M_SavedViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, M_Framebuffers[target]);
+    glViewport(0, 0, M_Resolution, M_Resolution);
+    GLStateCache::DepthMask(true);
+    GLStateCache::DepthFunc(GL_LESS);
+    // Slope-scaled bias against shadow acne, baked into the map
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    depthShader.use();
+    depthShader.setMat4("lightSpace", M_LightSpace);
+}
+
+void ShadowMap::end()
+{
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(M_SavedFramebuffer));
+    glViewport(M_SavedViewport[0], M_SavedViewport[1], M_SavedViewport[2], M_SavedViewport[3]);
+}
+
+ShadowMap::Rect ShadowMap::projectBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+{
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 point((corner & 1) ? boundsMax.x : boundsMin.x,
+                        (corner & 2) ? boundsMax.y : boundsMin.y,
+                        (corner & 4) ? boundsMax.z : boundsMin.z);
+        glm::vec4 clip = M_LightSpace * glm::vec4(point, 1.0f); // Orthographic: w stays 1
+        minX = std::min(minX, clip.x);
+        minY = std::min(minY, clip.y);
+        maxX = std::max(maxX, clip.x);
+        maxY = std::max(maxY, clip.y);
+    }
+
+    // To texels, padded by one for rasterization rounding
+    Rect rect;
+    rect.x0 = std::max(0, static_cast<int>(std::floor((minX * 0.5f + 0.5f) * M_Resolution)) - 1);
+    rect.y0 = std::max(0, static_cast<int>(std::floor((minY * 0.5f + 0.5f) * M_Resolution)) - 1);
+    rect.x1 = std::min(M_Resolution, static_cast<int>(std::ceil((maxX * 0.5f + 0.5f) * M_Resolution)) + 1);
+    rect.y1 = std::min(M_Resolution, static_cast<int>(std::ceil((maxY * 0.5f + 0.5f) * M_Resolution)) + 1);
+    return rect;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Mesh.h"
+#include "Shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+// Directional light shadow map with static caching.
+// The map covers a square region of regionSize world units around the camera rather than the
+// whole maze, so texel density doesn't drop as the maze grows. The region moves in steps of a
+// quarter of its size, and the maze and the light never change during play, so the static
+// casters are rendered into their own depth map only when the region moves, Setup changes the
+// light or bounds, or Invalidate is called. Outside the region everything counts as lit.
+// Dynamic casters go into a second, composite map: each frame only the rectangle they touched
+// last frame is restored from the static map (a depth blit) and the rectangle they touch now
+// is redrawn under a scissor. With nothing moving the per-frame cost is one small blit.
+//
+// Per frame:
+//   if (shadowMap.Focus(cameraPosition)) renderer.SetShadowSpace(shadowMap.GetShadowMatrix());
+//   if (shadowMap.BeginStatic(shader)) { DrawCaster (if Overlaps)...; EndStatic(); }
+//   shadowMap.BeginDynamic(shader, casterMin, casterMax); DrawCaster...; EndDynamic();
+// then shade with a SHADOWS variant (Apply once per program, Bind before the draws run).
+class ShadowMap {
+public:
+    static const GLenum TEXTURE_UNIT = 7; // After the baked light volumes
+
+    struct Stats {
+        uint64_t staticRenders = 0;
+        uint64_t dynamicRenders = 0;
+        uint64_t dynamicTexels = 0; // Texels restored and redrawn by dynamic passes
+    };
+
+    explicit ShadowMap(int resolution = 2048, float regionSize = 48.0f);
+    ~ShadowMap();
+
+    ShadowMap(const ShadowMap&) = delete;
+    ShadowMap& operator=(const ShadowMap&) = delete;
+
+    // World bounds of every caster and receiver, and the light. Only invalidates the cached
+    // map when something actually changed.
+    void Setup(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& lightDirection);
+
+    // Moves the region to cover the given position (clamped to the bounds) and fits the light's
+    // orthographic projection to it. Returns true if the light matrix changed, which also
+    // invalidates the cached map.
+    bool Focus(const glm::vec3& position);
+
+    // Whether a caster with these world bounds can land in the map (conservative)
+    bool Overlaps(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+    // Forces the static casters to be redrawn (e.g. after the maze is regenerated)
+    void Invalidate() { M_StaticDirty = true; }
+
+    // Returns false (and does nothing) while the cached static map is valid
+    bool BeginStatic(Shader& depthShader);
+    void EndStatic();
+
+    // Refreshes the composite map around the dynamic casters, whose world bounds are given
+    void BeginDynamic(Shader& depthShader, const glm::vec3& casterMin, const glm::vec3& casterMax);
+    void EndDynamic();
+
+    // Draws a caster into the map being rendered. Uses mesh-relative positions like the
+    // Renderer (quantized meshes carry a position transform).
+    void DrawCaster(Shader& depthShader, Mesh& mesh, const glm::mat4& model = glm::mat4(1.0f));
+
+    // Sets the sampler unit of a SHADOWS program. The light matrix changes with the region, so
+    // it is shared through the Lighting block instead (Renderer::SetShadowSpace).
+    void Apply(Shader& shader) const;
+
+    // Binds the map to sample (the composite once dynamic casters were drawn)
+    void Bind() const;
+
+    const glm::mat4& GetLightSpaceMatrix() const { return M_LightSpace; }
+    // World to shadow map coordinates and depth, all in [0, 1]
+    glm::mat4 GetShadowMatrix() const;
+    size_t GetGpuMemoryBytes() const { return static_cast<size_t>(M_Resolution) * M_Resolution * 4 * 2; }
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    struct Rect {
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0; // Texels, exclusive max
+        bool IsEmpty() const { return x1 <= x0 || y1 <= y0; }
+    };
+
+    int M_Resolution;
+    float M_RegionSize;
+    GLuint M_Textures[2];     // Static, composite
+    GLuint M_Framebuffers[2];
+    glm::mat4 M_LightSpace;   // World to clip space of the light
+    glm::vec3 M_BoundsMin;
+    glm::vec3 M_BoundsMax;
+    glm::vec3 M_LightDirection;
+    glm::vec2 M_RegionCenter; // x/z
+    bool M_StaticDirty;
+    bool M_CompositeStale;    // Composite needs a full copy of the static map
+    bool M_HasComposite;      // A dynamic pass has run, so the composite is the map to sample
+    Rect M_DynamicRect;       // Texels dynamic casters covered last frame
+    GLint M_SavedViewport[4];
+    GLint M_SavedFramebuffer;
+    Stats M_Stats;
+
+    void fit();
+    void begin(int target, Shader& depthShader);
+    void end();
+    Rect projectBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+};
@@ -0,0 +1,448 @@
+#include "SoftwareRaycaster.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYCASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const int COLUMNS_PER_TASK = 64;
+
+    uint32_t packColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+        return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16) |
+               (static_cast<uint32_t>(a) << 24);
+    }
+
+    // Scalar version of the SIMD lighting: channel * multiplier >> 8, saturated
+    uint32_t shadeColor(uint32_t color, uint64_t shade) {
+        uint32_t result = 0;
+        for (int channel = 0; channel < 4; ++channel)
+        {
+            uint32_t value = (color >> (channel * 8)) & 0xFFu;
+            uint32_t multiplier = static_cast<uint32_t>(shade >> (channel * 16)) & 0xFFFFu;
+            result |= std::min((value * multiplier) >> 8, 255u) << (channel * 8);
+        }
+        return result;
+    }
+
+    uint64_t packShade(const glm::vec3& factor) {
+        auto toFixed = [](float value) {
+            return static_cast<uint64_t>(std::min(std::max(std::lround(value * 256.0f), 0L), 65535L));
+        };
+        return toFixed(factor.x) | (toFixed(factor.y) << 16) | (toFixed(factor.z) << 32) | (toFixed(1.0f) << 48);
+    }
+
+    void makeCheckerboard(std::vector<uint32_t>& texels, int size) {
+        texels.resize(static_cast<size_t>(size) * size);
+        const int square = std::max(1, size / 8);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                unsigned char grey = ((x / square + y / square) & 1) ? 160 : 96;
+                texels[static_cast<size_t>(y) * size + x] = packColor(grey, grey, grey, 255);
+            }
+        }
+    }
+}
+
+SoftwareRaycaster::SoftwareRaycaster(const Settings& settings)
+    : M_Settings(settings), M_Background(packColor(26, 26, 26, 255)), M_MazeWidth(0), M_MazeHeight(0),
+      M_Width(0), M_Height(0), M_View(), M_Task(nullptr), M_TaskCount(0), M_NextItem(0), M_Busy(0),
+      M_Generation(0), M_Stopping(false)
+{
+    // Power of two, so texture coordinates wrap with a mask
+    int size = 1;
+    while (size * 2 <= std::max(1, M_Settings.textureSize))
+        size *= 2;
+    M_Settings.textureSize = size;
+    M_Settings.rowsPerTile = std::max(1, M_Settings.rowsPerTile);
+
+    SurfaceTexture* textures[3] = { &M_WallTexture, &M_FloorTexture, &M_CeilingTexture };
+    for (SurfaceTexture* texture : textures)
+    {
+        texture->size = size;
+        texture->mask = size - 1;
+        while ((1 << texture->shift) < size)
+            ++texture->shift;
+        makeCheckerboard(texture->texels, size);
+    }
+    SetLighting(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f), 0.3f);
+
+    unsigned int threadCount = M_Settings.threadCount != 0 ? M_Settings.threadCount : std::thread::hardware_concurrency();
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned int i = 1; i < threadCount; ++i)
+        M_Workers.emplace_back(&SoftwareRaycaster::workerLoop, this);
+}
+
+SoftwareRaycaster::~SoftwareRaycaster()
+{
+    {
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        M_Stopping = true;
+    }
+    M_WorkAvailable.notify_all();
+    for (std::thread& worker : M_Workers)
+        worker.join();
+}
+
+bool SoftwareRaycaster::LoadTextures(const std::string& wallPath, const std::string& floorPath, const std::string& ceilingPath)
+{
+    bool loaded = loadTexture(wallPath, M_WallTexture);
+    loaded = loadTexture(floorPath, M_FloorTexture) && loaded;
+    loaded = loadTexture(ceilingPath, M_CeilingTexture) && loaded;
+    return loaded;
+}
+
+bool SoftwareRaycaster::loadTexture(const std::string& path, SurfaceTexture& texture)
+{
+    // Flipped like TextureLoader's 2D textures, so v = 0 is the bottom row as in GL
+    DecodedImage image;
+    if (!DecodeImage(path, true, image, 4))
+    {
+        std::cerr << "SoftwareRaycaster: using a checkerboard for " << path << std::endl;
+        makeCheckerboard(texture.texels, texture.size);
+        return false;
+    }
+    if (image.width != texture.size || image.height != texture.size)
+        image = ResizeImage(image, texture.size, texture.size);
+
+    texture.texels.resize(static_cast<size_t>(texture.size) * texture.size);
+    for (size_t i = 0; i < texture.texels.size(); ++i)
+    {
+        const unsigned char* pixel = &image.pixels[i * 4];
+        texture.texels[i] = packColor(pixel[0], pixel[1], pixel[2], pixel[3]);
+    }
+    return true;
+}
+
+void SoftwareRaycaster::SetLighting(const glm::vec3& direction, const glm::vec3& color, float ambientIntensity)
+{
+    // maze.frag without specular: (ambient + N.L) * light color, with the ceiling lit through +Y
+    const glm::vec3 normals[UNLIT] = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+        glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)
+    };
+    const glm::vec3 toLight = -glm::normalize(direction);
+    for (int surface = 0; surface < UNLIT; ++surface)
+    {
+        float diffuse = std::max(glm::dot(normals[surface], toLight), 0.0f);
+        M_Shades[surface] = packShade((ambientIntensity + diffuse) * color);
+    }
+    M_Shades[UNLIT] = packShade(glm::vec3(1.0f));
+}
+
+void SoftwareRaycaster::SetMaze(const Maze& maze)
+{
+    M_Walls = maze.BuildWallMask();
+    M_MazeWidth = maze.GetWidth();
+    M_MazeHeight = maze.GetHeight();
+}
+
+void SoftwareRaycaster::Resize(int width, int height)
+{
+    width = std::max(1, width);
+    height = std::max(1, height);
+    if (width == M_Width && height == M_Height)
+        return;
+    M_Width = width;
+    M_Height = height;
+    M_Pixels.assign(static_cast<size_t>(width) * height, M_Background);
+    M_WallTop.assign(width, 0.0f);
+    M_WallBottom.assign(width, 0.0f);
+    M_WallInvSpan.assign(width, 0.0f);
+    M_WallTexU.assign(width, 0);
+    M_WallSurface.assign(width, WALL_POS_X);
+}
+
+void SoftwareRaycaster::Render(const Camera& camera)
+{
+    if (M_Pixels.empty())
+        Resize(640, 360);
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Yaw only, like the camera's own front vector projected onto the floor
+    const float yaw = glm::radians(camera.Yaw);
+    const float tanHalfFovY = std::tan(glm::radians(camera.Zoom) * 0.5f);
+    M_View.position = glm::vec2(camera.Position.x, camera.Position.z);
+    M_View.eyeHeight = camera.Position.y;
+    M_View.forward = glm::vec2(std::cos(yaw), std::sin(yaw));
+    M_View.right = glm::vec2(-M_View.forward.y, M_View.forward.x);
+    M_View.tanHalfFovX = tanHalfFovY * M_Width / M_Height;
+    M_View.focal = M_Height * 0.5f / tanHalfFovY;
+    M_View.horizon = M_Height * 0.5f + std::tan(glm::radians(camera.Pitch)) * M_View.focal;
+
+    const std::function<void(int)> columns = [this](int task) {
+        const int end = std::min((task + 1) * COLUMNS_PER_TASK, M_Width);
+        for (int x = task * COLUMNS_PER_TASK; x < end; ++x)
+            castColumn(x);
+    };
+    parallelFor((M_Width + COLUMNS_PER_TASK - 1) / COLUMNS_PER_TASK, columns);
+
+    const int rowsPerTile = M_Settings.rowsPerTile;
+    const std::function<void(int)> rows = [this, rowsPerTile](int tile) {
+        const int end = std::min((tile + 1) * rowsPerTile, M_Height);
+        for (int y = tile * rowsPerTile; y < end; ++y)
+            shadeRow(y);
+    };
+    parallelFor((M_Height + rowsPerTile - 1) / rowsPerTile, rows);
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    ++M_Stats.frames;
+    M_Stats.totalMs += elapsedMs;
+    M_Stats.lastMs = elapsedMs;
+}
+
+void SoftwareRaycaster::castColumn(int x)
+{
+    const View& view = M_View;
+    // No wall: an empty span at the horizon
+    M_WallTop[x] = M_WallBottom[x] = view.horizon;
+    M_WallInvSpan[x] = 0.0f;
+    M_WallTexU[x] = 0;
+    M_WallSurface[x] = WALL_POS_X;
+
+    int cx = static_cast<int>(std::floor(view.position.x));
+    int cz = static_cast<int>(std::floor(view.position.y));
+    if (cx < 0 || cz < 0 || cx >= M_MazeWidth || cz >= M_MazeHeight)
+        return;
+
+    // Forward has unit length, so t along this ray is the perpendicular depth
+    const float ndcX = 2.0f * (x + 0.5f) / M_Width - 1.0f;
+    const glm::vec2 dir = view.forward + view.right * (view.tanHalfFovX * ndcX);
+    const int stepX = dir.x > 0.0f ? 1 : -1;
+    const int stepZ = dir.y > 0.0f ? 1 : -1;
+    const float tDeltaX = dir.x != 0.0f ? std::fabs(1.0f / dir.x) : 1e30f;
+    const float tDeltaZ = dir.y != 0.0f ? std::fabs(1.0f / dir.y) : 1e30f;
+    float tMaxX = dir.x != 0.0f ? ((dir.x > 0.0f ? cx + 1 : cx) - view.position.x) / dir.x : 1e30f;
+    float tMaxZ = dir.y != 0.0f ? ((dir.y > 0.0f ? cz + 1 : cz) - view.position.y) / dir.y : 1e30f;
+    const float halfThickness = M_Settings.wallThickness * 0.5f;
+
+    // Walls on the grid lines, seen from inside the current cell. The face is half the wall
+    // thickness in front of the line.
+    float t = -1.0f, along = 0.0f;
+    int surface = WALL_POS_X;
+    for (int steps = M_MazeWidth + M_MazeHeight; steps >= 0; --steps)
+    {
+        const unsigned char bits = M_Walls[static_cast<size_t>(cz) * M_MazeWidth + cx];
+        if (tMaxX < tMaxZ)
+        {
+            if (bits & (stepX > 0 ? WALL_RIGHT : WALL_LEFT))
+            {
+                float face = (stepX > 0 ? cx + 1 : cx) - stepX * halfThickness;
+                t = (face - view.position.x) / dir.x;
+                along = view.position.y + t * dir.y;
+                surface = stepX > 0 ? WALL_NEG_X : WALL_POS_X;
+                break;
+            }
+            cx += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            if (bits & (stepZ > 0 ? WALL_BOTTOM : WALL_TOP))
+            {
+                float face = (stepZ > 0 ? cz + 1 : cz) - stepZ * halfThickness;
+                t = (face - view.position.y) / dir.y;
+                along = view.position.x + t * dir.x;
+                surface = stepZ > 0 ? WALL_NEG_Z : WALL_POS_Z;
+                break;
+            }
+            cz += stepZ;
+            tMaxZ += tDeltaZ;
+        }
+        if (cx < 0 || cz < 0 || cx >= M_MazeWidth || cz >= M_MazeHeight)
+            return; // Left through a gap in the outer wall
+    }
+    if (t < 0.0f)
+        return;
+
+    t = std::max(t, 0.01f); // Standing inside the wall's thickness
+    const float top = view.horizon - (M_Settings.wallHeight - view.eyeHeight) * view.focal / t;
+    const float bottom = view.horizon + view.eyeHeight * view.focal / t;
+    const int size = M_WallTexture.size;
+    M_WallTop[x] = top;
+    M_WallBottom[x] = bottom;
+    M_WallInvSpan[x] = 1.0f / std::max(bottom - top, 1e-6f);
+    M_WallTexU[x] = std::min(static_cast<int>((along - std::floor(along)) * size), size - 1);
+    M_WallSurface[x] = surface;
+}
+
+void SoftwareRaycaster::shadeRow(int y)
+{
+    const View& view = M_View;
+    uint32_t* out = &M_Pixels[static_cast<size_t>(y) * M_Width];
+    const float py = y + 0.5f;
+
+    // Floor below the horizon, ceiling above; the plane's world x/z is linear along the row
+    const bool isFloor = py > view.horizon;
+    const SurfaceTexture& plane = isFloor ? M_FloorTexture : M_CeilingTexture;
+    const int planeSurface = isFloor ? FLOOR : CEILING;
+    const float planeHeight = isFloor ? view.eyeHeight : M_Settings.wallHeight - view.eyeHeight;
+    const float distance = planeHeight * view.focal / std::max(std::fabs(py - view.horizon), 1e-3f);
+    const glm::vec2 step = view.right * (distance * view.tanHalfFovX * 2.0f / M_Width);
+    const glm::vec2 base = view.position + distance * (view.forward + view.right * (view.tanHalfFovX * (1.0f / M_Width - 1.0f)));
+    const SurfaceTexture& wall = M_WallTexture;
+    const float mazeWidth = static_cast<float>(M_MazeWidth);
+    const float mazeHeight = static_cast<float>(M_MazeHeight);
+
+    int x = 0;
+#ifdef RAYCASTER_SSE2
+    const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 pyv = _mm_set1_ps(py);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 planeScale = _mm_set1_ps(static_cast<float>(plane.size));
+    const __m128 wallScale = _mm_set1_ps(static_cast<float>(wall.size));
+    const __m128 wallMaxRow = _mm_set1_ps(static_cast<float>(wall.size - 1));
+    const __m128i planeMask = _mm_set1_epi32(plane.mask);
+    const __m128i planeShift = _mm_cvtsi32_si128(plane.shift);
+    const __m128i wallShift = _mm_cvtsi32_si128(wall.shift);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    for (; x + 4 <= M_Width; x += 4)
+    {
+        const __m128 xs = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+        const __m128 wx = _mm_add_ps(_mm_set1_ps(base.x), _mm_mul_ps(_mm_set1_ps(step.x), xs));
+        const __m128 wz = _mm_add_ps(_mm_set1_ps(base.y), _mm_mul_ps(_mm_set1_ps(step.y), xs));
+
+        const __m128 top = _mm_loadu_ps(&M_WallTop[x]);
+        const __m128 bottom = _mm_loadu_ps(&M_WallBottom[x]);
+        const int inWall = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(pyv, top), _mm_cmplt_ps(pyv, bottom)));
+        const __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(wx, zero), _mm_cmplt_ps(wz, zero)),
+                                         _mm_or_ps(_mm_cmpge_ps(wx, _mm_set1_ps(mazeWidth)), _mm_cmpge_ps(wz, _mm_set1_ps(mazeHeight))));
+        const int isOutside = _mm_movemask_ps(outside);
+
+        // Texel indices for both candidates; the masks pick one per pixel
+        const __m128 v = _mm_mul_ps(_mm_sub_ps(bottom, pyv), _mm_loadu_ps(&M_WallInvSpan[x]));
+        const __m128i wallRow = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(v, wallScale), wallMaxRow), zero));
+        const __m128i wallIndex = _mm_add_epi32(_mm_sll_epi32(wallRow, wallShift),
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&M_WallTexU[x])));
+        const __m128i tx = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(wx, planeScale)), planeMask);
+        const __m128i tz = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(wz, planeScale)), planeMask);
+        const __m128i planeIndex = _mm_add_epi32(_mm_sll_epi32(tz, planeShift), tx);
+
+        alignas(16) int32_t wallIndices[4], planeIndices[4];
+        alignas(16) uint32_t colors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(wallIndices), wallIndex);
+        _mm_store_si128(reinterpret_cast<__m128i*>(planeIndices), planeIndex);
+        uint64_t shades[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (inWall & (1 << lane))
+            {
+                colors[lane] = wall.texels[wallIndices[lane]];
+                shades[lane] = M_Shades[M_WallSurface[x + lane]];
+            }
+            else if (isOutside & (1 << lane))
+            {
+                colors[lane] = M_Background;
+                shades[lane] = M_Shades[UNLIT];
+            }
+            else
+            {
+                colors[lane] = plane.texels[planeIndices[lane]];
+                shades[lane] = M_Shades[planeSurface];
+            }
+        }
+
+        // Channels to the high byte of 16-bit lanes, so mulhi gives channel * multiplier >> 8
+        const __m128i pixels = _mm_load_si128(reinterpret_cast<const __m128i*>(colors));
+        const __m128i zeroInt = _mm_setzero_si128();
+        __m128i low = _mm_unpacklo_epi8(zeroInt, pixels);
+        __m128i high = _mm_unpackhi_epi8(zeroInt, pixels);
+        low = _mm_mulhi_epu16(low, _mm_set_epi64x(static_cast<long long>(shades[1]), static_cast<long long>(shades[0])));
+        high = _mm_mulhi_epu16(high, _mm_set_epi64x(static_cast<long long>(shades[3]), static_cast<long long>(shades[2])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_or_si128(_mm_packus_epi16(low, high), alpha));
+    }
+#endif
+
+    // Scalar path: the remainder of the row, or all of it without SSE2
+    for (; x < M_Width; ++x)
+    {
+        const float wx = base.x + step.x * x;
+        const float wz = base.y + step.y * x;
+        uint32_t color;
+        uint64_t shade;
+        if (py >= M_WallTop[x] && py < M_WallBottom[x])
+        {
+            float v = (M_WallBottom[x] - py) * M_WallInvSpan[x];
+            int row = std::min(std::max(static_cast<int>(v * wall.size), 0), wall.size - 1);
+            color = wall.texels[(row << wall.shift) + M_WallTexU[x]];
+            shade = M_Shades[M_WallSurface[x]];
+        }
+        else if (wx < 0.0f || wz < 0.0f || wx >= mazeWidth || wz >= mazeHeight)
+        {
+            color = M_Background;
+            shade = M_Shades[UNLIT];
+        }
+        else
+        {
+            int tx = static_cast<int>(wx * plane.size) & plane.mask;
+            int tz = static_cast<int>(wz * plane.size) & plane.mask;
+            color = plane.texels[(tz << plane.shift) + tx];
+            shade = M_Shades[planeSurface];
+        }
+        out[x] = shadeColor(color, shade) | 0xFF000000u;
+    }
+}
+
+void SoftwareRaycaster::parallelFor(int count, const std::function<void(int)>& task)
+{
+    if (M_Workers.empty())
+    {
+        for (int i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        M_Task = &task;
+        M_TaskCount = count;
+        M_NextItem = 0;
+        M_Busy = static_cast<int>(M_Workers.size());
+        ++M_Generation;
+    }
+    M_WorkAvailable.notify_all();
+    runItems(task, count);
+
+    // Every worker checks in once per task, so none can still be on this one when the next starts
+    std::unique_lock<std::mutex> lock(M_Mutex);
+    M_WorkDone.wait(lock, [this]() { return M_Busy == 0; });
+}
+
+void SoftwareRaycaster::runItems(const std::function<void(int)>& task, int count)
+{
+    for (int i = M_NextItem++; i < count; i = M_NextItem++)
+        task(i);
+}
+
+void SoftwareRaycaster::workerLoop()
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        const std::function<void(int)>* task;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(M_Mutex);
+            M_WorkAvailable.wait(lock, [&]() { return M_Stopping || M_Generation != seenGeneration; });
+            if (M_Stopping)
+                return;
+            seenGeneration = M_Generation;
+            task = M_Task;
+            count = M_TaskCount;
+        }
+
+        runItems(*task, count);
+
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        if (--M_Busy == 0)
+            M_WorkDone.notify_one();
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "camera.h"
+#include "../Game/Maze.h"
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU renderer for machines without a GPU (tests, thumbnails, bots). Draws the maze from a
+// Camera pose Wolfenstein style, into an RGBA8 buffer, without touching OpenGL:
+//   1. One DDA ray per pixel column finds the nearest wall on the cell grid; the wall's
+//      screen span and texture column are stored per column (structure of arrays).
+//   2. Rows are shaded in tiles: pixels inside their column's wall span sample the wall
+//      texture, the others are floor or ceiling, whose world position is linear along a row.
+//      Four pixels are handled at a time with SSE2 (coordinates, span tests and lighting;
+//      the texel fetches themselves are scalar).
+// Both passes run on a persistent pool of worker threads, with the calling thread taking a
+// share, so a frame costs two wake-ups rather than thread creation.
+//
+// It samples the same wall/floor/ceiling images and applies the same directional light as
+// maze.frag (ambient + N.L, no specular, point lights or shadows). Walls are planes offset by
+// half their thickness, so wall ends aren't drawn. Pitch is approximated by moving the horizon
+// (y-shearing), which is close for the small angles the player uses.
+class SoftwareRaycaster {
+public:
+    struct Settings {
+        float wallHeight = 2.0f;
+        float wallThickness = 0.1f;
+        int textureSize = 256;        // Textures are resampled to this (rounded to a power of two)
+        int rowsPerTile = 8;          // Rows a worker shades per task
+        unsigned int threadCount = 0; // 0 = use all hardware threads
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        double totalMs = 0.0;
+        double lastMs = 0.0;
+    };
+
+    explicit SoftwareRaycaster(const Settings& settings);
+    ~SoftwareRaycaster();
+
+    SoftwareRaycaster(const SoftwareRaycaster&) = delete;
+    SoftwareRaycaster& operator=(const SoftwareRaycaster&) = delete;
+
+    // Decodes the surface images. A texture that fails to load is replaced by a checkerboard
+    // (and false is returned), so rendering still works.
+    bool LoadTextures(const std::string& wallPath, const std::string& floorPath, const std::string& ceilingPath);
+
+    // Same parameters as Renderer::SetLighting
+    void SetLighting(const glm::vec3& direction, const glm::vec3& color, float ambientIntensity);
+
+    // Copies the wall layout; call again if the maze is regenerated
+    void SetMaze(const Maze& maze);
+
+    // Output size in pixels; reallocates only when it changes
+    void Resize(int width, int height);
+
+    void Render(const Camera& camera);
+
+    // RGBA8, top row first, width * height * 4 bytes
+    const unsigned char* GetPixels() const { return reinterpret_cast<const unsigned char*>(M_Pixels.data()); }
+    int GetWidth() const { return M_Width; }
+    int GetHeight() const { return M_Height; }
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(M_Workers.size()) + 1; }
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    // Surfaces (walls by the direction they face), indexing M_Shades
+    enum Surface { WALL_POS_X, WALL_NEG_X, WALL_POS_Z, WALL_NEG_Z, FLOOR, CEILING, UNLIT, SURFACE_COUNT };
+
+    struct SurfaceTexture {
+        std::vector<uint32_t> texels; // RGBA8, bottom row first like the GL upload
+        int size = 0;
+        int mask = 0;
+        int shift = 0;                // log2(size)
+    };
+
+    // Per-frame view parameters shared by both passes
+    struct View {
+        glm::vec2 position;  // x/z
+        float eyeHeight;
+        glm::vec2 forward;   // Unit, x/z
+        glm::vec2 right;
+        float tanHalfFovX;
+        float focal;         // Pixels per unit at distance 1
+        float horizon;       // Screen row of the horizon
+    };
+
+    Settings M_Settings;
+    SurfaceTexture M_WallTexture;
+    SurfaceTexture M_FloorTexture;
+    SurfaceTexture M_CeilingTexture;
+    uint64_t M_Shades[SURFACE_COUNT];    // RGBA light multipliers, 16 bits each (8.8 fixed point), R lowest
+    uint32_t M_Background;               // Outside the maze
+
+    std::vector<unsigned char> M_Walls;  // Maze::BuildWallMask
+    int M_MazeWidth;
+    int M_MazeHeight;
+
+    int M_Width;
+    int M_Height;
+    std::vector<uint32_t> M_Pixels;
+    // Column pass output, one entry per pixel column
+    std::vector<float> M_WallTop;     // Screen rows covered: [top, bottom)
+    std::vector<float> M_WallBottom;
+    std::vector<float> M_WallInvSpan; // 1 / (bottom - top)
+    std::vector<int32_t> M_WallTexU;  // Texel column
+    std::vector<int32_t> M_WallSurface;
+    View M_View;
+    Stats M_Stats;
+
+    // Worker pool; parallelFor hands out item indices from M_NextItem
+    std::vector<std::thread> M_Workers;
+    std::mutex M_Mutex;
+    std::condition_variable M_WorkAvailable;
+    std::condition_variable M_WorkDone;
+    const std::function<void(int)>* M_Task; // Guarded by M_Mutex
+    int M_TaskCount;                        // Guarded by M_Mutex
+    std::atomic<int> M_NextItem;
+    int M_Busy;                             // Workers still running the task; guarded by M_Mutex
+    uint64_t M_Generation;                  // Guarded by M_Mutex
+    bool M_Stopping;                        // Guarded by M_Mutex
+
+    void workerLoop();
+    void runItems(const std::function<void(int)>& task, int count);
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+    bool loadTexture(const std::string& path, SurfaceTexture& texture);
+    void castColumn(int x);
+    void shadeRow(int y);
+};
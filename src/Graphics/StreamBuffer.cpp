@@ -0,0 +1,140 @@
+#include "StreamBuffer.h"
+#include "GLUtils.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+StreamBuffer::StreamBuffer(GLenum target, size_t bytesPerFrame)
+    : M_Target(target), M_Buffer(0), M_RegionSize(bytesPerFrame), M_Persistent(false),
+      M_PersistentData(nullptr), M_FrameData(nullptr), M_Region(0), M_Used(0)
+{
+    for (GLsync& fence : M_Fences)
+        fence = nullptr;
+
+    const size_t totalSize = bytesPerFrame * FRAME_COUNT;
+    glGenBuffers(1, &M_Buffer);
+    glBindBuffer(M_Target, M_Buffer);
+
+    const GLOptionalFunctions& gl = GetGLOptionalFunctions();
+    if (gl.bufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        gl.BufferStorage(M_Target, static_cast<GLsizeiptr>(totalSize), nullptr, flags);
+        M_PersistentData = static_cast<unsigned char*>(glMapBufferRange(M_Target, 0, static_cast<GLsizeiptr>(totalSize), flags));
+        M_Persistent = M_PersistentData != nullptr;
+        if (!M_Persistent)
+        {
+            // Immutable storage can't be respecified; start over with a mutable buffer
+            std::cerr << "StreamBuffer: persistent mapping failed, falling back to per-frame mapping" << std::endl;
+            glBindBuffer(M_Target, 0);
+            glDeleteBuffers(1, &M_Buffer);
+            glGenBuffers(1, &M_Buffer);
+            glBindBuffer(M_Target, M_Buffer);
+        }
+    }
+    if (!M_Persistent)
+        glBufferData(M_Target, static_cast<GLsizeiptr>(totalSize), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(M_Target, 0);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync& fence : M_Fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (M_Persistent || M_FrameData)
+    {
+        glBindBuffer(M_Target, M_Buffer);
+        glUnmapBuffer(M_Target);
+        glBindBuffer(M_Target, 0);
+    }
+    glDeleteBuffers(1, &M_Buffer);
+}
+
+void StreamBuffer::BeginFrame()
+{
+    M_Region = (M_Region + 1) % FRAME_COUNT;
+    M_Used = 0;
+    ++M_Stats.frames;
+
+    // The region was last written FRAME_COUNT frames ago; wait until the GPU has read it
+    GLsync& fence = M_Fences[M_Region];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            ++M_Stats.fenceWaits;
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms steps
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const size_t regionStart = static_cast<size_t>(M_Region) * M_RegionSize;
+    if (M_Persistent)
+    {
+        M_FrameData = M_PersistentData + regionStart;
+    }
+    else
+    {
+        // Unsynchronized: the fence above already guarantees the GPU is done with this range
+        glBindBuffer(M_Target, M_Buffer);
+        M_FrameData = static_cast<unsigned char*>(glMapBufferRange(
+            M_Target, static_cast<GLintptr>(regionStart), static_cast<GLsizeiptr>(M_RegionSize),
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        glBindBuffer(M_Target, 0);
+    }
+}
+
+void* StreamBuffer::Allocate(size_t size, size_t alignment, size_t& bufferOffset)
+{
+    if (!M_FrameData)
+        return nullptr;
+
+    alignment = std::max<size_t>(alignment, 1);
+    const size_t regionStart = static_cast<size_t>(M_Region) * M_RegionSize;
+    // Align the absolute offset, since that is what e.g. glBindBufferRange checks
+    size_t offset = (regionStart + M_Used + alignment - 1) / alignment * alignment - regionStart;
+    if (offset + size > M_RegionSize)
+    {
+        std::cerr << "StreamBuffer: frame region full (" << offset + size << " > " << M_RegionSize << " bytes)" << std::endl;
+        return nullptr;
+    }
+
+    M_Used = offset + size;
+    M_Stats.peakFrameBytes = std::max(M_Stats.peakFrameBytes, M_Used);
+    bufferOffset = regionStart + offset;
+    return M_FrameData + offset;
+}
+
+void StreamBuffer::Commit()
+{
+    if (M_Persistent || !M_FrameData)
+        return; // Coherent mapping: writes are visible to commands issued from now on
+
+    glBindBuffer(M_Target, M_Buffer);
+    glUnmapBuffer(M_Target);
+    glBindBuffer(M_Target, 0);
+    M_FrameData = nullptr;
+}
+
+void StreamBuffer::EndFrame()
+{
+    Commit();
+    if (M_Fences[M_Region])
+        glDeleteSync(M_Fences[M_Region]); // EndFrame twice in one frame
+    M_Fences[M_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
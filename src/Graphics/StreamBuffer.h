@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+// Ring buffer for data written once per frame (per-frame uniform blocks, dynamic instance
+// transforms, debug lines...).
+// The buffer is split into FRAME_COUNT regions. Each frame writes into its own region while
+// the GPU may still be reading the previous ones; a fence per region makes sure a region is
+// only reused once the GPU is done with it, which with three regions almost never waits.
+// With ARB_buffer_storage the buffer is mapped once, persistently and coherently, so writes
+// land directly in GPU-visible memory. Otherwise each frame's region is mapped with
+// GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT (the fences provide the sync)
+// and unmapped by Commit().
+//
+// Per frame: BeginFrame, any number of Allocate, Commit before the draws that read the data,
+// EndFrame after them.
+class StreamBuffer {
+public:
+    static const int FRAME_COUNT = 3;
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t fenceWaits = 0;  // Frames that had to wait for the GPU to release a region
+        size_t peakFrameBytes = 0;
+    };
+
+    StreamBuffer(GLenum target, size_t bytesPerFrame);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    void BeginFrame();
+
+    // Space for `size` bytes in this frame's region. Returns a write-only pointer and the
+    // offset of the data in GetBuffer(), or nullptr if the region is full.
+    void* Allocate(size_t size, size_t alignment, size_t& bufferOffset);
+
+    // Makes this frame's writes visible to the GPU (unmaps when not persistent)
+    void Commit();
+
+    // Fences the region; call after the last draw that reads this frame's data
+    void EndFrame();
+
+    GLuint GetBuffer() const { return M_Buffer; }
+    bool IsPersistent() const { return M_Persistent; }
+    const Stats& GetStats() const { return M_Stats; }
+
+private:
+    GLenum M_Target;
+    GLuint M_Buffer;
+    size_t M_RegionSize;
+    bool M_Persistent;
+    unsigned char* M_PersistentData; // Whole buffer, persistent mode only
+    unsigned char* M_FrameData;      // Current region while mapped
+    GLsync M_Fences[FRAME_COUNT];
+    int M_Region;
+    size_t M_Used;                   // Bytes allocated in the current region
+    Stats M_Stats;
+};
@@ -1,15 +1,16 @@
 #include "Texture.h"
+#include "GLStateCache.h"
 #include <iostream>
 
 // Include stb_image.h for image loading (without implementation)
 #include "../../external/stb_image.h"
 
 Texture::Texture(const std::string& path, bool generateMipmaps)
-    : ID(0), width(0), height(0), channels(0)
+    : ID(0), Target(GL_TEXTURE_2D), width(0), height(0), channels(0), M_Ready(false)
 {
     // Generate texture
     glGenTextures(1, &ID);
-    glBindTexture(GL_TEXTURE_2D, ID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D, ID);
 
     // Set default texture wrapping/filtering options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -43,6 +44,7 @@ Texture::Texture(const std::string& path, bool generateMipmaps)
         if (generateMipmaps)
             glGenerateMipmap(GL_TEXTURE_2D);
 
+        M_Ready = true;
         std::cout << "Texture loaded: " << path << " (" << width << "x" << height << ", " << channels << " channels)" << std::endl;
     }
     else
@@ -53,38 +55,62 @@ Texture::Texture(const std::string& path, bool generateMipmaps)
     // Free image data
     stbi_image_free(data);
 
-    // Unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // The texture stays bound; GLStateCache tracks it, so no unbind is needed
+}
+
+Texture::Texture(GLenum target)
+    : ID(0), Target(target), width(1), height(1), channels(3), M_Ready(false)
+{
+    const unsigned char grey[3] = { 128, 128, 128 };
+
+    glGenTextures(1, &ID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), Target, ID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (Target == GL_TEXTURE_CUBE_MAP)
+    {
+        for (unsigned int face = 0; face < 6; ++face)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(Target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(Target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(Target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    else
+    {
+        glTexImage2D(Target, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(Target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(Target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(Target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(Target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
 Texture::~Texture()
 {
+    GLStateCache::OnTextureDeleted(ID);
     glDeleteTextures(1, &ID);
 }
 
 void Texture::Bind(unsigned int textureUnit) const
 {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, ID);
+    GLStateCache::BindTexture(textureUnit, Target, ID); // Skipped if already bound there
 }
 
 void Texture::Unbind() const
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), Target, 0);
 }
 
 void Texture::SetTextureWrapMode(unsigned int textureID, GLenum wrapS, GLenum wrapT)
 {
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D, textureID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::SetTextureFilterMode(unsigned int textureID, GLenum minFilter, GLenum magFilter)
 {
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D, textureID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
@@ -8,14 +8,24 @@ public:
     // Texture ID
     unsigned int ID;
 
+    // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+    GLenum Target;
+
     // Texture dimensions
     int width;
     int height;
     int channels;
 
-    // Constructor (generates texture from image file)
+    // Constructor (generates texture from image file, decoding on the calling thread)
     Texture(const std::string& path, bool generateMipmaps = true);
 
+    // Constructor for a placeholder (1x1 grey) whose real contents arrive later,
+    // see TextureLoader. The ID stays the same when the image is uploaded.
+    explicit Texture(GLenum target);
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
     // Destructor
     ~Texture();
 
@@ -25,7 +35,14 @@ public:
     // Unbind texture
     void Unbind() const;
 
+    // False while a placeholder is still waiting for its image
+    bool IsReady() const { return M_Ready; }
+
     // Static utility functions
     static void SetTextureWrapMode(unsigned int textureID, GLenum wrapS, GLenum wrapT);
     static void SetTextureFilterMode(unsigned int textureID, GLenum minFilter, GLenum magFilter);
+
+private:
+    friend class TextureLoader;
+    bool M_Ready;
 };
\ No newline at end of file
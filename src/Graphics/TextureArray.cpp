@@ -0,0 +1,53 @@
+#include "TextureArray.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <vector>
+
+TextureArray::TextureArray(int width, int height, int layerCount, bool generateMipmaps)
+    : ID(0), M_Width(width), M_Height(height), M_LayerCount(layerCount), M_MipCount(1)
+{
+    if (generateMipmaps)
+    {
+        int size = std::max(width, height);
+        while (size > 1) { size /= 2; ++M_MipCount; }
+    }
+
+    glGenTextures(1, &ID);
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D_ARRAY, ID);
+
+    // Allocate every level, filled with grey until the real layers arrive
+    std::vector<unsigned char> grey(static_cast<size_t>(width) * height * layerCount * 4, 128);
+    for (int mip = 0; mip < M_MipCount; ++mip)
+    {
+        int levelWidth = std::max(1, width >> mip);
+        int levelHeight = std::max(1, height >> mip);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, mip, GL_RGBA8, levelWidth, levelHeight, layerCount, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, grey.data());
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, M_MipCount - 1);
+}
+
+TextureArray::~TextureArray()
+{
+    GLStateCache::OnTextureDeleted(ID);
+    glDeleteTextures(1, &ID);
+}
+
+void TextureArray::Bind(unsigned int textureUnit) const
+{
+    GLStateCache::BindTexture(textureUnit, GL_TEXTURE_2D_ARRAY, ID);
+}
+
+size_t TextureArray::GetMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (int mip = 0; mip < M_MipCount; ++mip)
+        bytes += static_cast<size_t>(std::max(1, M_Width >> mip)) * std::max(1, M_Height >> mip) * 4;
+    return bytes * M_LayerCount;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// A GL_TEXTURE_2D_ARRAY with a fixed layer size, used to keep every maze surface material in
+// one texture so differently textured geometry can share a draw. Layers start out grey;
+// TextureLoader::LoadLayer fills them in (resampling images to the layer size).
+class TextureArray {
+public:
+    // Texture ID
+    unsigned int ID;
+
+    TextureArray(int width, int height, int layerCount, bool generateMipmaps = true);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // Bind texture array to a texture unit
+    void Bind(unsigned int textureUnit = 0) const;
+
+    int GetWidth() const { return M_Width; }
+    int GetHeight() const { return M_Height; }
+    int GetLayerCount() const { return M_LayerCount; }
+    int GetMipCount() const { return M_MipCount; }
+
+    // Bytes of texel storage, all layers and levels
+    size_t GetMemoryUsage() const;
+
+private:
+    int M_Width;
+    int M_Height;
+    int M_LayerCount;
+    int M_MipCount;
+};
@@ -0,0 +1,522 @@
+#include "TextureCache.h"
+#include "../Utils/Utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "../../external/stb_image.h"
+
+namespace {
+    const char MTEX_MAGIC[4] = { 'M', 'T', 'E', 'X' };
+    const uint32_t MTEX_VERSION = 2;
+    const size_t LEVEL_ALIGNMENT = 16;
+    const size_t MAX_FACES = 6;
+
+    struct SourceStamp {
+        uint64_t size;
+        uint64_t modified;
+    };
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t settingsHash;
+        uint32_t format;
+        uint32_t faceCount;
+        uint32_t mipCount;
+        uint32_t reserved;
+        SourceStamp stamps[MAX_FACES]; // First faceCount used
+    };
+
+    void writeStamps(const std::vector<FileStamp>& stamps, SourceStamp* out) {
+        for (size_t i = 0; i < stamps.size() && i < MAX_FACES; ++i)
+            out[i] = { stamps[i].size, stamps[i].modified };
+    }
+
+    struct LevelEntry {
+        uint64_t offset; // From the start of the texel data
+        uint32_t size;
+        uint32_t width;
+        uint32_t height;
+        uint32_t reserved;
+    };
+
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Box-filters an image down to the next mip level (odd edges reuse the last row/column)
+    DecodedImage downsample(const DecodedImage& source) {
+        DecodedImage result;
+        result.width = std::max(1, source.width / 2);
+        result.height = std::max(1, source.height / 2);
+        result.channels = source.channels;
+        result.pixels.resize(static_cast<size_t>(result.width) * result.height * result.channels);
+
+        const int c = source.channels;
+        for (int y = 0; y < result.height; ++y) {
+            int y0 = std::min(y * 2, source.height - 1);
+            int y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < result.width; ++x) {
+                int x0 = std::min(x * 2, source.width - 1);
+                int x1 = std::min(x * 2 + 1, source.width - 1);
+                const unsigned char* p00 = &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * c];
+                const unsigned char* p01 = &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * c];
+                const unsigned char* p10 = &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * c];
+                const unsigned char* p11 = &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * c];
+                unsigned char* out = &result.pixels[(static_cast<size_t>(y) * result.width + x) * c];
+                for (int i = 0; i < c; ++i)
+                    out[i] = static_cast<unsigned char>((p00[i] + p01[i] + p10[i] + p11[i] + 2) / 4);
+            }
+        }
+        return result;
+    }
+
+    // --- BC1/BC3 block encoding ---
+    // A simple bounding-box encoder: endpoints are the per-channel min/max of the block, inset
+    // slightly to reduce average error. Far from a high-quality encoder, but fast and good
+    // enough for the maze's noisy diffuse textures.
+
+    uint16_t packRGB565(const int rgb[3]) {
+        return static_cast<uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+    }
+
+    void unpackRGB565(uint16_t packed, int rgb[3]) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // block: 16 RGBA pixels. Writes 8 bytes. The color block is always decoded in 4-color mode
+    // when used inside BC3, and we only emit 4-color blocks for BC1 too (opaque sources).
+    void encodeColorBlock(const unsigned char block[64], unsigned char* out) {
+        int minC[3] = { 255, 255, 255 }, maxC[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                minC[c] = std::min(minC[c], static_cast<int>(block[i * 4 + c]));
+                maxC[c] = std::max(maxC[c], static_cast<int>(block[i * 4 + c]));
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            int inset = (maxC[c] - minC[c]) / 16;
+            minC[c] += inset;
+            maxC[c] -= inset;
+        }
+
+        uint16_t color0 = packRGB565(maxC);
+        uint16_t color1 = packRGB565(minC);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            int palette[4][3];
+            unpackRGB565(color0, palette[0]);
+            unpackRGB565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; ++i) {
+                int best = 0, bestError = 1 << 30;
+                for (int p = 0; p < 4; ++p) {
+                    int error = 0;
+                    for (int c = 0; c < 3; ++c) {
+                        int d = block[i * 4 + c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices |= static_cast<uint32_t>(best) << (i * 2);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(color0 & 0xFF);
+        out[1] = static_cast<unsigned char>(color0 >> 8);
+        out[2] = static_cast<unsigned char>(color1 & 0xFF);
+        out[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+
+    // block: 16 RGBA pixels. Writes 8 bytes (8-value interpolated alpha mode).
+    void encodeAlphaBlock(const unsigned char block[64], unsigned char* out) {
+        int minA = 255, maxA = 0;
+        for (int i = 0; i < 16; ++i) {
+            minA = std::min(minA, static_cast<int>(block[i * 4 + 3]));
+            maxA = std::max(maxA, static_cast<int>(block[i * 4 + 3]));
+        }
+
+        uint64_t indices = 0;
+        if (maxA != minA) {
+            int palette[8];
+            palette[0] = maxA;
+            palette[1] = minA;
+            for (int p = 1; p < 7; ++p)
+                palette[p + 1] = ((7 - p) * maxA + p * minA) / 7;
+            for (int i = 0; i < 16; ++i) {
+                int alpha = block[i * 4 + 3];
+                int best = 0, bestError = 256;
+                for (int p = 0; p < 8; ++p) {
+                    int error = std::abs(alpha - palette[p]);
+                    if (error < bestError) { bestError = error; best = p; }
+                }
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(maxA);
+        out[1] = static_cast<unsigned char>(minA);
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+
+    // image must be RGBA
+    std::vector<unsigned char> compressImage(const DecodedImage& image, TexelFormat format) {
+        const int blocksX = (image.width + 3) / 4;
+        const int blocksY = (image.height + 3) / 4;
+        const size_t blockBytes = format == TexelFormat::BC1 ? 8 : 16;
+        std::vector<unsigned char> result(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+        unsigned char block[64];
+        unsigned char* out = result.data();
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                // Gather the block, clamping at the image edge for partial blocks
+                for (int py = 0; py < 4; ++py) {
+                    int y = std::min(by * 4 + py, image.height - 1);
+                    for (int px = 0; px < 4; ++px) {
+                        int x = std::min(bx * 4 + px, image.width - 1);
+                        std::memcpy(&block[(py * 4 + px) * 4], &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+                    }
+                }
+                if (format == TexelFormat::BC3) {
+                    encodeAlphaBlock(block, out);
+                    out += 8;
+                }
+                encodeColorBlock(block, out);
+                out += 8;
+            }
+        }
+        return result;
+    }
+}
+
+bool DecodeImage(const std::string& path, bool flipVertically, DecodedImage& image, int desiredChannels)
+{
+    int fileChannels = 0;
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &fileChannels, desiredChannels);
+    if (!data)
+    {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        image.pixels.clear();
+        return false;
+    }
+
+    image.channels = desiredChannels != 0 ? desiredChannels : fileChannels;
+    size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+    image.pixels.resize(rowBytes * image.height);
+    for (int y = 0; y < image.height; ++y)
+    {
+        int sourceRow = flipVertically ? image.height - 1 - y : y;
+        std::memcpy(&image.pixels[rowBytes * y], data + rowBytes * sourceRow, rowBytes);
+    }
+    stbi_image_free(data);
+
+    image.fileChannels = fileChannels;
+    return true;
+}
+
+DecodedImage ResizeImage(const DecodedImage& image, int width, int height)
+{
+    DecodedImage result;
+    result.width = width;
+    result.height = height;
+    result.channels = image.channels;
+    result.fileChannels = image.fileChannels;
+    result.pixels.resize(static_cast<size_t>(width) * height * image.channels);
+
+    const int c = image.channels;
+    for (int y = 0; y < height; ++y)
+    {
+        // Sample at pixel centers
+        float sy = std::max(0.0f, (y + 0.5f) * image.height / height - 0.5f);
+        int y0 = std::min(static_cast<int>(sy), image.height - 1);
+        int y1 = std::min(y0 + 1, image.height - 1);
+        float fy = sy - y0;
+        for (int x = 0; x < width; ++x)
+        {
+            float sx = std::max(0.0f, (x + 0.5f) * image.width / width - 0.5f);
+            int x0 = std::min(static_cast<int>(sx), image.width - 1);
+            int x1 = std::min(x0 + 1, image.width - 1);
+            float fx = sx - x0;
+            const unsigned char* p00 = &image.pixels[(static_cast<size_t>(y0) * image.width + x0) * c];
+            const unsigned char* p01 = &image.pixels[(static_cast<size_t>(y0) * image.width + x1) * c];
+            const unsigned char* p10 = &image.pixels[(static_cast<size_t>(y1) * image.width + x0) * c];
+            const unsigned char* p11 = &image.pixels[(static_cast<size_t>(y1) * image.width + x1) * c];
+            unsigned char* out = &result.pixels[(static_cast<size_t>(y) * width + x) * c];
+            for (int i = 0; i < c; ++i)
+            {
+                float top = p00[i] + (p01[i] - p00[i]) * fx;
+                float bottom = p10[i] + (p11[i] - p10[i]) * fx;
+                out[i] = static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+    return result;
+}
+
+std::string TextureCache::CachePathFor(const std::vector<std::string>& sources)
+{
+    if (sources.size() == 1)
+        return sources[0] + ".mtex";
+    return sources.empty() ? std::string() : sources[0] + ".cube.mtex";
+}
+
+uint64_t TextureCache::HashSettings(const CookSettings& settings)
+{
+    uint64_t hash = HashBytes(&MTEX_VERSION, sizeof(MTEX_VERSION));
+    uint32_t flags = (settings.generateMipmaps ? 1u : 0u) | (settings.flipVertically ? 2u : 0u) | (settings.compress ? 4u : 0u);
+    hash = HashBytes(&flags, sizeof(flags), hash);
+    int size[2] = { settings.resizeWidth, settings.resizeHeight };
+    return HashBytes(size, sizeof(size), hash);
+}
+
+bool TextureCache::StampSources(const std::vector<std::string>& sources, std::vector<FileStamp>& stamps)
+{
+    stamps.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (!GetFileStamp(sources[i], stamps[i]))
+            return false;
+    }
+    return true;
+}
+
+uint64_t TextureCache::HashSources(const std::vector<std::string>& sources, const CookSettings& settings)
+{
+    uint64_t hash = HashSettings(settings);
+
+    std::vector<unsigned char> bytes;
+    for (const std::string& source : sources)
+    {
+        if (!ReadFileBytes(source, bytes))
+            return 0;
+        hash = HashBytes(bytes.data(), bytes.size(), hash);
+    }
+    return hash == 0 ? 1 : hash; // 0 is reserved for "unreadable"
+}
+
+bool TextureCache::Cook(const std::vector<std::string>& sources, const CookSettings& settings, uint64_t sourceHash,
+                        const std::vector<FileStamp>& stamps, const std::string& outputPath)
+{
+    if (sources.empty() || sources.size() > MAX_FACES || stamps.size() != sources.size())
+        return false;
+
+    // Decode every face. Compression works on RGBA, so ask stb_image for four channels then.
+    std::vector<DecodedImage> faces(sources.size());
+    bool hasAlpha = false;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (!DecodeImage(sources[i], settings.flipVertically, faces[i], settings.compress ? 4 : 0))
+            return false;
+        if (faces[i].fileChannels == 2 || faces[i].fileChannels == 4)
+            hasAlpha = true;
+        if (settings.resizeWidth > 0 && settings.resizeHeight > 0 &&
+            (faces[i].width != settings.resizeWidth || faces[i].height != settings.resizeHeight))
+            faces[i] = ResizeImage(faces[i], settings.resizeWidth, settings.resizeHeight);
+
+        if (faces[i].width != faces[0].width || faces[i].height != faces[0].height || faces[i].channels != faces[0].channels)
+        {
+            std::cerr << "Texture cook: faces differ in size or format: " << sources[i] << std::endl;
+            return false;
+        }
+    }
+
+    TexelFormat format;
+    if (settings.compress)
+    {
+        format = hasAlpha ? TexelFormat::BC3 : TexelFormat::BC1;
+    }
+    else if (faces[0].channels == 1 || faces[0].channels == 3 || faces[0].channels == 4)
+    {
+        format = static_cast<TexelFormat>(faces[0].channels);
+    }
+    else
+    {
+        std::cerr << "Texture cook: unsupported number of channels: " << faces[0].channels << std::endl;
+        return false;
+    }
+
+    int mipCount = 1;
+    if (settings.generateMipmaps)
+    {
+        int size = std::max(faces[0].width, faces[0].height);
+        while (size > 1) { size /= 2; ++mipCount; }
+    }
+
+    // Build every level, face-major, to match the level table
+    std::vector<LevelEntry> entries;
+    std::vector<std::vector<unsigned char>> levelData;
+    size_t offset = 0;
+    for (DecodedImage& face : faces)
+    {
+        DecodedImage level = std::move(face);
+        for (int mip = 0; mip < mipCount; ++mip)
+        {
+            if (mip > 0)
+                level = downsample(level);
+
+            if (TextureCache::IsCompressed(format))
+                levelData.push_back(compressImage(level, format));
+            else
+                levelData.push_back(level.pixels);
+
+            LevelEntry entry = {};
+            entry.offset = offset;
+            entry.size = static_cast<uint32_t>(levelData.back().size());
+            entry.width = static_cast<uint32_t>(level.width);
+            entry.height = static_cast<uint32_t>(level.height);
+            entries.push_back(entry);
+            offset = alignUp(offset + entry.size, LEVEL_ALIGNMENT);
+        }
+    }
+
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write texture cache: " << outputPath << std::endl;
+        return false;
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MTEX_MAGIC, sizeof(MTEX_MAGIC));
+    header.version = MTEX_VERSION;
+    header.sourceHash = sourceHash;
+    header.settingsHash = HashSettings(settings);
+    writeStamps(stamps, header.stamps);
+    header.format = static_cast<uint32_t>(format);
+    header.faceCount = static_cast<uint32_t>(faces.size());
+    header.mipCount = static_cast<uint32_t>(mipCount);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(LevelEntry));
+
+    // Texel data starts aligned too, so level offsets stay aligned in the mapped file
+    size_t headerBytes = sizeof(header) + entries.size() * sizeof(LevelEntry);
+    const char padding[LEVEL_ALIGNMENT] = {};
+    file.write(padding, alignUp(headerBytes, LEVEL_ALIGNMENT) - headerBytes);
+    for (size_t i = 0; i < levelData.size(); ++i)
+    {
+        file.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
+        if (i + 1 < levelData.size())
+            file.write(padding, entries[i + 1].offset - (entries[i].offset + entries[i].size));
+    }
+
+    if (!file)
+    {
+        std::cerr << "Failed to write texture cache: " << outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TextureCache::Restamp(const std::string& path, const std::vector<FileStamp>& stamps)
+{
+    if (stamps.empty() || stamps.size() > MAX_FACES)
+        return false;
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file)
+        return false;
+    SourceStamp written[MAX_FACES] = {};
+    writeStamps(stamps, written);
+    file.seekp(offsetof(FileHeader, stamps));
+    file.write(reinterpret_cast<const char*>(written), stamps.size() * sizeof(SourceStamp));
+    return static_cast<bool>(file);
+}
+
+bool CookedTexture::Open(const std::string& path)
+{
+    Close();
+    if (!M_File.Open(path))
+        return false;
+
+    const unsigned char* data = M_File.GetData();
+    const size_t size = M_File.GetSize();
+
+    FileHeader header;
+    if (size < sizeof(header))
+    {
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (!std::equal(header.magic, header.magic + 4, MTEX_MAGIC) || header.version != MTEX_VERSION ||
+        header.faceCount == 0 || header.faceCount > MAX_FACES ||
+        header.mipCount == 0 || header.mipCount > 32)
+    {
+        Close(); // Old or foreign file; the caller cooks it again
+        return false;
+    }
+    M_SourceHash = header.sourceHash;
+    M_SettingsHash = header.settingsHash;
+    M_Stamps.resize(header.faceCount);
+    for (uint32_t i = 0; i < header.faceCount; ++i)
+    {
+        M_Stamps[i].size = header.stamps[i].size;
+        M_Stamps[i].modified = header.stamps[i].modified;
+    }
+
+    const size_t levelCount = static_cast<size_t>(header.faceCount) * header.mipCount;
+    const size_t headerBytes = sizeof(header) + levelCount * sizeof(LevelEntry);
+    M_DataStart = alignUp(headerBytes, LEVEL_ALIGNMENT);
+    if (size < M_DataStart)
+    {
+        Close();
+        return false;
+    }
+
+    M_Format = static_cast<TexelFormat>(header.format);
+    M_FaceCount = static_cast<int>(header.faceCount);
+    M_MipCount = static_cast<int>(header.mipCount);
+    M_Levels.resize(levelCount);
+    for (size_t i = 0; i < levelCount; ++i)
+    {
+        LevelEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(LevelEntry), sizeof(entry));
+        if (entry.offset + entry.size > size - M_DataStart)
+        {
+            std::cerr << "Texture cache is truncated: " << path << std::endl;
+            Close();
+            return false;
+        }
+        M_Levels[i].offset = static_cast<size_t>(entry.offset);
+        M_Levels[i].size = entry.size;
+        M_Levels[i].width = static_cast<int>(entry.width);
+        M_Levels[i].height = static_cast<int>(entry.height);
+    }
+    return true;
+}
+
+void CookedTexture::Close()
+{
+    M_File.Close();
+    M_Levels.clear();
+    M_Stamps.clear();
+    M_SourceHash = 0;
+    M_SettingsHash = 0;
+    M_FaceCount = 0;
+    M_MipCount = 0;
+    M_DataStart = 0;
+}
+
+bool CookedTexture::MatchesStamps(const std::vector<FileStamp>& stamps, uint64_t settingsHash) const
+{
+    return IsOpen() && settingsHash == M_SettingsHash && stamps == M_Stamps;
+}
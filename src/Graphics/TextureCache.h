@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Utils/FileSystem.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cooked texture cache (.mtex files).
+// Cooking decodes the source images once, builds the full mip chain on the CPU and optionally
+// block-compresses every level. The result is written next to the source as one file whose
+// texel data is laid out exactly as it is uploaded, so at runtime the file is memory-mapped and
+// handed to OpenGL without decoding or glGenerateMipmap. Each file stores a hash of the source
+// bytes and cook settings; a changed source (or setting) simply misses and is cooked again.
+// It also stores the size and write time of every source: while those match, the cache is
+// used without reading the sources at all, and only a mismatch falls back to the hash.
+//
+// File layout: Header (with up to six source stamps), then faceCount * mipCount LevelEntry
+// records (face-major), then the texel data of every level, each level 16-byte aligned.
+
+enum class TexelFormat : uint32_t {
+    R8 = 1,
+    RGB8 = 3,
+    RGBA8 = 4,
+    BC1 = 0x10, // 8 bytes per 4x4 block, opaque RGB (sources without alpha)
+    BC3 = 0x11  // 16 bytes per 4x4 block, RGB + interpolated alpha
+};
+
+// One decoded image, rows tightly packed
+struct DecodedImage {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int fileChannels = 0; // Before any expansion to desiredChannels
+};
+
+// Decodes an image with stb_image. Rows are flipped here rather than through stb_image's global
+// flip flag, so this is safe to call from several threads at once.
+// desiredChannels = 0 keeps the file's channel count.
+bool DecodeImage(const std::string& path, bool flipVertically, DecodedImage& image, int desiredChannels = 0);
+
+// Bilinear resample to a new size (used to fit images into texture array layers)
+DecodedImage ResizeImage(const DecodedImage& image, int width, int height);
+
+class TextureCache {
+public:
+    struct CookSettings {
+        bool generateMipmaps = true;
+        bool flipVertically = true;
+        bool compress = false; // BC1 for opaque sources, BC3 for sources with alpha
+        int resizeWidth = 0;   // Resample level 0 to this size (0 = keep the source size)
+        int resizeHeight = 0;
+    };
+
+    // Cache location for a texture made of these sources (one for 2D, six for a cubemap)
+    static std::string CachePathFor(const std::vector<std::string>& sources);
+
+    // Hash of the source file bytes and the settings. Returns 0 if a source can't be read.
+    static uint64_t HashSources(const std::vector<std::string>& sources, const CookSettings& settings);
+    // Hash of the settings alone, checked together with the source stamps
+    static uint64_t HashSettings(const CookSettings& settings);
+    // Size and write time of every source. Returns false if one is missing.
+    static bool StampSources(const std::vector<std::string>& sources, std::vector<FileStamp>& stamps);
+
+    // Decode, build mips, compress and write the cache file
+    static bool Cook(const std::vector<std::string>& sources, const CookSettings& settings, uint64_t sourceHash,
+                     const std::vector<FileStamp>& stamps, const std::string& outputPath);
+
+    // Replaces the source stamps of a cache file whose sources were touched but not changed
+    static bool Restamp(const std::string& path, const std::vector<FileStamp>& stamps);
+
+    static bool IsCompressed(TexelFormat format) { return format == TexelFormat::BC1 || format == TexelFormat::BC3; }
+};
+
+// A cooked texture mapped into memory. Level pointers stay valid until Close().
+class CookedTexture {
+public:
+    struct Level {
+        size_t offset; // From the start of GetTexelData()
+        uint32_t size;
+        int width;
+        int height;
+    };
+
+    // Fails if the file is missing or malformed; whether it is up to date is checked separately
+    bool Open(const std::string& path);
+    void Close();
+
+    // True if the sources still have the size and write time they were cooked from, with the
+    // same settings (see TextureCache::HashSettings)
+    bool MatchesStamps(const std::vector<FileStamp>& stamps, uint64_t settingsHash) const;
+    uint64_t GetSourceHash() const { return M_SourceHash; }
+
+    bool IsOpen() const { return M_File.IsOpen(); }
+    TexelFormat GetFormat() const { return M_Format; }
+    int GetFaceCount() const { return M_FaceCount; }
+    int GetMipCount() const { return M_MipCount; }
+    const Level& GetLevel(int face, int mip) const { return M_Levels[face * M_MipCount + mip]; }
+
+    // All levels in one contiguous block, so they can be copied into a single upload buffer
+    const unsigned char* GetTexelData() const { return M_File.GetData() + M_DataStart; }
+    size_t GetTexelDataSize() const { return M_File.GetSize() - M_DataStart; }
+
+private:
+    MappedFile M_File;
+    uint64_t M_SourceHash = 0;
+    uint64_t M_SettingsHash = 0;
+    std::vector<FileStamp> M_Stamps;
+    TexelFormat M_Format = TexelFormat::RGBA8;
+    int M_FaceCount = 0;
+    int M_MipCount = 0;
+    size_t M_DataStart = 0;
+    std::vector<Level> M_Levels;
+};
@@ -0,0 +1,494 @@
+#include "TextureLoader.h"
+#include "GLStateCache.h"
+#include "GLUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "../../external/stb_image.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+    double nowMs() {
+        using namespace std::chrono;
+        return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    GLenum formatForChannels(int channels) {
+        if (channels == 1) return GL_RED;
+        if (channels == 3) return GL_RGB;
+        if (channels == 4) return GL_RGBA;
+        std::cerr << "Unsupported number of channels: " << channels << std::endl;
+        return GL_RGB;
+    }
+
+    GLenum formatForTexels(TexelFormat format) {
+        switch (format) {
+            case TexelFormat::R8:    return GL_RED;
+            case TexelFormat::RGB8:  return GL_RGB;
+            case TexelFormat::RGBA8: return GL_RGBA;
+            case TexelFormat::BC1:   return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case TexelFormat::BC3:   return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+        return GL_RGBA;
+    }
+}
+
+TextureLoader::TextureLoader(unsigned int threadCount)
+    : M_Stopping(false), M_PixelBuffer(0), M_UploadBudget(8 * 1024 * 1024), M_Pending(0),
+      M_GpuMemoryBytes(0), M_UseCache(true), M_Compress(false),
+      M_FirstRequestTime(0.0), M_SlowestDecodeMs(0.0)
+{
+    // stb_image's flip flag is global and not thread-safe, so workers always decode
+    // unflipped and flip rows themselves
+    stbi_set_flip_vertically_on_load(false);
+
+    glGenBuffers(1, &M_PixelBuffer);
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < threadCount; ++i)
+        M_Workers.emplace_back(&TextureLoader::workerLoop, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        M_Stopping = true;
+        M_Jobs.clear();
+    }
+    M_WorkAvailable.notify_all();
+    for (std::thread& worker : M_Workers)
+        worker.join();
+
+    glDeleteBuffers(1, &M_PixelBuffer);
+}
+
+void TextureLoader::SetCompression(bool compress)
+{
+    if (compress && !HasGLExtension("GL_EXT_texture_compression_s3tc"))
+    {
+        std::cerr << "S3TC texture compression not supported, textures stay uncompressed" << std::endl;
+        compress = false;
+    }
+    M_Compress = compress;
+}
+
+Texture* TextureLoader::Load(const std::string& path, bool generateMipmaps)
+{
+    M_Textures.push_back(std::make_unique<Texture>(GL_TEXTURE_2D));
+    Texture* texture = M_Textures.back().get();
+    // OpenGL expects (0,0) at the bottom left, same as Texture's synchronous constructor
+    TextureCache::CookSettings settings;
+    settings.generateMipmaps = generateMipmaps;
+    settings.flipVertically = true;
+    settings.compress = M_Compress;
+    enqueue(texture, nullptr, 0, { path }, settings);
+    return texture;
+}
+
+Texture* TextureLoader::LoadCubemap(const std::vector<std::string>& faces)
+{
+    M_Textures.push_back(std::make_unique<Texture>(GL_TEXTURE_CUBE_MAP));
+    Texture* texture = M_Textures.back().get();
+    TextureCache::CookSettings settings;
+    settings.generateMipmaps = false;
+    settings.flipVertically = false; // Cubemap faces are used as stored
+    settings.compress = M_Compress;
+    enqueue(texture, nullptr, 0, faces, settings);
+    return texture;
+}
+
+void TextureLoader::LoadLayer(TextureArray& array, int layer, const std::string& path)
+{
+    // Layers are cooked at the array's size and stay uncompressed, because they are written
+    // into the array's existing RGBA8 storage
+    TextureCache::CookSettings settings;
+    settings.generateMipmaps = array.GetMipCount() > 1;
+    settings.flipVertically = true;
+    settings.compress = false;
+    settings.resizeWidth = array.GetWidth();
+    settings.resizeHeight = array.GetHeight();
+    enqueue(nullptr, &array, layer, { path }, settings);
+}
+
+void TextureLoader::enqueue(Texture* texture, TextureArray* array, int layer, const std::vector<std::string>& paths,
+                            const TextureCache::CookSettings& settings)
+{
+    if (M_Pending == 0)
+        M_FirstRequestTime = nowMs();
+    ++M_Pending;
+
+    auto request = std::make_unique<Request>();
+    request->texture = texture;
+    request->array = array;
+    request->layer = layer;
+    request->paths = paths;
+    request->faces.resize(paths.size());
+    request->settings = settings;
+    request->failed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        if (M_UseCache)
+        {
+            // One job: the cache file holds every face
+            request->facesRemaining = 1;
+            M_Jobs.push_back({ request.get(), -1 });
+        }
+        else
+        {
+            request->facesRemaining = static_cast<int>(paths.size());
+            for (int face = 0; face < static_cast<int>(paths.size()); ++face)
+                M_Jobs.push_back({ request.get(), face });
+        }
+    }
+    M_Requests.push_back(std::move(request));
+    M_WorkAvailable.notify_all();
+}
+
+void TextureLoader::workerLoop()
+{
+    while (true)
+    {
+        DecodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(M_Mutex);
+            M_WorkAvailable.wait(lock, [this] { return M_Stopping || !M_Jobs.empty(); });
+            if (M_Stopping)
+                return;
+            job = M_Jobs.front();
+            M_Jobs.pop_front();
+        }
+
+        // Decode outside the lock; each job writes only its own face
+        Request& request = *job.request;
+        double start = nowMs();
+        bool succeeded;
+        if (job.face < 0)
+            succeeded = resolveFromCache(request);
+        else
+            succeeded = decodeFace(request, job.face);
+        double elapsed = nowMs() - start;
+
+        std::lock_guard<std::mutex> lock(M_Mutex);
+        M_SlowestDecodeMs = std::max(M_SlowestDecodeMs, elapsed);
+        if (!succeeded)
+            request.failed = true;
+        if (--request.facesRemaining == 0)
+            M_Decoded.push_back(&request);
+    }
+}
+
+bool TextureLoader::resolveFromCache(Request& request)
+{
+    std::vector<FileStamp> stamps;
+    if (!TextureCache::StampSources(request.paths, stamps))
+    {
+        std::cerr << "Failed to load texture: " << request.paths[0] << std::endl;
+        return false;
+    }
+
+    // Sources with the size and write time they were cooked from aren't read at all
+    const std::string cachePath = TextureCache::CachePathFor(request.paths);
+    if (request.cooked.Open(cachePath) && request.cooked.MatchesStamps(stamps, TextureCache::HashSettings(request.settings)))
+        return true;
+
+    // Otherwise compare contents: a source that was only touched (or checked out again) keeps
+    // its cache, restamped so the next launch takes the fast path
+    uint64_t hash = TextureCache::HashSources(request.paths, request.settings);
+    if (hash == 0)
+    {
+        std::cerr << "Failed to load texture: " << request.paths[0] << std::endl;
+        request.cooked.Close();
+        return false;
+    }
+    if (request.cooked.IsOpen() && request.cooked.GetSourceHash() == hash)
+    {
+        request.cooked.Close(); // Unmapped before its header is rewritten
+        TextureCache::Restamp(cachePath, stamps);
+        if (request.cooked.Open(cachePath))
+            return true;
+    }
+    request.cooked.Close();
+
+    // Missing or stale: cook now so the next launch hits
+    double start = nowMs();
+    if (TextureCache::Cook(request.paths, request.settings, hash, stamps, cachePath) && request.cooked.Open(cachePath))
+    {
+        std::cout << "Cooked texture cache " << cachePath << " in " << nowMs() - start << " ms" << std::endl;
+        return true;
+    }
+
+    // Cache unusable (e.g. read-only directory): fall back to plain decoding
+    std::cerr << "Texture cache unavailable for " << request.paths[0] << ", decoding directly" << std::endl;
+    for (int face = 0; face < static_cast<int>(request.paths.size()); ++face)
+    {
+        if (!decodeFace(request, face))
+            return false;
+    }
+    return true;
+}
+
+bool TextureLoader::decodeFace(Request& request, int face)
+{
+    DecodedImage& image = request.faces[face];
+    if (!DecodeImage(request.paths[face], request.settings.flipVertically, image))
+        return false;
+
+    const TextureCache::CookSettings& settings = request.settings;
+    if (settings.resizeWidth > 0 && settings.resizeHeight > 0 &&
+        (image.width != settings.resizeWidth || image.height != settings.resizeHeight))
+        image = ResizeImage(image, settings.resizeWidth, settings.resizeHeight);
+    return true;
+}
+
+void TextureLoader::Update()
+{
+    size_t uploaded = 0;
+    while (uploaded < M_UploadBudget)
+    {
+        Request* request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(M_Mutex);
+            if (M_Decoded.empty())
+                break;
+            request = M_Decoded.front();
+            M_Decoded.pop_front();
+        }
+
+        uploaded += upload(*request);
+        --M_Pending;
+
+        // Free the decoded pixels and unmap the cache file; the request record itself is tiny
+        request->faces.clear();
+        request->faces.shrink_to_fit();
+        request->cooked.Close();
+
+        if (M_Pending == 0)
+        {
+            std::lock_guard<std::mutex> lock(M_Mutex);
+            std::cout << "All textures loaded in " << nowMs() - M_FirstRequestTime
+                      << " ms (slowest single job: " << M_SlowestDecodeMs << " ms, texture cache "
+                      << (M_UseCache ? "on" : "off") << ", "
+                      << M_GpuMemoryBytes / (1024.0 * 1024.0) << " MB texture memory)" << std::endl;
+        }
+    }
+}
+
+size_t TextureLoader::upload(Request& request)
+{
+    if (request.failed)
+    {
+        return 0; // Keep the placeholder
+    }
+    if (request.array)
+    {
+        return uploadLayer(request);
+    }
+
+    Texture& texture = *request.texture;
+    if (request.cooked.IsOpen())
+    {
+        return uploadCooked(request);
+    }
+
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), texture.Target, texture.ID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, M_PixelBuffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows are tightly packed
+
+    size_t bytes = 0;
+    if (texture.Target == GL_TEXTURE_CUBE_MAP)
+    {
+        for (size_t face = 0; face < request.faces.size(); ++face)
+        {
+            uploadImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(face), request.faces[face]);
+            bytes += request.faces[face].pixels.size();
+        }
+    }
+    else
+    {
+        uploadImage(GL_TEXTURE_2D, request.faces[0]);
+        bytes += request.faces[0].pixels.size();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (request.settings.generateMipmaps)
+    {
+        glTexParameteri(texture.Target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glGenerateMipmap(texture.Target);
+        M_GpuMemoryBytes += bytes * 4 / 3; // Full chain is about a third extra
+    }
+    else
+    {
+        M_GpuMemoryBytes += bytes;
+    }
+
+    const DecodedImage& first = request.faces[0];
+    texture.width = first.width;
+    texture.height = first.height;
+    texture.channels = first.channels;
+    texture.M_Ready = true;
+
+    std::cout << "Texture loaded: " << request.paths[0] << " (" << first.width << "x" << first.height << ", "
+              << first.channels << " channels)" << std::endl;
+    return bytes;
+}
+
+size_t TextureLoader::uploadCooked(Request& request)
+{
+    Texture& texture = *request.texture;
+    const CookedTexture& cooked = request.cooked;
+
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), texture.Target, texture.ID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, M_PixelBuffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // The file's texel block is already in upload order: copy it into the PBO in one go and
+    // point each level at its offset
+    const size_t size = cooked.GetTexelDataSize();
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const unsigned char* base = nullptr; // nullptr: level offsets index the bound PBO
+    if (mapped)
+    {
+        std::memcpy(mapped, cooked.GetTexelData(), size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        std::cerr << "Failed to map pixel buffer, uploading directly" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        base = cooked.GetTexelData();
+    }
+
+    const GLenum format = formatForTexels(cooked.GetFormat());
+    const bool compressed = TextureCache::IsCompressed(cooked.GetFormat());
+    size_t bytes = 0;
+    for (int face = 0; face < cooked.GetFaceCount(); ++face)
+    {
+        GLenum target = texture.Target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+        for (int mip = 0; mip < cooked.GetMipCount(); ++mip)
+        {
+            const CookedTexture::Level& level = cooked.GetLevel(face, mip);
+            const void* pixels = base ? static_cast<const void*>(base + level.offset)
+                                      : reinterpret_cast<const void*>(level.offset);
+            if (compressed)
+                glCompressedTexImage2D(target, mip, format, level.width, level.height, 0, level.size, pixels);
+            else
+                glTexImage2D(target, mip, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+            bytes += level.size;
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // The chain came from the file; no glGenerateMipmap
+    glTexParameteri(texture.Target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(texture.Target, GL_TEXTURE_MAX_LEVEL, cooked.GetMipCount() - 1);
+    if (cooked.GetMipCount() > 1)
+        glTexParameteri(texture.Target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    M_GpuMemoryBytes += bytes;
+
+    const CookedTexture::Level& top = cooked.GetLevel(0, 0);
+    texture.width = top.width;
+    texture.height = top.height;
+    texture.channels = compressed ? 4 : static_cast<int>(cooked.GetFormat());
+    texture.M_Ready = true;
+
+    std::cout << "Texture loaded from cache: " << request.paths[0] << " (" << top.width << "x" << top.height << ", "
+              << cooked.GetMipCount() << " mips" << (compressed ? ", block compressed" : "") << ")" << std::endl;
+    return bytes;
+}
+
+size_t TextureLoader::uploadLayer(Request& request)
+{
+    TextureArray& array = *request.array;
+    const CookedTexture& cooked = request.cooked;
+
+    GLStateCache::BindTexture(GLStateCache::GetActiveTextureUnit(), GL_TEXTURE_2D_ARRAY, array.ID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, M_PixelBuffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Either every level from the cooked file, or level 0 from the decoded image
+    const unsigned char* source = cooked.IsOpen() ? cooked.GetTexelData() : request.faces[0].pixels.data();
+    const size_t size = cooked.IsOpen() ? cooked.GetTexelDataSize() : request.faces[0].pixels.size();
+    const int channels = cooked.IsOpen() ? static_cast<int>(cooked.GetFormat()) : request.faces[0].channels;
+    const int levels = cooked.IsOpen() ? std::min(cooked.GetMipCount(), array.GetMipCount()) : 1;
+
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const unsigned char* base = nullptr; // nullptr: offsets index the bound PBO
+    if (mapped)
+    {
+        std::memcpy(mapped, source, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        std::cerr << "Failed to map pixel buffer, uploading directly" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        base = source;
+    }
+
+    const GLenum format = formatForChannels(channels);
+    for (int mip = 0; mip < levels; ++mip)
+    {
+        size_t offset = cooked.IsOpen() ? cooked.GetLevel(0, mip).offset : 0;
+        int width = cooked.IsOpen() ? cooked.GetLevel(0, mip).width : request.faces[0].width;
+        int height = cooked.IsOpen() ? cooked.GetLevel(0, mip).height : request.faces[0].height;
+        const void* pixels = base ? static_cast<const void*>(base + offset) : reinterpret_cast<const void*>(offset);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, request.layer, width, height, 1, format, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Without a cooked chain the mips are rebuilt on the GPU (this touches every layer)
+    if (levels < array.GetMipCount())
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    // The array's storage was allocated up front; count this layer's share once it is real
+    M_GpuMemoryBytes += array.GetMemoryUsage() / array.GetLayerCount();
+
+    std::cout << "Texture layer " << request.layer << " loaded" << (cooked.IsOpen() ? " from cache" : "") << ": "
+              << request.paths[0] << " (" << array.GetWidth() << "x" << array.GetHeight() << ")" << std::endl;
+    return size;
+}
+
+void TextureLoader::uploadImage(GLenum target, const DecodedImage& image)
+{
+    // Orphan the PBO so the driver never waits for the previous upload, copy the pixels into
+    // it and let glTexImage2D source from the buffer (offset 0) instead of client memory
+    GLsizeiptr size = static_cast<GLsizeiptr>(image.pixels.size());
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped)
+    {
+        std::cerr << "Failed to map pixel buffer, uploading directly" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GLenum format = formatForChannels(image.channels);
+        glTexImage2D(target, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.data());
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, M_PixelBuffer);
+        return;
+    }
+    std::memcpy(mapped, image.pixels.data(), image.pixels.size());
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLenum format = formatForChannels(image.channels);
+    glTexImage2D(target, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+}
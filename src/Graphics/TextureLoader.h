@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Texture.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads textures without blocking the render loop.
+// Load/LoadCubemap return a placeholder texture immediately. Images are decoded on worker
+// threads (one job per image file, so cubemap faces decode in parallel too), and Update()
+// uploads finished images through a pixel buffer object on the GL thread, limited to a
+// per-frame byte budget. The Texture's ID never changes, so it can be submitted right away.
+// Workers decode with stb_image's flip flag off, so avoid the synchronous Texture
+// constructor (which turns it on) while loads are in flight.
+//
+// With the texture cache enabled (the default) a worker first looks for a fresh cooked .mtex
+// file (see TextureCache) and maps it instead of decoding; all mip levels are uploaded as
+// stored. A missing or stale file is cooked on the spot, so only the first launch pays.
+class TextureLoader {
+public:
+    explicit TextureLoader(unsigned int threadCount = 0);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Both settings apply to textures requested afterwards.
+    // Compression is ignored (with a warning) if the driver lacks S3TC support.
+    void SetUseCache(bool useCache) { M_UseCache = useCache; }
+    void SetCompression(bool compress);
+
+    // The loader owns the returned textures; they live as long as the loader
+    Texture* Load(const std::string& path, bool generateMipmaps = true);
+    // Faces in GL order: +X, -X, +Y, -Y, +Z, -Z
+    Texture* LoadCubemap(const std::vector<std::string>& faces);
+    // Fills one layer of a texture array (the array is owned by the caller). The image is
+    // resampled to the layer size if needed.
+    void LoadLayer(TextureArray& array, int layer, const std::string& path);
+
+    // Call once per frame on the GL thread. Uploads finished images until the budget is spent
+    // (at least one texture per call, so large images still make progress).
+    void Update();
+
+    void SetUploadBudget(size_t bytesPerFrame) { M_UploadBudget = bytesPerFrame; }
+    bool IsIdle() const { return M_Pending == 0; }
+
+    // Texel bytes handed to OpenGL so far, mip levels included (drivers may pad RGB to RGBA)
+    size_t GetGpuMemoryBytes() const { return M_GpuMemoryBytes; }
+
+private:
+    // A texture being loaded. Ready for upload once every face is decoded (or the cooked
+    // file is mapped).
+    struct Request {
+        Texture* texture;    // Either a texture...
+        TextureArray* array; // ...or a layer of an array
+        int layer;
+        std::vector<std::string> paths;
+        std::vector<DecodedImage> faces;
+        CookedTexture cooked;
+        TextureCache::CookSettings settings;
+        int facesRemaining; // Guarded by M_Mutex
+        bool failed;        // Guarded by M_Mutex
+    };
+
+    // face = -1: resolve the whole request through the texture cache
+    struct DecodeJob {
+        Request* request;
+        int face;
+    };
+
+    std::vector<std::unique_ptr<Texture>> M_Textures;
+    std::vector<std::unique_ptr<Request>> M_Requests;
+    std::vector<std::thread> M_Workers;
+
+    std::mutex M_Mutex;
+    std::condition_variable M_WorkAvailable;
+    std::deque<DecodeJob> M_Jobs;     // Guarded by M_Mutex
+    std::deque<Request*> M_Decoded;   // Guarded by M_Mutex, waiting for upload
+    bool M_Stopping;                  // Guarded by M_Mutex
+
+    unsigned int M_PixelBuffer;       // Streaming PBO for uploads
+    size_t M_UploadBudget;
+    size_t M_Pending;                 // Requests not yet uploaded (GL thread only)
+    size_t M_GpuMemoryBytes;
+    bool M_UseCache;
+    bool M_Compress;
+
+    // Timing for the startup report
+    double M_FirstRequestTime;
+    double M_SlowestDecodeMs;         // Guarded by M_Mutex
+
+    void workerLoop();
+    bool resolveFromCache(Request& request);
+    bool decodeFace(Request& request, int face);
+    void enqueue(Texture* texture, TextureArray* array, int layer, const std::vector<std::string>& paths,
+                 const TextureCache::CookSettings& settings);
+    size_t upload(Request& request);
+    size_t uploadCooked(Request& request);
+    size_t uploadLayer(Request& request);
+    void uploadImage(GLenum target, const DecodedImage& image);
+};
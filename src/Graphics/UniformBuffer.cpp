@@ -0,0 +1,31 @@
+#include "UniformBuffer.h"
+#include <iostream>
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int bindingPoint)
+    : ID(0), M_Size(size), M_BindingPoint(bindingPoint)
+{
+    glGenBuffers(1, &ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Attach the whole buffer to its binding point once; programs refer to the point
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ID);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &ID);
+}
+
+void UniformBuffer::SetData(const void* data, size_t size, size_t offset)
+{
+    if (offset + size > M_Size)
+    {
+        std::cerr << "UniformBuffer::SetData out of range (" << offset + size << " > " << M_Size << ")" << std::endl;
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
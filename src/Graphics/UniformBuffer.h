@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Binding points of the uniform blocks shared by all shader programs.
+// Shader binds blocks with these names to these points after linking.
+namespace UniformBlockBinding {
+    enum : unsigned int {
+        Camera = 0,   // "Camera" block, see CameraBlock
+        Lighting = 1  // "Lighting" block, see LightingBlock
+    };
+}
+
+// CPU mirrors of the std140 blocks declared in the shaders.
+// Only vec4/mat4 members are used so the C++ layout matches std140 without padding tricks.
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPos; // xyz = camera position in world space
+};
+
+struct LightingBlock {
+    glm::vec4 direction; // xyz = direction the light travels
+    glm::vec4 color;     // rgb = light color, a = ambient intensity
+    glm::vec4 time;      // x = seconds, drives the point light flicker
+    glm::mat4 shadowSpace; // World to shadow map coordinates and depth (see ShadowMap)
+};
+
+// A uniform buffer object attached to a fixed binding point
+class UniformBuffer {
+public:
+    unsigned int ID;
+
+    UniformBuffer(size_t size, unsigned int bindingPoint);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Upload new contents (or a sub-range of them)
+    void SetData(const void* data, size_t size, size_t offset = 0);
+
+    unsigned int GetBindingPoint() const { return M_BindingPoint; }
+
+private:
+    size_t M_Size;
+    unsigned int M_BindingPoint;
+};
@@ -0,0 +1,172 @@
+#include "FileSystem.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : M_Data(nullptr), M_Size(0), M_FileHandle(INVALID_HANDLE_VALUE), M_MappingHandle(nullptr)
+{
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    M_FileHandle = file;
+    M_MappingHandle = mapping;
+    M_Data = static_cast<const unsigned char*>(view);
+    M_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (M_Data)
+        UnmapViewOfFile(M_Data);
+    if (M_MappingHandle)
+        CloseHandle(M_MappingHandle);
+    if (M_FileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(M_FileHandle);
+
+    M_Data = nullptr;
+    M_Size = 0;
+    M_FileHandle = INVALID_HANDLE_VALUE;
+    M_MappingHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : M_Data(nullptr), M_Size(0), M_FileDescriptor(-1)
+{
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    M_FileDescriptor = fd;
+    M_Data = static_cast<const unsigned char*>(view);
+    M_Size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (M_Data)
+        munmap(const_cast<unsigned char*>(M_Data), M_Size);
+    if (M_FileDescriptor >= 0)
+        close(M_FileDescriptor);
+
+    M_Data = nullptr;
+    M_Size = 0;
+    M_FileDescriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool ReadFileBytes(const std::string& path, std::vector<unsigned char>& data)
+{
+    data.clear();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    std::streamsize size = file.tellg();
+    if (size < 0)
+        return false;
+    file.seekg(0, std::ios::beg);
+
+    data.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(reinterpret_cast<char*>(data.data()), size))
+    {
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+bool GetFileStamp(const std::string& path, FileStamp& stamp)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+        return false;
+    stamp.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    stamp.modified = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    stamp.size = static_cast<uint64_t>(info.st_size);
+#ifdef __APPLE__
+    stamp.modified = static_cast<uint64_t>(info.st_mtimespec.tv_sec) * 1000000000ull + info.st_mtimespec.tv_nsec;
+#else
+    stamp.modified = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000ull + info.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
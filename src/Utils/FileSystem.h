@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only memory mapping of a whole file. The OS pages the contents in on demand, so
+// large cache files cost nothing until they are read and never go through a heap copy.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return M_Data != nullptr; }
+    const unsigned char* GetData() const { return M_Data; }
+    size_t GetSize() const { return M_Size; }
+
+private:
+    const unsigned char* M_Data;
+    size_t M_Size;
+#ifdef _WIN32
+    void* M_FileHandle;
+    void* M_MappingHandle;
+#else
+    int M_FileDescriptor;
+#endif
+};
+
+// Reads an entire file into memory. Returns false (and leaves data empty) on failure.
+bool ReadFileBytes(const std::string& path, std::vector<unsigned char>& data);
+
+// Size and last write time of a file, to tell cheaply whether it changed
+struct FileStamp {
+    uint64_t size = 0;
+    uint64_t modified = 0; // Platform-specific units; only compared for equality
+
+    bool operator==(const FileStamp& other) const { return size == other.size && modified == other.modified; }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// Returns false if the file doesn't exist or can't be queried
+bool GetFileStamp(const std::string& path, FileStamp& stamp);
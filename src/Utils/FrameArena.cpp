@@ -0,0 +1,41 @@
+#include "FrameArena.h"
+#include <cstdint>
+
+namespace {
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : M_Block(new unsigned char[initialCapacity]), M_Capacity(initialCapacity), M_Offset(0), M_Used(0)
+{
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    // Align the actual address, not just the offset, so any block base works
+    uintptr_t base = reinterpret_cast<uintptr_t>(M_Block.get());
+    size_t offset = alignUp(base + M_Offset, alignment) - base;
+    M_Used += size;
+
+    if (offset + size <= M_Capacity) {
+        M_Offset = offset + size;
+        return M_Block.get() + offset;
+    }
+
+    // Doesn't fit: serve from a dedicated overflow block for the rest of this frame
+    M_Overflow.emplace_back(new unsigned char[size + alignment]);
+    uintptr_t overflowBase = reinterpret_cast<uintptr_t>(M_Overflow.back().get());
+    return reinterpret_cast<void*>(alignUp(overflowBase, alignment));
+}
+
+void FrameArena::Reset() {
+    if (!M_Overflow.empty()) {
+        // Grow once to cover the whole frame (with some headroom) and drop the extras
+        M_Overflow.clear();
+        M_Capacity = M_Used + M_Used / 2;
+        M_Block.reset(new unsigned char[M_Capacity]);
+    }
+    M_Offset = 0;
+    M_Used = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Linear (bump) allocator for per-frame scratch data.
+// Allocations are never freed individually; Reset() releases everything at once.
+// If a frame needs more than the current block, extra blocks are allocated, and the next
+// Reset() replaces the block by one large enough for that high-water mark. After warm-up
+// a frame therefore performs no heap allocations at all.
+// Only use it for trivially destructible types: destructors are never run.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment);
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Invalidates every pointer handed out since the last Reset
+    void Reset();
+
+    size_t GetUsed() const { return M_Used; }
+    size_t GetCapacity() const { return M_Capacity; }
+
+private:
+    std::unique_ptr<unsigned char[]> M_Block;
+    size_t M_Capacity;
+    size_t M_Offset;
+    size_t M_Used; // Bytes handed out this frame, including overflow blocks
+
+    std::vector<std::unique_ptr<unsigned char[]>> M_Overflow;
+};
@@ -0,0 +1,111 @@
+#include "Image.h"
+#include "FileSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // Next whitespace-separated header token, skipping # comments
+    bool readToken(const std::vector<unsigned char>& data, size_t& pos, std::string& token) {
+        token.clear();
+        while (pos < data.size())
+        {
+            if (data[pos] == '#')
+            {
+                while (pos < data.size() && data[pos] != '\n')
+                    ++pos;
+            }
+            else if (std::isspace(data[pos]))
+                ++pos;
+            else
+                break;
+        }
+        while (pos < data.size() && !std::isspace(data[pos]))
+            token += static_cast<char>(data[pos++]);
+        return !token.empty();
+    }
+}
+
+bool WritePPM(const std::string& path, const unsigned char* rgba, int width, int height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to write image: " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char* source = rgba + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x)
+        {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+bool ReadPPM(const std::string& path, std::vector<unsigned char>& rgba, int& width, int& height)
+{
+    std::vector<unsigned char> data;
+    if (!ReadFileBytes(path, data))
+        return false;
+
+    size_t pos = 0;
+    std::string magic, widthToken, heightToken, maxToken;
+    if (!readToken(data, pos, magic) || magic != "P6" || !readToken(data, pos, widthToken) ||
+        !readToken(data, pos, heightToken) || !readToken(data, pos, maxToken) || maxToken != "255")
+    {
+        std::cerr << "Not an 8-bit binary PPM: " << path << std::endl;
+        return false;
+    }
+    ++pos; // Single whitespace byte before the pixels
+    width = std::atoi(widthToken.c_str());
+    height = std::atoi(heightToken.c_str());
+    const size_t pixelCount = static_cast<size_t>(std::max(width, 0)) * std::max(height, 0);
+    if (pixelCount == 0 || data.size() < pos + pixelCount * 3)
+    {
+        std::cerr << "Truncated PPM: " << path << std::endl;
+        return false;
+    }
+
+    rgba.resize(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        rgba[i * 4 + 0] = data[pos + i * 3 + 0];
+        rgba[i * 4 + 1] = data[pos + i * 3 + 1];
+        rgba[i * 4 + 2] = data[pos + i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+    return true;
+}
+
+ImageDiff CompareImages(const unsigned char* a, const unsigned char* b, int width, int height, int channelTolerance)
+{
+    ImageDiff diff;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    uint64_t total = 0;
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        int pixelMax = 0;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            int difference = std::abs(static_cast<int>(a[i * 4 + channel]) - static_cast<int>(b[i * 4 + channel]));
+            pixelMax = std::max(pixelMax, difference);
+            total += static_cast<uint64_t>(difference);
+        }
+        diff.maxChannelDifference = std::max(diff.maxChannelDifference, pixelMax);
+        if (pixelMax > channelTolerance)
+            ++diff.mismatchedPixels;
+    }
+    diff.meanChannelDifference = pixelCount ? static_cast<double>(total) / (pixelCount * 3) : 0.0;
+    return diff;
+}
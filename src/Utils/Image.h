@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Helpers for RGBA8 images stored top row first (as the software renderer and the headless
+// readback produce them). Files are binary PPM, which drops alpha.
+
+bool WritePPM(const std::string& path, const unsigned char* rgba, int width, int height);
+
+// Reads a binary (P6, 8-bit) PPM; alpha is set to 255
+bool ReadPPM(const std::string& path, std::vector<unsigned char>& rgba, int& width, int& height);
+
+struct ImageDiff {
+    uint64_t mismatchedPixels = 0; // Pixels with any RGB channel off by more than the tolerance
+    int maxChannelDifference = 0;
+    double meanChannelDifference = 0.0;
+};
+
+// Compares the RGB channels of two images of the same size
+ImageDiff CompareImages(const unsigned char* a, const unsigned char* b, int width, int height, int channelTolerance);
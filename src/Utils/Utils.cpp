@@ -10,4 +10,16 @@ std::vector<unsigned int> GenerateIndices(const float* vertices)
         indices.push_back(i);
     }
     return indices;
-}
\ No newline at end of file
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull; // FNV prime
+    }
+    return hash;
+}
@@ -1,5 +1,10 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 std::vector<unsigned int> GenerateIndices(const float* vertices);
+
+// 64-bit FNV-1a hash, used to key on-disk caches. Pass a previous result as seed to chain buffers.
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
@@ -4,6 +4,13 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <fstream>
 
 // --- External Library Includes ---
 #include <glad/glad.h>
@@ -15,15 +22,35 @@
 
 // --- Project Includes ---
 #include "Graphics/Shader.h"
-#include "Graphics/Camera.h"
+#include "Graphics/ShaderCache.h"
+#include "Graphics/ShaderVariants.h"
+#include "Graphics/GpuTimer.h"
+#include "Graphics/camera.h"
 #include "Game/Maze.h"
+#include "Game/MazePVS.h"
+#include "Game/MazeText.h"
+#include "Game/MazeImage.h"
 #include "Graphics/Mesh.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/Texture.h"
+#include "Graphics/TextureLoader.h"
+#include "Graphics/MaterialLibrary.h"
+#include "Graphics/MazeMesh.h"
+#include "Graphics/PulledMaze.h"
+#include "Graphics/Minimap.h"
+#include "Graphics/Light.h"
+#include "Graphics/LightBaker.h"
+#include "Graphics/ShadowMap.h"
+#include "Graphics/DynamicResolution.h"
+#include "Graphics/SoftwareRaycaster.h"
+#include "Graphics/RenderRegression.h"
+#include "Graphics/FlythroughBenchmark.h"
 #include "Game/Player.h"
 #include "Game/GameLogic.h"
 #include "Graphics/GLUtils.h"
+#include "Graphics/GLStateCache.h"
 #include "Utils/Utils.h"
+#include "Utils/Image.h"
 
 // --- Global State (grouped in a namespace for clarity) ---
 namespace Globals {
@@ -108,11 +135,232 @@ void processInput(GLFWwindow *window)
     }
 }
 
+// Yaw that looks from a cell down its first open side (a view along a corridor)
+float openSideYaw(const Maze& maze, const glm::ivec2& cell)
+{
+    const Cell& c = maze.GetCell(cell.x, cell.y);
+    return !c.wallRight ? 0.0f : !c.wallBottom ? 90.0f : !c.wallLeft ? 180.0f : -90.0f;
+}
+
+// Renders the start view on the CPU, without creating a window or GL context: a turn on the
+// spot is timed, and the first frame is written to software_render.ppm
+int runSoftwareRender(unsigned int seed)
+{
+    const int width = 640, height = 360, frames = 360;
+    Maze maze(5, 5, seed);
+    maze.GenerateMaze(0, 0);
+
+    SoftwareRaycaster::Settings settings;
+    settings.wallHeight = wallHeight;
+    settings.wallThickness = wallThickness;
+    SoftwareRaycaster raycaster(settings);
+    raycaster.LoadTextures("textures/wall.jpg", "textures/floor.jpg", "textures/ceiling.jpg");
+    raycaster.SetLighting(glm::normalize(glm::vec3(0.5f, -1.0f, 0.7f)), glm::vec3(1.0f, 1.0f, 0.9f), 0.3f);
+    raycaster.SetMaze(maze);
+    raycaster.Resize(width, height);
+
+    // Eye height and start cell as in GameLogic::Reset, looking down the first open side
+    glm::ivec2 start = maze.GetStartCellCoords();
+    Camera view(glm::vec3(start.x + 0.5f, 1.0f, start.y + 0.5f));
+    const float startYaw = openSideYaw(maze, start);
+
+    std::vector<unsigned char> firstFrame;
+    for (int i = 0; i < frames; ++i)
+    {
+        view.Yaw = startYaw + 360.0f * i / frames;
+        raycaster.Render(view);
+        if (i == 0)
+            firstFrame.assign(raycaster.GetPixels(), raycaster.GetPixels() + static_cast<size_t>(width) * height * 4);
+    }
+
+    const SoftwareRaycaster::Stats& stats = raycaster.GetStats();
+    double averageMs = stats.totalMs / stats.frames;
+    std::cout << "Software render: " << width << "x" << height << " on " << raycaster.GetThreadCount() << " threads, "
+              << averageMs << " ms per frame (" << (averageMs > 0.0 ? 1000.0 / averageMs : 0.0) << " fps)" << std::endl;
+
+    if (!WritePPM("software_render.ppm", firstFrame.data(), width, height))
+        return -1;
+    std::cout << "Wrote software_render.ppm" << std::endl;
+    return 0;
+}
+
+// Generates a maze (seeded, --maze-size cells square) without a window, writes it as text and
+// reads it back, reporting both throughputs
+int runMazeExport(const std::string& path, int size, unsigned int seed, MazeTextStyle style)
+{
+    Maze maze(size, size, seed);
+    maze.GenerateMaze(0, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!SaveMazeText(maze, path, style))
+        return -1;
+    double writeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::ifstream written(path, std::ios::binary | std::ios::ate);
+    const double megabytes = static_cast<double>(written.tellg()) / (1024.0 * 1024.0);
+    std::cout << "Wrote " << path << ": " << megabytes << " MB in " << writeMs << " ms ("
+              << (writeMs > 0.0 ? megabytes * 1000.0 / writeMs : 0.0) << " MB/s)" << std::endl;
+
+    // Read back to check the round trip
+    start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<Maze> loaded = LoadMazeText(path);
+    double readMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (!loaded || loaded->BuildWallMask() != maze.BuildWallMask())
+    {
+        std::cerr << "Reading " << path << " back did not reproduce the maze" << std::endl;
+        return -1;
+    }
+    std::cout << "Read it back in " << readMs << " ms (" << (readMs > 0.0 ? megabytes * 1000.0 / readMs : 0.0) << " MB/s)" << std::endl;
+    return 0;
+}
+
+// Generates a maze without a window and writes it as an image (PNG, or PPM by extension)
+int runMazeImageExport(const std::string& path, int size, unsigned int seed, const MazeImageSettings& settings)
+{
+    Maze maze(size, size, seed);
+    maze.GenerateMaze(0, 0);
+
+    MazeImageStats stats;
+    if (!SaveMazeImage(maze, path, settings, &stats))
+        return -1;
+    std::cout << "Wrote " << path << ": " << stats.width << "x" << stats.height << " pixels, "
+              << stats.bytes / (1024.0 * 1024.0) << " MB in " << stats.ms << " ms ("
+              << stats.MegapixelsPerSecond() << " megapixels/s)" << std::endl;
+    return 0;
+}
+
 // --- Main Function ---
-int main()
+// Options:
+//   --no-texture-cache   decode source images every launch (for comparing startup time)
+//   --compress-textures  cook textures block-compressed (BC1/BC3)
+//   --no-shader-cache    compile shaders from source instead of loading cached program binaries
+//   --gpu-timing         measure GPU time per shader variant and print it on exit
+//   --pulled-maze        generate the maze in the vertex shader from a wall texture (one draw, no PVS)
+//   --baked-lighting     bake the torches and ambient occlusion into a light volume at startup
+//   --no-shadows         turn off the (cached) directional light shadow map
+//   --dynamic-resolution scale the 3D view's resolution to hold a GPU frame time budget
+//   --target-frame-ms X  GPU budget for --dynamic-resolution (default 12)
+//   --min-scale X        lowest resolution scale per axis (default 0.5)
+//   --max-scale X        highest resolution scale per axis (default 1)
+//   --software-render    render and time the start view on the CPU, without a window, and exit
+//   --seed N             generate the same maze every run (0, the default, seeds from the clock)
+//   --maze-size N        maze width and height in cells (default 5)
+//   --maze-file FILE     play a maze loaded from text (as written by --export-maze) instead
+//   --print-maze         print the maze to the console at startup
+//   --export-maze FILE   write the generated maze as text, read it back, report the speed and exit
+//   --unicode-maze       export with box-drawing characters instead of ASCII
+//   --export-image FILE  write the generated maze as a PNG (or .ppm) image with its solution,
+//                        report megapixels per second and exit
+//   --cell-pixels N      image pixels per cell (default 4)
+//   --wall-pixels N      image pixels per wall (default 1)
+//   --no-solution        leave the solution path out of the image
+//   --headless           render fixed views offscreen (EGL, no window), compare them against
+//                        golden images, check the draw/state counters (reporting submit time), and exit
+//   --headless-osmesa    the same on an OSMesa context
+//   --golden-dir DIR     where golden images and baselines live (default "golden")
+//   --update-golden      re-record the golden images and baselines (missing ones fail otherwise)
+//   --benchmark-frames N timed frames per headless view (default 100)
+//   --flythrough         fly the camera along the solution of a seeded maze with vsync off,
+//                        report frame/CPU/GPU time percentiles and draw calls, and exit
+//   --flythrough-out FILE where the flythrough's JSON report goes (default "flythrough.json")
+int main(int argc, char** argv)
 {
+    bool useTextureCache = true;
+    bool compressTextures = false;
+    bool useShaderCache = true;
+    bool gpuTiming = false;
+    bool pulledMazeMode = false;
+    bool bakedLighting = false;
+    bool shadows = true;
+    bool dynamicResolutionMode = false;
+    bool softwareRender = false;
+    unsigned int seed = 0;
+    int mazeSize = 5;
+    std::string mazeFile;
+    bool printMaze = false;
+    std::string exportMazePath;
+    MazeTextStyle mazeTextStyle = MazeTextStyle::Ascii;
+    std::string exportImagePath;
+    MazeImageSettings mazeImageSettings;
+    ContextMode contextMode = ContextMode::Window;
+    RenderRegression::Settings regressionSettings;
+    bool flythrough = false;
+    FlythroughBenchmark::Settings flythroughSettings;
+    DynamicResolution::Settings dynamicResolutionSettings;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-texture-cache") useTextureCache = false;
+        else if (arg == "--compress-textures") compressTextures = true;
+        else if (arg == "--no-shader-cache") useShaderCache = false;
+        else if (arg == "--gpu-timing") gpuTiming = true;
+        else if (arg == "--pulled-maze") pulledMazeMode = true;
+        else if (arg == "--baked-lighting") bakedLighting = true;
+        else if (arg == "--no-shadows") shadows = false;
+        else if (arg == "--dynamic-resolution") dynamicResolutionMode = true;
+        else if (arg == "--software-render") softwareRender = true;
+        else if (arg == "--seed" && i + 1 < argc) seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--maze-size" && i + 1 < argc) mazeSize = std::atoi(argv[++i]);
+        else if (arg == "--maze-file" && i + 1 < argc) mazeFile = argv[++i];
+        else if (arg == "--print-maze") printMaze = true;
+        else if (arg == "--export-maze" && i + 1 < argc) exportMazePath = argv[++i];
+        else if (arg == "--unicode-maze") mazeTextStyle = MazeTextStyle::Unicode;
+        else if (arg == "--export-image" && i + 1 < argc) exportImagePath = argv[++i];
+        else if (arg == "--cell-pixels" && i + 1 < argc) mazeImageSettings.cellPixels = std::atoi(argv[++i]);
+        else if (arg == "--wall-pixels" && i + 1 < argc) mazeImageSettings.wallPixels = std::atoi(argv[++i]);
+        else if (arg == "--no-solution") mazeImageSettings.solution = false;
+        else if (arg == "--headless") contextMode = ContextMode::OffscreenEGL;
+        else if (arg == "--headless-osmesa") contextMode = ContextMode::OffscreenOSMesa;
+        else if (arg == "--golden-dir" && i + 1 < argc) regressionSettings.goldenDirectory = argv[++i];
+        else if (arg == "--update-golden") regressionSettings.update = true;
+        else if (arg == "--benchmark-frames" && i + 1 < argc) regressionSettings.timedFrames = std::atoi(argv[++i]);
+        else if (arg == "--flythrough") flythrough = true;
+        else if (arg == "--flythrough-out" && i + 1 < argc) flythroughSettings.outputPath = argv[++i];
+        else if (arg == "--target-frame-ms" && i + 1 < argc) dynamicResolutionSettings.targetMs = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--min-scale" && i + 1 < argc) dynamicResolutionSettings.minScale = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--max-scale" && i + 1 < argc) dynamicResolutionSettings.maxScale = static_cast<float>(std::atof(argv[++i]));
+        else std::cerr << "Unknown option: " << arg << std::endl;
+    }
+
+    // No GPU needed
+    if (softwareRender)
+        return runSoftwareRender(seed);
+    if (!exportMazePath.empty())
+        return runMazeExport(exportMazePath, mazeSize, seed, mazeTextStyle);
+    if (!exportImagePath.empty())
+        return runMazeImageExport(exportImagePath, mazeSize, seed, mazeImageSettings);
+
+    // Loaded before the window opens, so a bad file fails fast
+    std::unique_ptr<Maze> loadedMaze;
+    if (!mazeFile.empty())
+    {
+        loadedMaze = LoadMazeText(mazeFile);
+        if (!loadedMaze)
+            return -1;
+    }
+
+    // Headless runs must be reproducible: fixed maze, size and timing-independent frames
+    const bool headless = contextMode != ContextMode::Window;
+    if (headless)
+    {
+        if (seed == 0)
+            seed = 1;
+        SCR_WIDTH = 640;
+        SCR_HEIGHT = 360;
+        if (dynamicResolutionMode)
+            std::cout << "--dynamic-resolution is ignored in headless mode (its scale depends on timing)" << std::endl;
+        dynamicResolutionMode = false;
+        if (flythrough)
+            std::cout << "--flythrough is ignored in headless mode" << std::endl;
+        flythrough = false;
+    }
+    // The flythrough needs the same maze every run to be comparable
+    if (flythrough && seed == 0)
+        seed = 1;
+    flythroughSettings.seed = seed;
+    flythroughSettings.mazeFile = mazeFile;
+
     // --- Initialization ---
-    GLFWwindow *window = InitializeWindow(Globals::SCR_WIDTH, Globals::SCR_HEIGHT, "Maze Escape");
+    GLFWwindow *window = InitializeWindow(Globals::SCR_WIDTH, Globals::SCR_HEIGHT, "Maze Escape", contextMode);
     if (!window){
         
     system("pause");
@@ -128,11 +376,33 @@ int main()
     Renderer renderer;
 
     // Create and generate maze
-    int mazeGridW = 5; // For clarity with maze size vs world units
-    int mazeGridH = 5;
-    Maze gameMaze(mazeGridW, mazeGridH);
-    gameMaze.GenerateMaze(0, 0);
-    gameMaze.PrintToConsole();
+    int mazeGridW = loadedMaze ? loadedMaze->GetWidth() : mazeSize; // For clarity with maze size vs world units
+    int mazeGridH = loadedMaze ? loadedMaze->GetHeight() : mazeSize;
+    Maze gameMaze(mazeGridW, mazeGridH, seed);
+    if (loadedMaze)
+        gameMaze = std::move(*loadedMaze);
+    else
+        gameMaze.GenerateMaze(0, 0);
+    // Off by default: it gives the layout away, and large mazes take a while to print
+    if (printMaze)
+        gameMaze.PrintToConsole();
+
+    // Potentially visible set for wall culling. A loaded maze keeps its cache next to the file;
+    // a generated one is cached in the working directory under its seed and size, unless it is
+    // seeded from the clock and would never be generated again.
+    std::string pvsPath;
+    if (!mazeFile.empty())
+        pvsPath = MazePVS::CachePathFor(mazeFile);
+    else if (seed != 0)
+        pvsPath = MazePVS::CachePathFor("maze_" + std::to_string(seed) + "_" + std::to_string(mazeGridW) + "x" +
+                                        std::to_string(mazeGridH));
+    MazePVS mazePVS;
+    if (pvsPath.empty() || !mazePVS.LoadFromFile(pvsPath, gameMaze))
+    {
+        mazePVS.Bake(gameMaze);
+        if (!pvsPath.empty())
+            mazePVS.SaveToFile(pvsPath);
+    }
 
     // Set global maze pointer for input processing
     g_Maze = &gameMaze;
@@ -153,94 +423,158 @@ int main()
     gameLogic.Reset();
 
     // Print instructions
-    std::cout << "Press P to view the maze with your current position." << std::endl;
+    std::cout << "Press P to switch between the minimap and the maze overview." << std::endl;
     std::cout << "Press R to restart the game after reaching the exit." << std::endl;
 
     // --- Shaders (Construct directly) ---
-    Shader wallShader("shaders/wall.vert", "shaders/wall.frag");
-    if (wallShader.ID == 0)
-    {
-        /* error handling */
-        std::cerr << "Failed to load wall shader." << std::endl;
-    system("pause");
-        return -1;
-    }
-
-    Shader floorShader("shaders/floor.vert", "shaders/floor.frag");
-    if (floorShader.ID == 0)
-    {
-        /* error handling */
-        std::cerr << "Failed to load floor shader." << std::endl;
-    system("pause");
-        return -1;
-    }
+    // Programs come from the binary cache when possible. Otherwise they compile in the background
+    // until first use, so create them all up front and use them as late as possible.
+    ShaderCache::SetEnabled(useShaderCache);
+    // Maze surfaces use specialised variants of one shader, picked per draw from the
+    // material's features; they are created once the maze mesh knows which ones it needs
+    ShaderVariants mazeShaders("maze", "shaders/maze.vert", "shaders/maze.frag");
 
     Shader skyboxShader("shaders/skybox.vert", "shaders/skybox.frag"); // New Skybox Shader
-    if (skyboxShader.ID == 0)
-    {
-        /* error handling */
-        std::cerr << "Failed to load skybox shader." << std::endl;
-    system("pause");
-        return -1;
-    }
 
     // --- Load Textures ---
-    std::unique_ptr<Texture> wallTexture = std::make_unique<Texture>("textures/wall.jpg");
-    std::unique_ptr<Texture> floorTexture = std::make_unique<Texture>("textures/floor.jpg");
-    std::unique_ptr<Texture> ceilingTexture = std::make_unique<Texture>("textures/ceiling.jpg");
-    std::unique_ptr<Texture> exitTexture = std::make_unique<Texture>("textures/exit.jpg");
+    // Textures start as grey placeholders and are filled in by textureLoader.Update() as the
+    // worker threads finish decoding, so the window shows up without waiting on image files
+    TextureLoader textureLoader;
+    textureLoader.SetUseCache(useTextureCache);
+    textureLoader.SetCompression(compressTextures);
+
+    // Maze surface materials share one texture array
+    float materialShininess = 32.0f;
+    float materialSpecularStrength = 0.4f; // For walls and floor
+    MaterialLibrary materials;
+    MazeMesh::Layers mazeLayers;
+    mazeLayers.wall = materials.Add({ "wall", "textures/wall.jpg", materialShininess, materialSpecularStrength });
+    mazeLayers.floor = materials.Add({ "floor", "textures/floor.jpg", materialShininess, materialSpecularStrength * 0.5f }); // Floor less shiny
+    mazeLayers.ceiling = materials.Add({ "ceiling", "textures/ceiling.jpg", materialShininess, 0.0f, false, true });
+    mazeLayers.exit = materials.Add({ "exit", "textures/exit.jpg", materialShininess, 0.0f, true });
+    materials.Load(textureLoader);
     
     std::vector<std::string> faces {
         "textures/skybox/right.png", "textures/skybox/left.png",
         "textures/skybox/top.png",   "textures/skybox/bottom.png",
         "textures/skybox/front.png", "textures/skybox/back.png"
     };
-    unsigned int cubemapTextureID = LoadCubemap(faces);
-    if (cubemapTextureID == 0) { std::cerr << "Failed to load cubemap texture." << std::endl; return -1; }
-
-
-
-    // Cube vertices for walls with proper texture coordinates for each face
-    std::vector<Vertex> cubeVerticesData = {
-        // Back face
-        {{-0.5f, -0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}}, // Bottom-left
-        {{0.5f, -0.5f, -0.5f}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},  // Bottom-right
-        {{0.5f, 0.5f, -0.5f}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f}},   // Top-right
-        {{-0.5f, 0.5f, -0.5f}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}},  // Top-left
-
-        // Front face
-        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}, // Bottom-left
-        {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},  // Bottom-right
-        {{0.5f, 0.5f, 0.5f}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},   // Top-right
-        {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},  // Top-left
-
-        // Left face
-        {{-0.5f, 0.5f, 0.5f}, {1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}},   // Top-right
-        {{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}},  // Top-left
-        {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}}, // Bottom-left
-        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}},  // Bottom-right
-
-        // Right face
-        {{0.5f, 0.5f, 0.5f}, {0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},   // Top-left
-        {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},  // Top-right
-        {{0.5f, -0.5f, -0.5f}, {1.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}, // Bottom-right
-        {{0.5f, -0.5f, 0.5f}, {0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}},  // Bottom-left
-
-        // Bottom face
-        {{-0.5f, -0.5f, -0.5f}, {0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}}, // Top-left
-        {{0.5f, -0.5f, -0.5f}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},  // Top-right
-        {{0.5f, -0.5f, 0.5f}, {1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},   // Bottom-right
-        {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},  // Bottom-left
-
-        // Top face
-        {{-0.5f, 0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}}, // Bottom-left
-        {{0.5f, 0.5f, -0.5f}, {1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},  // Bottom-right
-        {{0.5f, 0.5f, 0.5f}, {1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}},   // Top-right
-        {{-0.5f, 0.5f, 0.5f}, {0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}}   // Top-left
+    Texture* cubemapTexture = textureLoader.LoadCubemap(faces);
+
+
+
+    // --- Maze Geometry ---
+    // Floor, ceiling and walls merged into chunk meshes, one draw per chunk and shader variant
+    MazeMesh::Settings mazeMeshSettings;
+    mazeMeshSettings.wallHeight = wallHeight;
+    mazeMeshSettings.wallThickness = wallThickness;
+    mazeMeshSettings.buildChunks = !pulledMazeMode;
+    GeometryPool geometryPool; // Shared vertex/index buffers for the chunk meshes
+    MazeMesh mazeMesh;
+    mazeMesh.Build(gameMaze, mazeLayers, materials, mazeMeshSettings, &geometryPool);
+    const GpuBufferArena::Stats& vertexPoolStats = geometryPool.GetVertexArena().GetStats();
+    const GpuBufferArena::Stats& indexPoolStats = geometryPool.GetIndexArena().GetStats();
+    std::cout << "Geometry pool: " << vertexPoolStats.allocations << " meshes in " << vertexPoolStats.pages + indexPoolStats.pages
+              << " buffers and " << geometryPool.GetVertexArrayCount() << " VAOs, "
+              << (vertexPoolStats.usedBytes + indexPoolStats.usedBytes) / 1024.0 << " KB used" << std::endl;
+    std::vector<int> visibleChunks;
+
+    // --- Point Lights ---
+    // Torches on the walls of some cells and a glow over the exit, shaded with clustered
+    // forward lighting: the POINT_LIGHTS variants only loop over the lights of their cluster
+    LightSystem lights;
+    LightSystem::Settings lightSettings;
+    lightSettings.height = wallHeight;
+    lights.Build(gameMaze.GetWidth(), gameMaze.GetHeight(), lightSettings);
+    const std::vector<unsigned char> torchWalls = gameMaze.BuildWallMask();
+    for (int y = 0; y < gameMaze.GetHeight(); ++y)
+    {
+        for (int x = 0; x < gameMaze.GetWidth(); ++x)
+        {
+            // Roughly every third cell, picked by a hash so the layout is stable
+            unsigned int hash = (static_cast<unsigned int>(x) * 73856093u) ^ (static_cast<unsigned int>(y) * 19349663u);
+            unsigned char bits = torchWalls[static_cast<size_t>(y) * gameMaze.GetWidth() + x];
+            if (hash % 3 != 0 || bits == 0)
+                continue;
+            // Hang it just off a wall the cell has
+            glm::vec3 position(x + 0.5f, wallHeight * 0.75f, y + 0.5f);
+            if (bits & WALL_TOP) position.z = y + 0.15f;
+            else if (bits & WALL_LEFT) position.x = x + 0.15f;
+            else if (bits & WALL_BOTTOM) position.z = y + 0.85f;
+            else position.x = x + 0.85f;
+            lights.Add({ position, 2.5f, glm::vec3(1.0f, 0.6f, 0.25f), 1.2f, 0.125f });
+        }
+    }
+    glm::ivec2 exitCell = gameMaze.GetEndCellCoords();
+    lights.Add({ glm::vec3(exitCell.x + 0.5f, 0.5f, exitCell.y + 0.5f), 3.0f, glm::vec3(0.3f, 1.0f, 0.4f), 1.5f });
+    lights.Update();
+    std::cout << "Lights: " << lights.GetLightCount() << " point lights, " << lights.GetStats().clusterEntries
+              << " cluster entries (at most " << lights.GetStats().maxClusterLights << " per cluster), binned in "
+              << lights.GetStats().binMs << " ms" << std::endl;
+
+    // Baked: the lights are frozen into a volume once, and the cheaper BAKED_LIGHTING variants
+    // replace both the per-fragment light loop and the specular term
+    LightBaker lightBaker;
+    if (bakedLighting)
+    {
+        LightBaker::Settings bakeSettings;
+        bakeSettings.wallHeight = wallHeight;
+        bakeSettings.wallThickness = wallThickness;
+        if (!lightBaker.Bake(gameMaze, lights.GetLights(), bakeSettings))
+        {
+            std::cout << "Falling back to per-fragment point lights" << std::endl;
+            bakedLighting = false;
+        }
+    }
+
+    // Unlit surfaces ignore lights, so they keep their variant
+    uint32_t lightFeatures = lights.GetLightCount() > 0 ? static_cast<uint32_t>(ShaderFeature::PointLights) : static_cast<uint32_t>(0);
+    if (bakedLighting)
+        lightFeatures = ShaderFeature::BakedLighting;
+
+    // Directional light shadows from a cached map: the static maze is drawn into it once,
+    // only the exit marker is redrawn per frame. The pulled maze has no meshes to cast with.
+    shadows = shadows && !pulledMazeMode;
+    ShadowMap shadowMap;
+    ShaderVariants shadowShaders("shadow", "shaders/shadow_depth.vert", "shaders/shadow_depth.frag");
+    if (shadows)
+    {
+        lightFeatures |= ShaderFeature::Shadows;
+        shadowShaders.Get(0);
+        shadowShaders.Get(ShaderFeature::Instanced);
+    }
+    auto litFeatures = [lightFeatures, bakedLighting](uint32_t features) {
+        if (features & ShaderFeature::Unlit)
+            return features;
+        if (bakedLighting)
+            features &= ~ShaderFeature::Specular;
+        return features | lightFeatures;
     };
 
-    float skyboxVertices[] = {
-    // positions
+    // Vertex-pulling alternative: walls, floor and ceiling from a one-byte-per-cell texture
+    PulledMaze pulledMaze;
+    ShaderVariants pulledMazeShaders("maze_pulled", "shaders/maze_pulled.vert", "shaders/maze.frag");
+    const uint32_t pulledMazeFeatures = litFeatures(ShaderFeature::Specular); // Materials without a highlight have zero strength
+    if (pulledMazeMode)
+    {
+        PulledMaze::Settings pulledMazeSettings;
+        pulledMazeSettings.wallHeight = wallHeight;
+        pulledMazeSettings.wallThickness = wallThickness;
+        pulledMaze.Build(gameMaze, mazeLayers, pulledMazeSettings);
+        pulledMazeShaders.Get(pulledMazeFeatures);
+    }
+
+    // Minimap: the maze as a one-byte-per-cell texture, drawn in one screen-space pass
+    Minimap minimap;
+    minimap.Build(gameMaze, Minimap::Settings());
+    Shader minimapShader("shaders/minimap.vert", "shaders/minimap.frag");
+
+    // Start compiling every variant the maze needs (in parallel where the driver allows)
+    for (uint32_t features : mazeMesh.GetUsedFeatures())
+        mazeShaders.Get(litFeatures(features));
+
+    // Skybox cube (positions only; skybox.vert uses them as cubemap directions)
+    const float skyboxVertices[] = {
     -1.0f,  1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f, -1.0f, -1.0f,
      1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, -1.0f,  1.0f, -1.0f,
 
@@ -259,68 +593,271 @@ int main()
     -1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, -1.0f,
      1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f
 };
+    std::vector<Vertex> skyboxVerticesData;
+    for (size_t i = 0; i < sizeof(skyboxVertices) / sizeof(float); i += 3)
+    {
+        skyboxVerticesData.push_back({{skyboxVertices[i], skyboxVertices[i + 1], skyboxVertices[i + 2]}, {0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+    }
+    // Non-indexed, so the renderer can queue it like any other mesh
+    std::unique_ptr<Mesh> skyboxMesh = std::make_unique<Mesh>(skyboxVerticesData, std::vector<unsigned int>());
 
 
-    // Now we have 24 vertices (4 for each face) with proper texture coordinates
-    // Update indices to match the new vertex layout
-    std::vector<unsigned int> cubeIndicesData = {
-        0, 1, 2, 2, 3, 0,       // Back face
-        4, 5, 6, 6, 7, 4,       // Front face
-        8, 9, 10, 10, 11, 8,    // Left face
-        12, 13, 14, 14, 15, 12, // Right face
-        16, 17, 18, 18, 19, 16, // Bottom face
-        20, 21, 22, 22, 23, 20  // Top face
-    };
-    // For walls, we probably only need position. Let's adjust Mesh setup if wall shader doesn't use texCoords.
-    // For now, the Mesh class expects Vertex struct with TexCoords.
-    // If wall.vert only uses aPos (location 0), the TexCoords data won't be used but must be provided for stride.
-
-    std::unique_ptr<Mesh> cubeMesh = std::make_unique<Mesh>(cubeVerticesData, cubeIndicesData);
-
-    // --- Define Vertices for Plane (Floor/Ceiling) ---
-    std::vector<Vertex> planeVerticesData = {
-        {{0.5f, 0.0f, 0.5f}, {(float)mazeGridW, (float)mazeGridH}, {0.0f, 1.0f, 0.0f}}, // Top Right
-        {{0.5f, 0.0f, -0.5f}, {(float)mazeGridW, 0.0f}, {0.0f, 1.0f, 0.0f}},            // Bottom Right
-        {{-0.5f, 0.0f, -0.5f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},                       // Bottom Left
-        {{-0.5f, 0.0f, 0.5f}, {0.0f, (float)mazeGridH}, {0.0f, 1.0f, 0.0f}}             // Top Left
-    };
-    std::vector<unsigned int> planeIndicesData = {0, 1, 3, 1, 2, 3};
-    std::unique_ptr<Mesh> planeMesh = std::make_unique<Mesh>(planeVerticesData, planeIndicesData);
-
-    // Create exit marker mesh (a simple colored cube)
-    std::vector<Vertex> exitMarkerVerticesData = cubeVerticesData;     // Use same vertices as cube
-    std::vector<unsigned int> exitMarkerIndicesData = cubeIndicesData; // Use same indices as cube
-    std::unique_ptr<Mesh> exitMarkerMesh = std::make_unique<Mesh>(exitMarkerVerticesData, exitMarkerIndicesData);
+    // Light properties
+    glm::vec3 lightDir = glm::normalize(glm::vec3(0.5f, -1.0f, 0.7f)); // Direction FROM light source
+    glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 0.9f);                // Slightly yellowish white
+    float ambientIntensity = 0.3f;
 
-    // Create exit marker shader
-    Shader exitMarkerShader("shaders/exit.vert", "shaders/exit.frag");
-    if (exitMarkerShader.ID == 0)
+    // Lighting lives in a shared uniform block; it is static, so it is uploaded once
+    renderer.SetLighting(lightDir, lightColor, ambientIntensity);
+    // Same for the shadow map: it is rendered on the first frame and then reused until the
+    // camera moves its region
+    shadowMap.Setup(glm::vec3(0.0f), glm::vec3((float)gameMaze.GetWidth(), wallHeight, (float)gameMaze.GetHeight()), lightDir);
+    renderer.SetShadowSpace(shadowMap.GetShadowMatrix());
+
+    // The programs above were only started; their compile and link results are collected here
+    // (waiting for the driver if needed), which is where a broken shader shows up
+    const char* failedShader = nullptr;
+    if (!skyboxShader.IsLinked()) failedShader = "skybox";
+    else if (!minimapShader.IsLinked()) failedShader = "minimap";
+    else if (!mazeShaders.IsLinked()) failedShader = "maze";
+    else if (!shadowShaders.IsLinked()) failedShader = "shadow";
+    else if (!pulledMazeShaders.IsLinked()) failedShader = "pulled maze";
+    if (failedShader)
     {
-        std::cerr << "Failed to load exit marker shader." << std::endl;
+        std::cerr << "Failed to load " << failedShader << " shader." << std::endl;
     system("pause");
         return -1;
     }
 
-    
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0); // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
+    // Per-program constants are set once instead of every frame
+    mazeShaders.SetInitializer([&materials, &lights, &lightBaker, &shadowMap, &mazeMesh](Shader& shader) {
+        materials.Apply(shader);  // Sampler unit and material table
+        lights.Apply(shader);     // Light buffer units and cluster grid (ignored without POINT_LIGHTS)
+        lightBaker.Apply(shader); // Volume units and mapping (ignored without BAKED_LIGHTING)
+        shadowMap.Apply(shader);  // Shadow map unit and light matrix (ignored without SHADOWS)
+        mazeMesh.Apply(shader);   // Wall mask unit and grid (ignored without IMPOSTOR)
+    });
+    pulledMazeShaders.SetInitializer([&materials, &pulledMaze, &lights, &lightBaker, &shadowMap](Shader& shader) {
+        materials.Apply(shader);
+        pulledMaze.Apply(shader); // Maze size, wall dimensions and layers
+        lights.Apply(shader);
+        lightBaker.Apply(shader);
+        shadowMap.Apply(shader);
+    });
+
+    skyboxShader.use();
+    skyboxShader.setInt("skybox", 0);
+
+    GpuTimer gpuTimer;
+    if (gpuTiming)
+    {
+        renderer.SetGpuTimer(&gpuTimer);
+    }
 
+    std::unique_ptr<DynamicResolution> dynamicResolution;
+    if (dynamicResolutionMode)
+    {
+        dynamicResolution = std::make_unique<DynamicResolution>(dynamicResolutionSettings);
+        renderer.SetDynamicResolution(dynamicResolution.get());
+    }
 
-    // Light properties
-    glm::vec3 lightDir = glm::normalize(glm::vec3(0.5f, -1.0f, 0.7f)); // Direction FROM light source
-    glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 0.9f);                // Slightly yellowish white
-    float ambientIntensity = 0.3f;
-    float materialShininess = 32.0f;
-    float materialSpecularStrength = 0.4f; // For walls and floor
+    // Draws one frame from the current camera; time drives the torch flicker
+    auto renderFrame = [&](float time)
+    {
+        // Torches flicker in the shader; the light buffers only upload when lights are added or moved
+        renderer.SetLightingTime(time);
+        lights.Update();
+
+        // --- Shadows ---
+        // The static maze (the chunks the map's region can see) only when the cached map is
+        // invalid, e.g. after the region followed the camera; the exit marker every frame,
+        // restoring and redrawing just the part of the map it covers. Ceilings don't cast:
+        // they would shade the whole maze.
+        if (shadows)
+        {
+            if (shadowMap.Focus(camera.Position))
+                renderer.SetShadowSpace(shadowMap.GetShadowMatrix());
+            Shader& depthShader = shadowShaders.Get(0);
+            if (shadowMap.BeginStatic(depthShader))
+            {
+                for (const MazeMesh::Chunk& chunk : mazeMesh.GetChunks())
+                {
+                    if (!shadowMap.Overlaps(glm::vec3((float)chunk.minX, 0.0f, (float)chunk.minY),
+                                            glm::vec3(chunk.maxX + 1.0f, wallHeight, chunk.maxY + 1.0f)))
+                        continue;
+                    for (const MazeMesh::Surface& surface : chunk.lods[MazeMesh::LOD_FULL])
+                    {
+                        if (!(surface.features & ShaderFeature::Ceiling))
+                            shadowMap.DrawCaster(depthShader, *surface.mesh);
+                    }
+                }
+                shadowMap.EndStatic();
+            }
+            Shader& instancedDepthShader = shadowShaders.Get(ShaderFeature::Instanced);
+            glm::vec3 markerMin, markerMax;
+            mazeMesh.GetExitMarkerBounds(markerMin, markerMax);
+            shadowMap.BeginDynamic(instancedDepthShader, markerMin, markerMax);
+            shadowMap.DrawCaster(instancedDepthShader, *mazeMesh.GetExitMarker());
+            shadowMap.EndDynamic();
+        }
+
+        // --- Begin Scene (uploads camera matrices to the shared Camera block) ---
+        renderer.Clear();
+        renderer.BeginScene(camera, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+
+        // --- Record Scene ---
+        // Submit only records commands; EndScene sorts them by pass/shader/texture/mesh/depth
+        // and draws, so submission order no longer matters.
+        // --- Record Maze ---
+        // Only chunks containing cells in the camera cell's PVS are drawn. Above the walls (or
+        // outside the maze) everything can be visible, so the lookup is skipped there.
+        int cameraCellX = static_cast<int>(std::floor(camera.Position.x));
+        int cameraCellY = static_cast<int>(std::floor(camera.Position.z));
+        // (The pulled maze has no chunks to cull.)
+        bool usePVS = !pulledMazeMode && mazePVS.IsReady() && camera.Position.y < wallHeight &&
+                      cameraCellX >= 0 && cameraCellX < gameMaze.GetWidth() &&
+                      cameraCellY >= 0 && cameraCellY < gameMaze.GetHeight();
+        const std::vector<MazeMesh::Chunk>& mazeChunks = mazeMesh.GetChunks();
+        if (usePVS)
+        {
+            mazeMesh.CollectVisibleChunks(mazePVS, cameraCellX, cameraCellY, visibleChunks);
+        }
+        else
+        {
+            visibleChunks.resize(mazeChunks.size());
+            for (size_t i = 0; i < mazeChunks.size(); ++i) visibleChunks[i] = static_cast<int>(i);
+        }
+        // Distant chunks switch to their simplified levels of detail
+        mazeMesh.UpdateLods(camera.Position);
+
+        const TextureArray* materialTextures = materials.GetTextureArray();
+        if (bakedLighting)
+            lightBaker.Bind();
+        else
+            lights.Bind();
+        if (shadows)
+            shadowMap.Bind();
+        if (pulledMazeMode)
+        {
+            // The whole maze in one draw; the wall texture sits on its own unit
+            pulledMaze.BindWallTexture();
+            renderer.Submit(pulledMazeShaders.Get(pulledMazeFeatures), pulledMaze.GetMesh(), glm::mat4(1.0f),
+                            GL_TEXTURE_2D_ARRAY, materialTextures->ID);
+        }
+        // Chunk meshes are in world space: their bounds centres give the front-to-back order.
+        // Far chunks march through the wall mask, which sits on its own unit.
+        if (!visibleChunks.empty())
+            mazeMesh.BindWallMask();
+        for (int chunkIndex : visibleChunks)
+        {
+            const MazeMesh::Chunk& chunk = mazeChunks[chunkIndex];
+            for (const MazeMesh::Surface& surface : chunk.lods[mazeMesh.GetChunkLod(chunkIndex)])
+            {
+                renderer.Submit(mazeShaders.Get(litFeatures(surface.features)), *surface.mesh, glm::mat4(1.0f),
+                                GL_TEXTURE_2D_ARRAY, materialTextures->ID, chunk.center);
+            }
+        }
+        // Positioned by its instance transform, so the model matrix is unused
+        glm::vec3 exitMarkerMin, exitMarkerMax;
+        mazeMesh.GetExitMarkerBounds(exitMarkerMin, exitMarkerMax);
+        renderer.Submit(mazeShaders.Get(mazeMesh.GetExitMarkerFeatures()), *mazeMesh.GetExitMarker(), glm::mat4(1.0f),
+                        GL_TEXTURE_2D_ARRAY, materialTextures->ID, (exitMarkerMin + exitMarkerMax) * 0.5f);
+
+        // Skybox last: the skybox pass only fills pixels left uncovered by the maze
+        renderer.Submit(skyboxShader, *skyboxMesh, glm::mat4(1.0f), cubemapTexture, RenderPass::Skybox);
+
+        // Map on top of everything; explores the cells visible from the player's position
+        minimap.Update(camera.Position, camera.Front);
+        minimap.Apply(minimapShader, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        renderer.Submit(minimapShader, minimap.GetMesh(), minimap.GetTransform((float)SCR_WIDTH, (float)SCR_HEIGHT),
+                        GL_TEXTURE_2D, minimap.GetTexture(), RenderPass::Overlay);
+
+        // Display game state
+        if (gameLogic.GetState() == GameState::WON)
+        {
+            // In a real game, you would render text or a UI element here
+            // For now, we just print to the console (already done in GameLogic::CheckWinCondition)
+            // You could add a 2D overlay with text or a simple colored quad
+        }
+
+        renderer.EndScene();
+    };
+
+    // --- Headless render checks ---
+    // Fixed views of the seeded maze, each rendered offscreen, compared and timed
+    if (headless)
+    {
+        // Every texture must be in, so the images don't depend on load timing
+        while (!textureLoader.IsIdle())
+        {
+            textureLoader.Update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        struct View {
+            const char* name;
+            glm::vec3 position;
+            float yaw;
+            float pitch;
+        };
+        const glm::ivec2 startCell = gameMaze.GetStartCellCoords();
+        const glm::ivec2 endCell = gameMaze.GetEndCellCoords();
+        // The exit marker, seen from the neighbouring cell
+        const float exitSide = glm::radians(openSideYaw(gameMaze, endCell));
+        const glm::vec3 exitViewPosition(endCell.x + 0.5f + std::cos(exitSide), 1.0f, endCell.y + 0.5f + std::sin(exitSide));
+        const View views[] = {
+            { "start", glm::vec3(startCell.x + 0.5f, 1.0f, startCell.y + 0.5f), openSideYaw(gameMaze, startCell), 0.0f },
+            { "exit", exitViewPosition, openSideYaw(gameMaze, endCell) + 180.0f, -10.0f },
+            // From above the walls: no PVS culling, every chunk is drawn
+            { "overview", glm::vec3(mazeGridW * 0.5f, (float)std::max(mazeGridW, mazeGridH) * 1.5f, mazeGridH * 0.5f), -90.0f, -89.0f },
+        };
+
+        RenderRegression regression((int)SCR_WIDTH, (int)SCR_HEIGHT, regressionSettings);
+        for (const View& view : views)
+        {
+            camera.Position = view.position;
+            camera.Yaw = view.yaw;
+            camera.Pitch = view.pitch;
+            camera.UpdateCameraVectors();
+            regression.RunScene(view.name, renderer, [&]() { renderFrame(0.0f); });
+        }
+
+        int failures = regression.GetFailureCount();
+        std::cout << (failures == 0 ? "Headless checks passed" : "Headless checks FAILED") << " (" << failures << " of "
+                  << (sizeof(views) / sizeof(views[0])) << " views regressed)" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return failures == 0 ? 0 : 1;
+    }
+
+    // --- Flythrough benchmark ---
+    // The camera follows the maze's solution instead of the player; frames are uncapped
+    if (flythrough)
+    {
+        // Loading textures mid-run would show up as spikes
+        while (!textureLoader.IsIdle())
+        {
+            textureLoader.Update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        glfwSwapInterval(0); // Vsync would round every frame up to the refresh interval
+
+        FlythroughBenchmark benchmark(gameMaze, flythroughSettings);
+        while (!glfwWindowShouldClose(window) && benchmark.BeginFrame(camera))
+        {
+            renderFrame(benchmark.GetFrameTime());
+            benchmark.EndFrame(renderer.GetStats());
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        bool reported = benchmark.Finish((int)SCR_WIDTH, (int)SCR_HEIGHT);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return reported ? 0 : 1;
+    }
 
     // --- Game Loop ---
+    bool shaderStartupReported = false;
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = static_cast<float>(glfwGetTime());
@@ -333,15 +870,12 @@ int main()
         player.Update(deltaTime, gameMaze);
         gameLogic.Update(deltaTime);
 
-        // Print maze with player position when P key is pressed (with debounce)
+        // Switch between the corner minimap and the full maze overview when P is pressed (with debounce)
         if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
         {
             if (!pKeyPressed)
             {
-                // Clear console (Windows-specific)
-                system("cls");
-                // Print maze with player position
-                gameMaze.PrintToConsole(player.GetCurrentCell());
+                minimap.ToggleMode();
                 pKeyPressed = true;
             }
         }
@@ -350,129 +884,65 @@ int main()
             pKeyPressed = false;
         }
 
-        // --- Prepare View and Projection Matrices ---
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-        // --- Render Skybox ---
-        RenderSkybox(skyboxShader, skyboxVAO, cubemapTextureID, view, projection);
+        // Upload any textures the loader threads finished decoding (bounded per frame)
+        textureLoader.Update();
 
-        // --- Render Scene ---
-        renderer.BeginScene(camera, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        renderFrame(currentFrame);
 
-        floorShader.use();                       // Activate shader before setting uniforms
-        renderer.SetShaderMatrices(floorShader); // Set view and projection matrices
-
-        // Set texture for floor
-        floorTexture->Bind(0);                   // Bind to texture unit 0
-        floorShader.setInt("floorTexture", 0);   // Tell shader to use texture unit 0
-        floorShader.setBool("isCeiling", false); // This is the floor
-
-        // Set lighting uniforms for floorShader
-        floorShader.setVec3("light_direction", lightDir);
-        floorShader.setVec3("light_color", lightColor);
-        floorShader.setFloat("light_ambientIntensity", ambientIntensity);
-        floorShader.setVec3("viewPos", camera.Position);
-        floorShader.setFloat("material_shininess", materialShininess);                      // Could be different for floor
-        floorShader.setFloat("material_specularStrength", materialSpecularStrength * 0.5f); // Floor less shiny
-
-        glm::mat4 floorModel = glm::mat4(1.0f);
-        floorModel = glm::translate(floorModel, glm::vec3((float)(mazeGridW - 1) / 2.0f, 0.0f, (float)(mazeGridH - 1) / 2.0f));
-        floorModel = glm::scale(floorModel, glm::vec3((float)mazeGridW, 1.0f, (float)mazeGridH));
-        renderer.Submit(floorShader, *planeMesh, floorModel);
-
-        // Set texture for ceiling (can use a different texture or the same with a modifier)
-        ceilingTexture->Bind(0);                // Bind to texture unit 0
-        floorShader.setInt("floorTexture", 0);  // Tell shader to use texture unit 0
-        floorShader.setBool("isCeiling", true); // This is the ceiling
-
-        glm::mat4 ceilingModel = glm::mat4(1.0f);
-        ceilingModel = glm::translate(ceilingModel, glm::vec3((float)(mazeGridW - 1) / 2.0f, wallHeight, (float)(mazeGridH - 1) / 2.0f));
-        ceilingModel = glm::scale(ceilingModel, glm::vec3((float)mazeGridW, 1.0f, (float)mazeGridH));
-        renderer.Submit(floorShader, *planeMesh, ceilingModel); // Submit takes shader, mesh, model
-
-        // --- Render Maze Walls ---
-        wallShader.use();
-        renderer.SetShaderMatrices(wallShader); // Set view and projection matrices
-
-        // Set texture for walls
-        wallTexture->Bind(0);                // Bind to texture unit 0
-        wallShader.setInt("wallTexture", 0); // Tell shader to use texture unit 0
-
-        // Set lighting uniforms for wallShader
-        wallShader.setVec3("light_direction", lightDir);
-        wallShader.setVec3("light_color", lightColor);
-        wallShader.setFloat("light_ambientIntensity", ambientIntensity);
-        wallShader.setVec3("viewPos", camera.Position);
-        wallShader.setFloat("material_shininess", materialShininess);
-        wallShader.setFloat("material_specularStrength", materialSpecularStrength);
-
-        for (int y = 0; y < gameMaze.GetHeight(); ++y)
+        // Every program has been used once by now, so all compile/link work is accounted for
+        if (!shaderStartupReported)
         {
-            for (int x = 0; x < gameMaze.GetWidth(); ++x)
-            {
-                const Cell &cell = gameMaze.GetCell(x, y);
-                glm::vec3 cellOrigin = glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(y));
-
-                if (cell.wallTop)
-                {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    model = glm::translate(model, cellOrigin + glm::vec3(0.5f, wallHeight / 2.0f, 0.0f));
-                    model = glm::scale(model, glm::vec3(1.0f, wallHeight, wallThickness));
-                    renderer.Submit(wallShader, *cubeMesh, model);
-                }
-                if (cell.wallBottom)
-                {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    model = glm::translate(model, cellOrigin + glm::vec3(0.5f, wallHeight / 2.0f, 1.0f));
-                    model = glm::scale(model, glm::vec3(1.0f, wallHeight, wallThickness));
-                    renderer.Submit(wallShader, *cubeMesh, model);
-                }
-                if (cell.wallLeft)
-                {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    model = glm::translate(model, cellOrigin + glm::vec3(0.0f, wallHeight / 2.0f, 0.5f));
-                    model = glm::scale(model, glm::vec3(wallThickness, wallHeight, 1.0f));
-                    renderer.Submit(wallShader, *cubeMesh, model);
-                }
-                if (cell.wallRight)
-                {
-                    glm::mat4 model = glm::mat4(1.0f);
-                    model = glm::translate(model, cellOrigin + glm::vec3(1.0f, wallHeight / 2.0f, 0.5f));
-                    model = glm::scale(model, glm::vec3(wallThickness, wallHeight, 1.0f));
-                    renderer.Submit(wallShader, *cubeMesh, model);
-                }
-            }
+            const ShaderCache::Stats& shaderStats = ShaderCache::GetStats();
+            std::cout << "Shader startup: " << shaderStats.createMs + shaderStats.finalizeMs << " ms ("
+                      << shaderStats.createMs << " ms creating, " << shaderStats.finalizeMs << " ms waiting on first use; "
+                      << shaderStats.binaryHits << " from binary cache, " << shaderStats.compiled << " compiled)" << std::endl;
+            shaderStartupReported = true;
         }
 
-        // Render exit marker
-        exitMarkerShader.use();
-        renderer.SetShaderMatrices(exitMarkerShader);
-        exitTexture->Bind(0);
-        exitMarkerShader.setInt("exitTexture", 0);
-        glm::ivec2 exitCoords = gameMaze.GetEndCellCoords();
-        if (exitCoords.x >= 0 && exitCoords.y >= 0)
-        {
-            glm::vec3 exitPosition = glm::vec3(exitCoords.x + 0.5f, 0.5f, exitCoords.y + 0.5f);
-            glm::mat4 exitModel = glm::mat4(1.0f);
-            exitModel = glm::translate(exitModel, exitPosition);
-            exitModel = glm::scale(exitModel, glm::vec3(0.3f, 0.3f, 0.3f));
-            exitMarkerShader.setVec3("color", glm::vec3(1.0f, 1.0f, 1.0f)); // No tint
-            renderer.Submit(exitMarkerShader, *exitMarkerMesh, exitModel);
-        }
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
 
-        // Display game state
-        if (gameLogic.GetState() == GameState::WON)
-        {
-            // In a real game, you would render text or a UI element here
-            // For now, we just print to the console (already done in GameLogic::CheckWinCondition)
-            // You could add a 2D overlay with text or a simple colored quad
-        }
+    // Report how many redundant state changes the cache filtered out
+    const GLStateCache::Stats& glStats = GLStateCache::GetStats();
+    uint64_t totalStateCalls = glStats.issued + glStats.skipped;
+    std::cout << "GL state cache: " << glStats.issued << " calls issued, " << glStats.skipped << " skipped";
+    if (totalStateCalls > 0)
+        std::cout << " (" << (100.0 * glStats.skipped / totalStateCalls) << "% saved)";
+    std::cout << std::endl;
+
+    // Frames where the streaming ring had to wait for the GPU (should stay near zero)
+    const StreamBuffer::Stats& streamStats = renderer.GetFrameData().GetStats();
+    std::cout << "Frame data stream (" << (renderer.GetFrameData().IsPersistent() ? "persistent" : "mapped per frame")
+              << "): " << streamStats.fenceWaits << " fence waits in " << streamStats.frames << " frames, peak "
+              << streamStats.peakFrameBytes << " bytes per frame" << std::endl;
+
+    // The static shadow map should have been rendered once; dynamic passes touch few texels
+    if (shadows)
+    {
+        const ShadowMap::Stats& shadowStats = shadowMap.GetStats();
+        std::cout << "Shadow map: " << shadowStats.staticRenders << " static renders, " << shadowStats.dynamicRenders
+                  << " dynamic passes averaging " << (shadowStats.dynamicRenders ? shadowStats.dynamicTexels / shadowStats.dynamicRenders : 0)
+                  << " texels restored" << std::endl;
+    }
 
-        renderer.EndScene();
+    // Where the controller settled: a scale pinned at the minimum means the budget is out of reach
+    if (dynamicResolution && dynamicResolution->GetStats().frames > 0)
+    {
+        const DynamicResolution::Stats& resolutionStats = dynamicResolution->GetStats();
+        std::cout << "Dynamic resolution: average scale " << (resolutionStats.scaleTotal / resolutionStats.frames)
+                  << ", average scene GPU time " << (resolutionStats.samples ? resolutionStats.gpuMsTotal / resolutionStats.samples : 0.0)
+                  << " ms (target " << dynamicResolution->GetSettings().targetMs << " ms), "
+                  << resolutionStats.framesAtMinimum << " of " << resolutionStats.frames << " frames at the minimum scale" << std::endl;
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (gpuTiming && gpuTimer.GetCollectedFrames() > 0)
+    {
+        std::cout << "GPU time per frame by shader (" << gpuTimer.GetCollectedFrames() << " frames):" << std::endl;
+        for (const GpuTimer::Section& section : gpuTimer.GetSections())
+        {
+            std::cout << "  " << section.label << ": " << gpuTimer.GetAverageMs(section) << " ms" << std::endl;
+        }
     }
 
     glfwDestroyWindow(window);